@@ -0,0 +1,96 @@
+//----------------------------------------------------------------------
+// FILE: convert_bench.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Microbenchmark of the number conversions behind TOSTR, WRITE,
+// TOINT, and TODBL. Formats and parses N ints and N doubles (10M by
+// default) with the vm's helpers and with the std::to_string, stoi,
+// and stod calls they replaced, and reports the time of each.
+//----------------------------------------------------------------------
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "vm_instr.h"
+
+using namespace std;
+
+// keeps the results live so the loops are not optimized away
+uint64_t checksum = 0;
+
+void report(const string &name, int n, const function<void()> &f)
+{
+  auto start = chrono::steady_clock::now();
+  f();
+  auto end = chrono::steady_clock::now();
+  double ms = chrono::duration<double, milli>(end - start).count();
+  cout << left << setw(24) << name << right << fixed << setprecision(3)
+       << setw(12) << ms << " ms" << setw(10) << setprecision(1)
+       << ms * 1e6 / n << " ns/op" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+  int n = argc > 1 ? max(1, atoi(argv[1])) : 10000000;
+
+  // a spread of magnitudes and signs (doubles with fractions)
+  vector<int> ints(n);
+  vector<double> doubles(n);
+  uint64_t seed = 42;
+  for (int i = 0; i < n; ++i)
+  {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    ints[i] = (int)(seed >> 33) >> (seed % 24);
+    doubles[i] = ints[i] / 64.0;
+  }
+
+  vector<string> int_strs(n), double_strs(n);
+  char buf[NUMBER_CHARS];
+  report("format int", n, [&]() {
+    for (int i = 0; i < n; ++i)
+      checksum += format_number(ints[i], buf).size();
+  });
+  report("std::to_string int", n, [&]() {
+    for (int i = 0; i < n; ++i)
+      checksum += to_string(ints[i]).size();
+  });
+  report("format double", n, [&]() {
+    for (int i = 0; i < n; ++i)
+      checksum += format_number(doubles[i], buf).size();
+  });
+  report("std::to_string double", n, [&]() {
+    for (int i = 0; i < n; ++i)
+      checksum += to_string(doubles[i]).size();
+  });
+
+  for (int i = 0; i < n; ++i)
+  {
+    int_strs[i] = to_string(ints[i]);
+    double_strs[i] = to_string(doubles[i]);
+  }
+  report("parse int", n, [&]() {
+    int x;
+    for (int i = 0; i < n; ++i)
+      checksum += parse_int(int_strs[i], x) ? x : 0;
+  });
+  report("stoi", n, [&]() {
+    for (int i = 0; i < n; ++i)
+      checksum += stoi(int_strs[i]);
+  });
+  report("parse double", n, [&]() {
+    double x;
+    for (int i = 0; i < n; ++i)
+      checksum += parse_double(double_strs[i], x) ? (int64_t)x : 0;
+  });
+  report("stod", n, [&]() {
+    for (int i = 0; i < n; ++i)
+      checksum += (int64_t)stod(double_strs[i]);
+  });
+  cout << "checksum " << checksum << endl;
+  return 0;
+}
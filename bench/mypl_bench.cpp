@@ -0,0 +1,322 @@
+//----------------------------------------------------------------------
+// FILE: mypl_bench.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Benchmark harness for the interpreter. Runs each benchmark
+// program through the pipeline and reports, per phase (lex, parse,
+// check, codegen, run), the wall time, the allocations made, and the
+// peak resident set size, plus the instructions executed and the
+// hardware counters of the run (where perf_event_open is allowed).
+// Results are printed as a table and can be saved as json to compare
+// commits.
+//----------------------------------------------------------------------
+
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "alloc_hook.h"
+#include "mypl_exception.h"
+#include "lexer.h"
+#include "ast_parser.h"
+#include "semantic_checker.h"
+#include "inliner.h"
+#include "code_generator.h"
+#include "vm.h"
+#include "perf_counters.h"
+
+using namespace std;
+
+#ifndef MYPL_BENCH_DIR
+#define MYPL_BENCH_DIR "bench/programs"
+#endif
+
+//----------------------------------------------------------------------
+// Measurements
+//----------------------------------------------------------------------
+
+struct PhaseResult
+{
+  string phase;
+  double ms = 0;
+  uint64_t allocations = 0;
+  uint64_t allocated_bytes = 0;
+  long peak_rss_kb = 0;
+};
+
+struct BenchResult
+{
+  string name;
+  uint64_t tokens = 0;
+  uint64_t instructions = 0;
+  vector<PhaseResult> phases;
+  vector<PerfCounters::Reading> counters;
+};
+
+long peak_rss_kb()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+PhaseResult measure(const string &phase, const function<void()> &f)
+{
+  PhaseResult result{phase};
+  AllocCounts start_counts = alloc_counts();
+  auto start = chrono::steady_clock::now();
+  f();
+  auto end = chrono::steady_clock::now();
+  AllocCounts end_counts = alloc_counts();
+  result.ms = chrono::duration<double, milli>(end - start).count();
+  result.allocations = end_counts.allocations - start_counts.allocations;
+  result.allocated_bytes = end_counts.bytes - start_counts.bytes;
+  result.peak_rss_kb = peak_rss_kb();
+  return result;
+}
+
+// discards everything written to it (the programs' output)
+class NullBuffer : public streambuf
+{
+protected:
+  int overflow(int c) { return c; }
+  streamsize xsputn(const char *, streamsize n) { return n; }
+};
+
+BenchResult run_pipeline(const string &name, const string &src, PerfCounters &counters)
+{
+  BenchResult result{name};
+  Program p;
+  VM vm;
+  result.phases.push_back(measure("lex", [&]() {
+    stringstream in(src);
+    Lexer lexer(in);
+    while (lexer.next_token().type() != TokenType::EOS)
+      ++result.tokens;
+  }));
+  // the parser pulls its tokens from the lexer, so this includes lexing
+  result.phases.push_back(measure("parse", [&]() {
+    stringstream in(src);
+    p = ASTParser(Lexer(in)).parse();
+  }));
+  result.phases.push_back(measure("check", [&]() {
+    SemanticChecker checker;
+    p.accept(checker);
+  }));
+  // the same optimizations as the mypl default
+  result.phases.push_back(measure("codegen", [&]() {
+    CodeGenerator generator(vm);
+    Inliner inliner;
+    p.accept(inliner);
+    generator.enable_inlining(inliner.candidates());
+    generator.enable_loop_hoisting();
+    p.accept(generator);
+  }));
+  result.phases.push_back(measure("run", [&]() {
+    NullBuffer null_buffer;
+    streambuf *out = cout.rdbuf(&null_buffer);
+    try
+    {
+      counters.start();
+      vm.run();
+      counters.stop();
+    }
+    catch (...)
+    {
+      cout.rdbuf(out);
+      throw;
+    }
+    cout.rdbuf(out);
+  }));
+  result.instructions = vm.instructions_executed();
+  result.counters = counters.readings();
+  return result;
+}
+
+// keeps the fastest time of each phase over the repetitions
+BenchResult run_benchmark(const string &name, const string &src, int repeat, PerfCounters &counters)
+{
+  BenchResult best = run_pipeline(name, src, counters);
+  for (int i = 1; i < repeat; ++i)
+  {
+    BenchResult next = run_pipeline(name, src, counters);
+    for (int j = 0; j < best.phases.size(); ++j)
+      best.phases[j].ms = min(best.phases[j].ms, next.phases[j].ms);
+  }
+  return best;
+}
+
+//----------------------------------------------------------------------
+// Generated programs
+//----------------------------------------------------------------------
+
+// a large source (many small functions) to time the front end
+string generated_source(int functions)
+{
+  string src = "";
+  for (int i = 0; i < functions; ++i)
+  {
+    string n = to_string(i);
+    src += "int f" + n + "(int x) {\n";
+    src += "  int y = x * " + n + "\n";
+    src += "  if (y > 1000) {\n    y = y - 1000\n  }\n";
+    src += "  elseif (y < 0) {\n    y = 0 - y\n  }\n";
+    src += "  return y / 2\n";
+    src += "}\n";
+  }
+  src += "void main() {\n  int total = 0\n";
+  for (int i = 0; i < functions; ++i)
+    src += "  total = total + f" + to_string(i) + "(" + to_string(i) + ")\n";
+  src += "  print(total)\n}\n";
+  return src;
+}
+
+//----------------------------------------------------------------------
+// Reporting
+//----------------------------------------------------------------------
+
+void print_table(const vector<BenchResult> &results)
+{
+  cout << left << setw(14) << "benchmark" << setw(9) << "phase" << right
+       << setw(12) << "ms" << setw(12) << "allocs" << setw(14) << "bytes"
+       << setw(12) << "peak kb" << endl;
+  for (const BenchResult &result : results)
+  {
+    for (const PhaseResult &phase : result.phases)
+    {
+      cout << left << setw(14) << result.name << setw(9) << phase.phase
+           << right << fixed << setprecision(3) << setw(12) << phase.ms
+           << setw(12) << phase.allocations << setw(14) << phase.allocated_bytes
+           << setw(12) << phase.peak_rss_kb << endl;
+    }
+    cout << left << setw(14) << result.name << result.tokens << " tokens, "
+         << result.instructions << " instructions" << endl;
+    for (const PerfCounters::Reading &reading : result.counters)
+      if (reading.available)
+        cout << left << setw(14) << result.name << reading.name << " "
+             << reading.value << endl;
+  }
+}
+
+void write_json(ostream &out, const vector<BenchResult> &results, int repeat)
+{
+  out << "{\n  \"version\": 1,\n  \"repeat\": " << repeat << ",\n";
+  out << "  \"benchmarks\": [";
+  for (int i = 0; i < results.size(); ++i)
+  {
+    const BenchResult &result = results[i];
+    out << (i ? ",\n" : "\n") << "    {\"name\": \"" << result.name
+        << "\", \"tokens\": " << result.tokens << ", \"instructions\": "
+        << result.instructions << ", \"counters\": {";
+    for (int j = 0; j < result.counters.size(); ++j)
+    {
+      const PerfCounters::Reading &reading = result.counters[j];
+      out << (j ? ", " : "") << "\"" << reading.name << "\": ";
+      if (reading.available)
+        out << reading.value;
+      else
+        out << "null";
+    }
+    out << "}, \"phases\": [";
+    for (int j = 0; j < result.phases.size(); ++j)
+    {
+      const PhaseResult &phase = result.phases[j];
+      out << (j ? ",\n" : "\n") << "      {\"phase\": \"" << phase.phase
+          << "\", \"ms\": " << fixed << setprecision(3) << phase.ms
+          << ", \"allocations\": " << phase.allocations
+          << ", \"allocated_bytes\": " << phase.allocated_bytes
+          << ", \"peak_rss_kb\": " << phase.peak_rss_kb << "}";
+    }
+    out << "\n    ]}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+void usage()
+{
+  cout << "Usage: ./mypl_bench [--repeat N] [--json file] [benchmark.mypl ...]" << endl;
+  cout << "Runs the given programs (default: " << MYPL_BENCH_DIR << "/*.mypl and a" << endl;
+  cout << "generated source) and reports each phase's time, allocations, and peak RSS" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+  int repeat = 1;
+  string json_file = "";
+  vector<string> files;
+  for (int i = 1; i < argc; ++i)
+  {
+    string arg = argv[i];
+    if (arg == "--repeat" and i + 1 < argc)
+      repeat = max(1, atoi(argv[++i]));
+    else if (arg == "--json" and i + 1 < argc)
+      json_file = argv[++i];
+    else if (arg.starts_with("--"))
+    {
+      usage();
+      return arg == "--help" ? 0 : 1;
+    }
+    else
+      files.push_back(arg);
+  }
+
+  set_alloc_hook(count_allocation);
+  bool defaults = files.empty();
+  if (defaults)
+  {
+    for (const auto &entry : filesystem::directory_iterator(MYPL_BENCH_DIR))
+      if (entry.path().extension() == ".mypl")
+        files.push_back(entry.path().string());
+    sort(files.begin(), files.end());
+  }
+
+  PerfCounters counters;
+  if (!counters.available())
+    cerr << "[Bench] hardware counters unavailable, reporting without them" << endl;
+  vector<BenchResult> results;
+  try
+  {
+    for (const string &file : files)
+    {
+      ifstream in(file);
+      if (in.fail())
+      {
+        cerr << "ERROR: Could not read file " << file << endl;
+        return 1;
+      }
+      stringstream src;
+      src << in.rdbuf();
+      string name = filesystem::path(file).stem().string();
+      results.push_back(run_benchmark(name, src.str(), repeat, counters));
+    }
+    if (defaults)
+      results.push_back(run_benchmark("generated", generated_source(2000), repeat, counters));
+  }
+  catch (MyPLException &ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+
+  print_table(results);
+  if (json_file != "")
+  {
+    ofstream out(json_file);
+    write_json(out, results, repeat);
+    if (out.fail())
+    {
+      cerr << "ERROR: Could not write " << json_file << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,54 @@
+//----------------------------------------------------------------------
+// FILE: alloc_hook.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Replacement operator new reporting to the allocation hook
+//----------------------------------------------------------------------
+
+#include <cstdlib>
+#include <new>
+#include "alloc_hook.h"
+
+using namespace std;
+
+static AllocHook alloc_hook = nullptr;
+static AllocCounts counts;
+
+AllocHook set_alloc_hook(AllocHook hook)
+{
+  AllocHook old = alloc_hook;
+  alloc_hook = hook;
+  return old;
+}
+
+void count_allocation(size_t size)
+{
+  ++counts.allocations;
+  counts.bytes += size;
+}
+
+AllocCounts alloc_counts()
+{
+  return counts;
+}
+
+// the array and nothrow forms call these by default
+
+void *operator new(size_t size)
+{
+  if (alloc_hook)
+    alloc_hook(size);
+  if (void *p = malloc(size ? size : 1))
+    return p;
+  throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  free(p);
+}
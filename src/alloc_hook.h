@@ -0,0 +1,32 @@
+//----------------------------------------------------------------------
+// FILE: alloc_hook.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Pluggable allocation hook. Programs that link alloc_hook.cpp
+// get a replacement global operator new that reports the size of each
+// allocation to the installed hook (if any). count_allocation is a
+// ready-made hook that totals the allocations.
+//----------------------------------------------------------------------
+
+#ifndef ALLOC_HOOK_H
+#define ALLOC_HOOK_H
+
+#include <cstddef>
+#include <cstdint>
+
+using AllocHook = void (*)(std::size_t size);
+
+// install the hook (nullptr to remove it), returning the previous one
+AllocHook set_alloc_hook(AllocHook hook);
+
+// allocations seen by count_allocation
+struct AllocCounts
+{
+  std::uint64_t allocations = 0;
+  std::uint64_t bytes = 0;
+};
+
+void count_allocation(std::size_t size);
+AllocCounts alloc_counts();
+
+#endif
@@ -108,6 +108,10 @@ public:
   bool is_array = false;
   std::string type_name;
   bool is_const = false;
+  // map types are named "map <key type> <value type>"
+  bool is_map() const { return !is_array and type_name.starts_with("map "); }
+  std::string key_type() const { return type_name.substr(4, type_name.find(' ', 4) - 4); }
+  std::string value_type() const { return type_name.substr(type_name.find(' ', 4) + 1); }
 };
 
 class VarDef
@@ -192,6 +192,11 @@ void ASTParser::data_type(DataType &d)
     d.type_name = curr_token.lexeme();
     advance();
   }
+  else if (match(TokenType::MAP))
+  {
+    d.is_array = false;
+    d.type_name = map_type();
+  }
   else if (match(TokenType::ARRAY))
   {
     d.is_array = true;
@@ -215,6 +220,21 @@ void ASTParser::data_type(DataType &d)
   }
 }
 
+// Reads a map type (a base key type and a base or struct value type),
+// returning its name
+string ASTParser::map_type()
+{
+  eat(TokenType::MAP, "Expecting MAP");
+  string key_type = curr_token.lexeme();
+  base_type();
+  string value_type = curr_token.lexeme();
+  if (match(TokenType::ID))
+    advance();
+  else
+    base_type();
+  return "map " + key_type + " " + value_type;
+}
+
 // Advance if its a base_type otherwise error
 void ASTParser::base_type()
 {
@@ -231,7 +251,7 @@ void ASTParser::base_type()
 // We pass in a vector of statements
 void ASTParser::stmt(std::vector<std::shared_ptr<Stmt>> &s)
 {
-  if (match(TokenType::DOUBLE_TYPE) || match(TokenType::INT_TYPE) || match(TokenType::STRING_TYPE) || match(TokenType::CHAR_TYPE) || match(TokenType::BOOL_TYPE) || match(TokenType::ARRAY) || match(TokenType::CONST))
+  if (match(TokenType::DOUBLE_TYPE) || match(TokenType::INT_TYPE) || match(TokenType::STRING_TYPE) || match(TokenType::CHAR_TYPE) || match(TokenType::BOOL_TYPE) || match(TokenType::ARRAY) || match(TokenType::MAP) || match(TokenType::CONST))
   {
     // if the token is a type, we make a vardecl statement and push it to the vector
     VarDeclStmt v;
@@ -573,7 +593,13 @@ void ASTParser::rvalue(std::shared_ptr<RValue> &r)
 void ASTParser::new_rvalue(NewRValue &n)
 {
   eat(TokenType::NEW, "Expecting NEW");
-  if (match(TokenType::ID))
+  if (match(TokenType::MAP))
+  {
+    // the type token of a new map carries the whole map type name
+    Token map = curr_token;
+    n.type = Token(TokenType::MAP, map_type(), map.line(), map.column());
+  }
+  else if (match(TokenType::ID))
   {
     n.type = curr_token;
     advance();
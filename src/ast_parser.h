@@ -40,6 +40,7 @@ private:
   void fields(StructDef &s);
   void params(FunDef &f);
   void data_type(DataType &d);
+  std::string map_type();
   void base_type();
   void stmt(std::vector<std::shared_ptr<Stmt>> &s);
   void vdecl_stmt(VarDeclStmt &v);
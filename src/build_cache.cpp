@@ -0,0 +1,585 @@
+//----------------------------------------------------------------------
+// FILE: build_cache.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Function-granularity build cache implementation
+//----------------------------------------------------------------------
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <set>
+#include <unordered_set>
+#include "build_cache.h"
+#include "code_generator.h"
+#include "inliner.h"
+#include "semantic_checker.h"
+
+using namespace std;
+
+// bump whenever the cache layout or the generated code changes so
+// that stale caches are discarded instead of reused
+const string CACHE_HEADER = "MYPL-CACHE 11";
+
+//----------------------------------------------------------------------
+// Fingerprinting
+//----------------------------------------------------------------------
+
+// 64-bit FNV-1a, used since it is stable across runs and compilers
+class Hasher
+{
+public:
+  void mix(const string &s)
+  {
+    for (unsigned char c : s)
+    {
+      hash ^= c;
+      hash *= 1099511628211ULL;
+    }
+    // separator so that "ab" + "c" and "a" + "bc" differ
+    hash ^= 0xff;
+    hash *= 1099511628211ULL;
+  }
+  void mix(uint64_t value) { mix(to_string(value)); }
+  uint64_t value() const { return hash; }
+
+private:
+  uint64_t hash = 14695981039346656037ULL;
+};
+
+// Walks a function or struct definition hashing each of its tokens,
+// and records the functions it calls and the type names it uses
+class FingerprintVisitor : public Visitor
+{
+public:
+  Hasher hasher;
+  set<string> calls;
+  set<string> types;
+
+  void visit(Program &p)
+  {
+    for (auto &s : p.struct_defs)
+      s.accept(*this);
+    for (auto &f : p.fun_defs)
+      f.accept(*this);
+  }
+
+  void visit(FunDef &f)
+  {
+    data_type(f.return_type);
+    token(f.fun_name);
+    for (auto &param : f.params)
+      var_def(param);
+    stmts(f.stmts);
+  }
+
+  void visit(StructDef &s)
+  {
+    token(s.struct_name);
+    for (auto &field : s.fields)
+      var_def(field);
+  }
+
+  void visit(ReturnStmt &s)
+  {
+    hasher.mix("return");
+    s.expr.accept(*this);
+  }
+
+  void visit(WhileStmt &s)
+  {
+    hasher.mix("while");
+    s.condition.accept(*this);
+    stmts(s.stmts);
+  }
+
+  void visit(ForStmt &s)
+  {
+    hasher.mix("for");
+    s.var_decl.accept(*this);
+    s.condition.accept(*this);
+    s.assign_stmt.accept(*this);
+    stmts(s.stmts);
+  }
+
+  void visit(IfStmt &s)
+  {
+    hasher.mix("if");
+    s.if_part.condition.accept(*this);
+    stmts(s.if_part.stmts);
+    for (auto &else_if : s.else_ifs)
+    {
+      hasher.mix("elseif");
+      else_if.condition.accept(*this);
+      stmts(else_if.stmts);
+    }
+    hasher.mix("else");
+    stmts(s.else_stmts);
+  }
+
+  void visit(VarDeclStmt &s)
+  {
+    hasher.mix("decl");
+    var_def(s.var_def);
+    s.expr.accept(*this);
+  }
+
+  void visit(AssignStmt &s)
+  {
+    hasher.mix("assign");
+    path(s.lvalue);
+    s.expr.accept(*this);
+  }
+
+  void visit(CallExpr &e)
+  {
+    hasher.mix("call");
+    token(e.fun_name);
+    calls.insert(e.fun_name.lexeme());
+    for (auto &arg : e.args)
+      arg.accept(*this);
+    hasher.mix(")");
+  }
+
+  void visit(Expr &e)
+  {
+    hasher.mix(e.negated ? "(not" : "(");
+    e.first->accept(*this);
+    if (e.op.has_value())
+    {
+      token(e.op.value());
+      e.rest->accept(*this);
+    }
+    hasher.mix(")");
+  }
+
+  void visit(SimpleTerm &t) { t.rvalue->accept(*this); }
+
+  void visit(ComplexTerm &t) { t.expr.accept(*this); }
+
+  void visit(SimpleRValue &v) { token(v.value); }
+
+  void visit(NewRValue &v)
+  {
+    hasher.mix("new");
+    token(v.type);
+    types.insert(v.type.lexeme());
+    if (v.array_expr.has_value())
+      v.array_expr->accept(*this);
+    for (auto &value : v.const_array)
+      value.accept(*this);
+  }
+
+  void visit(VarRValue &v) { path(v.path); }
+
+private:
+  void token(const Token &t)
+  {
+    hasher.mix(to_string(static_cast<int>(t.type())));
+    hasher.mix(t.lexeme());
+  }
+
+  void data_type(const DataType &d)
+  {
+    hasher.mix(string(d.is_const ? "const " : "") +
+               (d.is_array ? "array " : "") + d.type_name);
+    types.insert(d.type_name);
+  }
+
+  void var_def(VarDef &v)
+  {
+    data_type(v.data_type);
+    token(v.var_name);
+  }
+
+  void stmts(vector<shared_ptr<Stmt>> &body)
+  {
+    hasher.mix("{");
+    for (auto &s : body)
+      s->accept(*this);
+    hasher.mix("}");
+  }
+
+  void path(vector<VarRef> &refs)
+  {
+    for (auto &ref : refs)
+    {
+      token(ref.var_name);
+      if (ref.array_expr.has_value())
+        ref.array_expr->accept(*this);
+    }
+  }
+};
+
+// the hash of a function's name, parameter types, and return type
+uint64_t signature_hash(const FunDef &f)
+{
+  Hasher h;
+  h.mix(f.fun_name.lexeme());
+  h.mix(string(f.return_type.is_array ? "array " : "") +
+        f.return_type.type_name);
+  for (auto &param : f.params)
+    h.mix(string(param.data_type.is_const ? "const " : "") +
+          (param.data_type.is_array ? "array " : "") +
+          param.data_type.type_name);
+  return h.value();
+}
+
+void BuildCache::compute_fingerprints(Program &p, const set<string> &inlined)
+{
+  fingerprints.clear();
+  // struct fingerprints along with the structs each one refers to
+  unordered_map<string, uint64_t> struct_hashes;
+  unordered_map<string, set<string>> struct_types;
+  for (auto &s : p.struct_defs)
+  {
+    FingerprintVisitor v;
+    s.accept(v);
+    struct_hashes[s.struct_name.lexeme()] = v.hasher.value();
+    struct_types[s.struct_name.lexeme()] = v.types;
+  }
+  unordered_map<string, uint64_t> signatures;
+  unordered_map<string, FingerprintVisitor> bodies;
+  for (auto &f : p.fun_defs)
+  {
+    signatures[f.fun_name.lexeme()] = signature_hash(f);
+    f.accept(bodies[f.fun_name.lexeme()]);
+  }
+
+  for (auto &f : p.fun_defs)
+  {
+    // the function's code also contains every body inlined into it,
+    // so those bodies and their dependencies count as its own
+    set<string> code = {f.fun_name.lexeme()};
+    vector<string> work = {f.fun_name.lexeme()};
+    while (!work.empty())
+    {
+      string name = work.back();
+      work.pop_back();
+      for (const string &callee : bodies[name].calls)
+        if (inlined.contains(callee) and !code.contains(callee))
+        {
+          code.insert(callee);
+          work.push_back(callee);
+        }
+    }
+    Hasher h;
+    h.mix(CACHE_HEADER);
+    h.mix(inlining ? "inline" : "no-inline");
+    h.mix(hoist_loops ? "licm" : "no-licm");
+    set<string> calls;
+    set<string> types;
+    for (const string &name : code)
+    {
+      h.mix(name);
+      h.mix(bodies[name].hasher.value());
+      calls.insert(bodies[name].calls.begin(), bodies[name].calls.end());
+      types.insert(bodies[name].types.begin(), bodies[name].types.end());
+    }
+    // signatures of called functions (a missing function hashes as 0
+    // so that defining it later forces a re-check)
+    for (const string &callee : calls)
+    {
+      h.mix(callee);
+      h.mix(signatures.contains(callee) ? signatures[callee] : 0);
+    }
+    // every struct reachable from the types the function mentions,
+    // since field types of nested structs affect checking
+    set<string> seen;
+    work.assign(types.begin(), types.end());
+    while (!work.empty())
+    {
+      string name = work.back();
+      work.pop_back();
+      if (!struct_hashes.contains(name) or seen.contains(name))
+        continue;
+      seen.insert(name);
+      for (const string &t : struct_types[name])
+        work.push_back(t);
+    }
+    for (const string &name : seen)
+    {
+      h.mix(name);
+      h.mix(struct_hashes[name]);
+    }
+    fingerprints[f.fun_name.lexeme()] = h.value();
+  }
+}
+
+//----------------------------------------------------------------------
+// Cache file reading and writing
+//----------------------------------------------------------------------
+
+void write_string(ostream &out, const string &s)
+{
+  out << s.size() << ':' << s;
+}
+
+bool read_string(istream &in, string &s)
+{
+  size_t n;
+  char colon;
+  if (!(in >> n >> colon) or colon != ':')
+    return false;
+  s.resize(n);
+  in.read(s.data(), n);
+  return bool(in);
+}
+
+void write_value(ostream &out, const VMValue &val)
+{
+  if (holds_alternative<int>(val))
+    out << "i " << get<int>(val);
+  else if (holds_alternative<double>(val))
+  {
+    // the shortest digits that read back as the same double
+    char digits[NUMBER_CHARS];
+    auto end = to_chars(digits, digits + sizeof(digits), get<double>(val)).ptr;
+    out << "d ";
+    out.write(digits, end - digits);
+  }
+  else if (holds_alternative<bool>(val))
+    out << "b " << get<bool>(val);
+  else if (holds_alternative<VMString>(val))
+  {
+    out << "s ";
+    write_string(out, get<VMString>(val).str());
+  }
+  else if (holds_alternative<char>(val))
+    out << "c " << (int)(unsigned char)get<char>(val);
+  else
+    out << "n";
+}
+
+bool read_value(istream &in, VMValue &val)
+{
+  char tag;
+  if (!(in >> tag))
+    return false;
+  if (tag == 'i')
+  {
+    int x;
+    in >> x;
+    val = x;
+  }
+  else if (tag == 'd')
+  {
+    double x;
+    in >> x;
+    val = x;
+  }
+  else if (tag == 'b')
+  {
+    bool x;
+    in >> x;
+    val = x;
+  }
+  else if (tag == 'c')
+  {
+    int x;
+    in >> x;
+    val = (char)x;
+  }
+  else if (tag == 's')
+  {
+    string x;
+    if (!read_string(in, x))
+      return false;
+    val = x;
+  }
+  else if (tag == 'n')
+    val = nullptr;
+  else
+    return false;
+  return bool(in);
+}
+
+BuildCache::BuildCache(const string &cache_file)
+    : cache_file(cache_file)
+{
+}
+
+void BuildCache::load()
+{
+  entries.clear();
+  ifstream in(cache_file, ios::binary);
+  string header;
+  if (!getline(in, header) or header != CACHE_HEADER)
+    return;
+  string name;
+  while (read_string(in, name))
+  {
+    Entry entry;
+    int count, constants;
+    if (!(in >> entry.fingerprint >> entry.frame.arg_count >> entry.frame.local_count >> count >> constants))
+      break;
+    entry.frame.function_name = name;
+    bool ok = true;
+    for (int i = 0; ok and i < count; ++i)
+    {
+      int opcode;
+      char has_operand;
+      ok = bool(in >> opcode >> has_operand);
+      VMInstr instr(static_cast<OpCode>(opcode));
+      if (ok and has_operand == '+')
+      {
+        VMValue val;
+        ok = read_value(in, val);
+        instr.set_operand(val);
+      }
+      string comment;
+      ok = ok and read_string(in, comment);
+      instr.set_comment(comment);
+      entry.frame.instructions.push_back(instr);
+    }
+    for (int i = 0; ok and i < constants; ++i)
+    {
+      VMArrayConstant constant;
+      int size;
+      ok = read_string(in, constant.element_type) and bool(in >> size);
+      for (int j = 0; ok and j < size; ++j)
+      {
+        VMValue val;
+        ok = read_value(in, val);
+        constant.values.push_back(val);
+      }
+      entry.frame.array_constants.push_back(constant);
+    }
+    if (!ok)
+    {
+      // a truncated or corrupt cache is simply discarded
+      entries.clear();
+      return;
+    }
+    entries[name] = entry;
+  }
+}
+
+void BuildCache::save() const
+{
+  ofstream out(cache_file, ios::binary | ios::trunc);
+  if (!out)
+    return;
+  out << CACHE_HEADER << "\n";
+  for (const auto &[name, entry] : entries)
+  {
+    write_string(out, name);
+    out << " " << entry.fingerprint << " " << entry.frame.arg_count << " "
+        << entry.frame.local_count << " " << entry.frame.instructions.size() << " "
+        << entry.frame.array_constants.size() << "\n";
+    for (const VMInstr &instr : entry.frame.instructions)
+    {
+      out << static_cast<int>(instr.opcode());
+      if (instr.operand().has_value())
+      {
+        out << " + ";
+        write_value(out, instr.operand().value());
+      }
+      else
+        out << " -";
+      out << " ";
+      write_string(out, instr.comment());
+      out << "\n";
+    }
+    for (const VMArrayConstant &constant : entry.frame.array_constants)
+    {
+      write_string(out, constant.element_type);
+      out << " " << constant.values.size();
+      for (const VMValue &val : constant.values)
+      {
+        out << " ";
+        write_value(out, val);
+      }
+      out << "\n";
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+// Incremental build
+//----------------------------------------------------------------------
+
+void BuildCache::enable_inlining()
+{
+  inlining = true;
+}
+
+void BuildCache::enable_loop_hoisting()
+{
+  hoist_loops = true;
+}
+
+void BuildCache::build(Program &p, VM &vm)
+{
+  load();
+  Inliner inliner;
+  set<string> inlined;
+  if (inlining)
+  {
+    p.accept(inliner);
+    for (const auto &[name, f] : inliner.candidates())
+      inlined.insert(name);
+  }
+  compute_fingerprints(p, inlined);
+  rebuilt_funs.clear();
+  reused_funs.clear();
+
+  // split functions into those with a matching cached frame and those
+  // that have to be checked and generated again
+  Program changed;
+  changed.struct_defs = p.struct_defs;
+  unordered_set<string> changed_names;
+  for (auto &f : p.fun_defs)
+  {
+    string name = f.fun_name.lexeme();
+    if (entries.contains(name) and
+        entries[name].fingerprint == fingerprints[name])
+      reused_funs.push_back(name);
+    else
+    {
+      changed.fun_defs.push_back(f);
+      changed_names.insert(name);
+      rebuilt_funs.push_back(name);
+    }
+  }
+
+  // every definition is still registered with the checker so calls
+  // into unchanged functions are typed against their signatures
+  SemanticChecker checker;
+  checker.check_only(changed_names);
+  p.accept(checker);
+
+  CodeGenerator generator(vm);
+  if (inlining)
+    generator.enable_inlining(inliner.candidates());
+  if (hoist_loops)
+    generator.enable_loop_hoisting();
+  changed.accept(generator);
+  for (const string &name : reused_funs)
+    vm.add(entries[name].frame);
+
+  // refresh the cache (dropping functions that no longer exist)
+  unordered_map<string, Entry> updated;
+  for (auto &f : p.fun_defs)
+  {
+    string name = f.fun_name.lexeme();
+    updated[name] = Entry{fingerprints[name], vm.frame(name)};
+  }
+  entries = updated;
+  save();
+}
+
+const vector<string> &BuildCache::rebuilt() const
+{
+  return rebuilt_funs;
+}
+
+const vector<string> &BuildCache::reused() const
+{
+  return reused_funs;
+}
+
+uint64_t BuildCache::fingerprint(const string &fun_name) const
+{
+  return fingerprints.at(fun_name);
+}
@@ -0,0 +1,86 @@
+//----------------------------------------------------------------------
+// FILE: build_cache.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Function-granularity build cache used for incremental
+// compilation. Each function is fingerprinted from its tokens plus
+// the signatures and struct definitions it depends on, and the
+// generated VM frame is reused when the fingerprint is unchanged.
+//----------------------------------------------------------------------
+
+#ifndef BUILD_CACHE_H
+#define BUILD_CACHE_H
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "vm.h"
+
+class BuildCache
+{
+public:
+  // create a cache backed by the given file (need not exist yet)
+  BuildCache(const std::string &cache_file);
+
+  // inline small functions when generating code (callers then also
+  // depend on the bodies of the functions inlined into them)
+  void enable_inlining();
+
+  // hoist loop-invariant code out of loops when generating code
+  void enable_loop_hoisting();
+
+  // check and generate code for the program into the vm, only
+  // re-checking and regenerating functions whose fingerprint changed
+  // (throws MyPLException on static errors)
+  void build(Program &p, VM &vm);
+
+  // functions that were (re)generated by the last build
+  const std::vector<std::string> &rebuilt() const;
+
+  // functions whose frames were reused by the last build
+  const std::vector<std::string> &reused() const;
+
+  // fingerprint of each function computed by the last build
+  std::uint64_t fingerprint(const std::string &fun_name) const;
+
+private:
+  // cached frame for a function along with its fingerprint
+  struct Entry
+  {
+    std::uint64_t fingerprint;
+    VMFrameInfo frame;
+  };
+
+  // the backing file
+  std::string cache_file;
+
+  // whether generated code has calls inlined
+  bool inlining = false;
+
+  // whether generated code has loop invariants hoisted
+  bool hoist_loops = false;
+
+  // entries read from the cache file
+  std::unordered_map<std::string, Entry> entries;
+
+  // fingerprints computed for the current program
+  std::unordered_map<std::string, std::uint64_t> fingerprints;
+
+  // report from the last build
+  std::vector<std::string> rebuilt_funs;
+  std::vector<std::string> reused_funs;
+
+  // compute the fingerprint of every function in the program, given
+  // the names of the functions that are inlined into their callers
+  void compute_fingerprints(Program &p, const std::set<std::string> &inlined);
+
+  // read and write the cache file (a missing or stale file is
+  // treated as an empty cache)
+  void load();
+  void save() const;
+};
+
+#endif
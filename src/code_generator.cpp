@@ -7,6 +7,7 @@
 
 #include <iostream> // for debugging
 #include "code_generator.h"
+#include "loop_optimizer.h"
 #include <random>
 
 using namespace std;
@@ -43,15 +44,23 @@ void CodeGenerator::visit(FunDef &f)
     curr_frame.instructions.push_back(VMInstr::STORE(i));
     var_table.add(f.params[i].var_name.lexeme());
   }
+  tail_calls.clear();
+  if (f.return_type.type_name == "void")
+  {
+    find_tail_calls(f.stmts);
+  }
   for (auto s : f.stmts)
   {
     s->accept(*this);
   }
-  if (curr_frame.instructions.empty() || curr_frame.instructions.back().opcode() != OpCode::RET)
+  if (curr_frame.instructions.empty() || (curr_frame.instructions.back().opcode() != OpCode::RET && curr_frame.instructions.back().opcode() != OpCode::TAILCALL))
   {
     curr_frame.instructions.push_back(VMInstr::PUSH(nullptr));
     curr_frame.instructions.push_back(VMInstr::RET());
   }
+  curr_frame.local_count = var_table.max_size();
+  if (hoist_loops)
+    LoopOptimizer().optimize(curr_frame);
   vm.add(curr_frame);
   var_table.pop_environment();
   next_var_index = 0;
@@ -62,9 +71,67 @@ void CodeGenerator::visit(StructDef &s)
   struct_defs[s.struct_name.lexeme()] = s;
 }
 
+void CodeGenerator::enable_inlining(const unordered_map<string, FunDef> &funs)
+{
+  inline_funs = funs;
+}
+
+void CodeGenerator::enable_loop_hoisting()
+{
+  hoist_loops = true;
+}
+
+void CodeGenerator::find_tail_calls(vector<shared_ptr<Stmt>> &stmts)
+{
+  if (stmts.empty())
+    return;
+  // a void function returns null after its last statement, which is
+  // what the recursive call itself would return
+  shared_ptr<Stmt> last = stmts.back();
+  if (auto call = dynamic_pointer_cast<CallExpr>(last))
+  {
+    if (call->fun_name.lexeme() == curr_frame.function_name)
+      tail_calls.insert(call.get());
+  }
+  else if (auto if_stmt = dynamic_pointer_cast<IfStmt>(last))
+  {
+    find_tail_calls(if_stmt->if_part.stmts);
+    for (auto &else_if : if_stmt->else_ifs)
+      find_tail_calls(else_if.stmts);
+    find_tail_calls(if_stmt->else_stmts);
+  }
+}
+
+bool CodeGenerator::self_call(Expr &e)
+{
+  if (e.op.has_value() or e.negated)
+    return false;
+  auto term = dynamic_pointer_cast<SimpleTerm>(e.first);
+  if (!term)
+    return false;
+  auto call = dynamic_pointer_cast<CallExpr>(term->rvalue);
+  return call and call->fun_name.lexeme() == curr_frame.function_name;
+}
+
 void CodeGenerator::visit(ReturnStmt &s)
 {
+  if (inline_returns.empty() and self_call(s.expr))
+  {
+    // return f(...) inside f reuses the current frame
+    auto call = dynamic_pointer_cast<CallExpr>(dynamic_pointer_cast<SimpleTerm>(s.expr.first)->rvalue);
+    for (auto &arg : call->args)
+      arg.accept(*this);
+    curr_frame.instructions.push_back(VMInstr::TAILCALL(curr_frame.function_name));
+    return;
+  }
   s.expr.accept(*this);
+  if (!inline_returns.empty())
+  {
+    // returning from an inlined body jumps past the rest of it
+    inline_returns.back().push_back(curr_frame.instructions.size());
+    curr_frame.instructions.push_back(VMInstr::JMP(-1));
+    return;
+  }
   curr_frame.instructions.push_back(VMInstr::RET());
 }
 
@@ -209,6 +276,78 @@ void CodeGenerator::visit(CallExpr &e)
   {
     curr_frame.instructions.push_back(VMInstr::READ());
   }
+  else if (fun_name == "read_all")
+  {
+    curr_frame.instructions.push_back(VMInstr::READALL());
+  }
+  else if (fun_name == "read_file")
+  {
+    curr_frame.instructions.push_back(VMInstr::READF());
+  }
+  else if (fun_name == "read_lines")
+  {
+    curr_frame.instructions.push_back(VMInstr::READLNS());
+  }
+  else if (fun_name == "mmap_ints")
+  {
+    curr_frame.instructions.push_back(VMInstr::MAPI());
+  }
+  else if (fun_name == "mmap_doubles")
+  {
+    curr_frame.instructions.push_back(VMInstr::MAPD());
+  }
+  else if (fun_name == "substr")
+  {
+    curr_frame.instructions.push_back(VMInstr::SUBSTR());
+  }
+  else if (fun_name == "index_of")
+  {
+    curr_frame.instructions.push_back(VMInstr::FIND());
+  }
+  else if (fun_name == "split")
+  {
+    curr_frame.instructions.push_back(VMInstr::SPLIT());
+  }
+  else if (fun_name == "starts_with")
+  {
+    curr_frame.instructions.push_back(VMInstr::STARTSW());
+  }
+  else if (fun_name == "append")
+  {
+    curr_frame.instructions.push_back(VMInstr::APPEND());
+  }
+  else if (fun_name == "pop")
+  {
+    curr_frame.instructions.push_back(VMInstr::APOP());
+  }
+  else if (fun_name == "resize")
+  {
+    curr_frame.instructions.push_back(VMInstr::ARESIZE());
+  }
+  else if (fun_name == "copy")
+  {
+    curr_frame.instructions.push_back(VMInstr::ACOPY());
+  }
+  else if (fun_name == "map_get")
+  {
+    curr_frame.instructions.push_back(VMInstr::MGET());
+  }
+  else if (fun_name == "map_put")
+  {
+    curr_frame.instructions.push_back(VMInstr::MPUT());
+  }
+  else if (fun_name == "map_has")
+  {
+    curr_frame.instructions.push_back(VMInstr::MHAS());
+  }
+  else if (fun_name == "map_remove")
+  {
+    curr_frame.instructions.push_back(VMInstr::MDEL());
+  }
+  else if (fun_name == "map_keys")
+  {
+    curr_frame.instructions.push_back(VMInstr::MKEYS());
+  }
   else if (fun_name == "get")
   {
     curr_frame.instructions.push_back(VMInstr::GETC());
@@ -237,16 +376,76 @@ void CodeGenerator::visit(CallExpr &e)
   {
     curr_frame.instructions.push_back(VMInstr::CONCAT());
   }
+  else if (tail_calls.contains(&e) and inline_returns.empty())
+  {
+    curr_frame.instructions.push_back(VMInstr::TAILCALL(fun_name));
+  }
+  else if (inline_funs.contains(fun_name))
+  {
+    inline_call(inline_funs[fun_name]);
+  }
   else
   {
     curr_frame.instructions.push_back(VMInstr::CALL(fun_name));
   }
 }
 
+void CodeGenerator::inline_call(FunDef &f)
+{
+  int start = curr_frame.instructions.size();
+  // the parameters get fresh slots above the caller's live variables,
+  // popped last argument first since it is on top of the stack
+  var_table.push_environment();
+  for (auto &param : f.params)
+    var_table.add(param.var_name.lexeme());
+  for (int i = f.params.size() - 1; i >= 0; i--)
+    curr_frame.instructions.push_back(VMInstr::STORE(var_table.get(f.params[i].var_name.lexeme())));
+  inline_returns.push_back({});
+  for (auto &s : f.stmts)
+    s->accept(*this);
+  vector<int> returns = inline_returns.back();
+  inline_returns.pop_back();
+  // a trailing return just falls through, otherwise the implicit
+  // null return value is pushed
+  if (!returns.empty() and returns.back() == curr_frame.instructions.size() - 1)
+  {
+    curr_frame.instructions.pop_back();
+    returns.pop_back();
+  }
+  else
+  {
+    curr_frame.instructions.push_back(VMInstr::PUSH(nullptr));
+  }
+  if (!returns.empty())
+  {
+    int end = curr_frame.instructions.size();
+    curr_frame.instructions.push_back(VMInstr::NOP());
+    curr_frame.instructions.at(end).set_comment("end of inlined " + f.fun_name.lexeme() + "()");
+    for (int i : returns)
+      curr_frame.instructions.at(i).set_operand(end);
+  }
+  var_table.pop_environment();
+  curr_frame.instructions.at(start).set_comment("inlined " + f.fun_name.lexeme() + "()");
+}
+
 void CodeGenerator::visit(Expr &e)
 {
   e.first->accept(*this);
-  if (e.op.has_value())
+  if (e.op.has_value() and (e.op.value().lexeme() == "and" or e.op.value().lexeme() == "or"))
+  {
+    // short circuit: the first operand is the result when it decides
+    // the expression, otherwise it is dropped for the rest's value
+    int jump_index = curr_frame.instructions.size() + 1;
+    curr_frame.instructions.push_back(VMInstr::DUP());
+    if (e.op.value().lexeme() == "and")
+      curr_frame.instructions.push_back(VMInstr::JMPF(-1));
+    else
+      curr_frame.instructions.push_back(VMInstr::JMPT(-1));
+    curr_frame.instructions.push_back(VMInstr::POP());
+    e.rest->accept(*this);
+    curr_frame.instructions.at(jump_index).set_operand((int)curr_frame.instructions.size());
+  }
+  else if (e.op.has_value())
   {
     e.rest->accept(*this);
     if (e.op.value().lexeme() == "+")
@@ -265,14 +464,6 @@ void CodeGenerator::visit(Expr &e)
     {
       curr_frame.instructions.push_back(VMInstr::DIV());
     }
-    else if (e.op.value().lexeme() == "and")
-    {
-      curr_frame.instructions.push_back(VMInstr::AND());
-    }
-    else if (e.op.value().lexeme() == "or")
-    {
-      curr_frame.instructions.push_back(VMInstr::OR());
-    }
     else if (e.op.value().lexeme() == "<")
     {
       curr_frame.instructions.push_back(VMInstr::CMPLT());
@@ -316,66 +507,62 @@ void CodeGenerator::visit(ComplexTerm &t)
 
 void CodeGenerator::visit(SimpleRValue &v)
 {
-  if (v.value.type() == TokenType::INT_VAL)
-  {
-    int val = stoi(v.value.lexeme());
-    curr_frame.instructions.push_back(VMInstr::PUSH(val));
-  }
-  else if (v.value.type() == TokenType::DOUBLE_VAL)
-  {
-    double val = stod(v.value.lexeme());
-    curr_frame.instructions.push_back(VMInstr::PUSH(val));
-  }
-  else if (v.value.type() == TokenType::STRING_VAL)
+  curr_frame.instructions.push_back(VMInstr::PUSH(literal(v.value)));
+}
+
+VMValue CodeGenerator::literal(const Token &value) const
+{
+  if (value.type() == TokenType::INT_VAL)
+    return stoi(value.lexeme());
+  else if (value.type() == TokenType::DOUBLE_VAL)
+    return stod(value.lexeme());
+  else if (value.type() == TokenType::STRING_VAL)
   {
-    string val = v.value.lexeme();
+    string val = value.lexeme();
     replace_all(val, "\\n", "\n");
     replace_all(val, "\\t", "\t");
-    curr_frame.instructions.push_back(VMInstr::PUSH(val));
+    // copies of the same literal share one buffer
+    return VMString::intern(val);
   }
-  else if (v.value.type() == TokenType::CHAR_VAL)
+  else if (value.type() == TokenType::CHAR_VAL)
   {
-    string val = v.value.lexeme();
+    string val = value.lexeme();
     replace_all(val, "\\n", "\n");
     replace_all(val, "\\t", "\t");
-    curr_frame.instructions.push_back(VMInstr::PUSH(val));
-  }
-  else if (v.value.type() == TokenType::BOOL_VAL)
-  {
-    if (v.value.lexeme() == "true")
-      curr_frame.instructions.push_back(VMInstr::PUSH(true));
-    else if (v.value.lexeme() == "false")
-      curr_frame.instructions.push_back(VMInstr::PUSH(false));
-  }
-  else if (v.value.type() == TokenType::NULL_VAL)
-  {
-    curr_frame.instructions.push_back(VMInstr::PUSH(nullptr));
+    if (val.size() == 1)
+      return val[0];
+    return val;
   }
+  else if (value.type() == TokenType::BOOL_VAL)
+    return value.lexeme() == "true";
+  return nullptr;
 }
 
 // You would probably just do the ALLOCA, then go through each item of the initializer, evaluate the corresponding expression, push the index, then call SETF.
 // I don't think you need a new instruction, and instead, can just reuse existing instructions.
 void CodeGenerator::visit(NewRValue &v)
 {
-  if (v.array_expr.has_value())
+  if (v.type.type() == TokenType::MAP)
+  {
+    DataType map_type{false, v.type.lexeme()};
+    curr_frame.instructions.push_back(VMInstr::ALLOCM(map_type.key_type()));
+  }
+  else if (v.array_expr.has_value())
   {
     v.array_expr->accept(*this);
     curr_frame.instructions.push_back(VMInstr::PUSH(nullptr));
-    curr_frame.instructions.push_back(VMInstr::ALLOCA());
+    curr_frame.instructions.push_back(VMInstr::ALLOCA(v.type.lexeme()));
   }
   else if (v.const_array.size() >= 1)
   {
-    int size = v.const_array.size();
-    curr_frame.instructions.push_back(VMInstr::PUSH(size));
-    curr_frame.instructions.push_back(VMInstr::PUSH(nullptr));
-    curr_frame.instructions.push_back(VMInstr::ALLOCA());
-    for (int i = 0; i < v.const_array.size(); i++)
-    {
-      curr_frame.instructions.push_back(VMInstr::DUP());
-      curr_frame.instructions.push_back(VMInstr::PUSH(i));
-      curr_frame.instructions.push_back(VMInstr::PUSH(v.const_array[i].value.lexeme()));
-      curr_frame.instructions.push_back(VMInstr::SETI());
-    }
+    // the elements go in the frame's constant pool and the array is
+    // created from it by one instruction
+    VMArrayConstant constant{v.type.lexeme()};
+    for (SimpleRValue &value : v.const_array)
+      constant.values.push_back(literal(value.value));
+    curr_frame.array_constants.push_back(constant);
+    int index = curr_frame.array_constants.size() - 1;
+    curr_frame.instructions.push_back(VMInstr::ALLOCA_CONST(index));
   }
   else
   {
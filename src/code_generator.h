@@ -10,6 +10,8 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "ast.h"
 #include "var_table.h"
 #include "vm.h"
@@ -35,12 +37,43 @@ public:
   void visit(NewRValue &v);
   void visit(VarRValue &v);
 
+  // expand calls to the given functions in place instead of emitting
+  // CALL (the functions are chosen by the Inliner pass)
+  void enable_inlining(const std::unordered_map<std::string, FunDef> &funs);
+
+  // hoist loop-invariant computations out of each generated function
+  void enable_loop_hoisting();
+
 private:
   VM &vm;
   VMFrameInfo curr_frame;
   int next_var_index = 0;
   VarTable var_table;
   std::unordered_map<std::string, StructDef> struct_defs;
+
+  // functions whose calls are inlined
+  std::unordered_map<std::string, FunDef> inline_funs;
+
+  // pending return jumps for each inlined body being generated
+  std::vector<std::vector<int>> inline_returns;
+
+  // whether loop-invariant code is hoisted out of loops
+  bool hoist_loops = false;
+
+  // generate the body of f in place of a call (args already pushed)
+  void inline_call(FunDef &f);
+
+  // self-call statements in tail position of the current function
+  std::unordered_set<CallExpr *> tail_calls;
+
+  // record the self-calls that end the given (void function) body
+  void find_tail_calls(std::vector<std::shared_ptr<Stmt>> &stmts);
+
+  // true if the expression is just a call to the current function
+  bool self_call(Expr &e);
+
+  // the vm value of a literal (with escapes replaced)
+  VMValue literal(const Token &value) const;
 };
 
 #endif
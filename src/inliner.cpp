@@ -0,0 +1,180 @@
+//----------------------------------------------------------------------
+// FILE: inliner.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Inline candidate selection
+//----------------------------------------------------------------------
+
+#include <vector>
+#include "inliner.h"
+
+using namespace std;
+
+void Inliner::visit(Program &p)
+{
+  for (auto &f : p.fun_defs)
+    f.accept(*this);
+  for (auto &f : p.fun_defs)
+  {
+    string name = f.fun_name.lexeme();
+    const Summary &s = summaries[name];
+    // a discarded call result would be left on the caller's operand
+    // stack instead of being dropped with the callee's frame
+    if (name == "main" or s.size > SIZE_LIMIT or s.has_call_stmt)
+      continue;
+    if (recursive(name))
+      continue;
+    inline_funs[name] = f;
+  }
+}
+
+bool Inliner::recursive(const string &fun_name) const
+{
+  set<string> seen;
+  vector<string> work = {fun_name};
+  while (!work.empty())
+  {
+    string name = work.back();
+    work.pop_back();
+    if (!summaries.contains(name))
+      continue;
+    for (const string &callee : summaries.at(name).calls)
+    {
+      if (callee == fun_name)
+        return true;
+      if (!seen.contains(callee))
+      {
+        seen.insert(callee);
+        work.push_back(callee);
+      }
+    }
+  }
+  return false;
+}
+
+const unordered_map<string, FunDef> &Inliner::candidates() const
+{
+  return inline_funs;
+}
+
+void Inliner::stmts(vector<shared_ptr<Stmt>> &body)
+{
+  for (auto &s : body)
+  {
+    auto call = dynamic_pointer_cast<CallExpr>(s);
+    if (call and call->fun_name.lexeme() != "print")
+      curr.has_call_stmt = true;
+    s->accept(*this);
+  }
+}
+
+void Inliner::visit(FunDef &f)
+{
+  curr = Summary();
+  stmts(f.stmts);
+  summaries[f.fun_name.lexeme()] = curr;
+}
+
+void Inliner::visit(StructDef &s)
+{
+}
+
+void Inliner::visit(ReturnStmt &s)
+{
+  ++curr.size;
+  s.expr.accept(*this);
+}
+
+void Inliner::visit(WhileStmt &s)
+{
+  ++curr.size;
+  s.condition.accept(*this);
+  stmts(s.stmts);
+}
+
+void Inliner::visit(ForStmt &s)
+{
+  ++curr.size;
+  s.var_decl.accept(*this);
+  s.condition.accept(*this);
+  s.assign_stmt.accept(*this);
+  stmts(s.stmts);
+}
+
+void Inliner::visit(IfStmt &s)
+{
+  ++curr.size;
+  s.if_part.condition.accept(*this);
+  stmts(s.if_part.stmts);
+  for (auto &else_if : s.else_ifs)
+  {
+    else_if.condition.accept(*this);
+    stmts(else_if.stmts);
+  }
+  stmts(s.else_stmts);
+}
+
+void Inliner::visit(VarDeclStmt &s)
+{
+  ++curr.size;
+  s.expr.accept(*this);
+}
+
+void Inliner::visit(AssignStmt &s)
+{
+  curr.size += s.lvalue.size();
+  for (auto &ref : s.lvalue)
+    if (ref.array_expr.has_value())
+      ref.array_expr->accept(*this);
+  s.expr.accept(*this);
+}
+
+void Inliner::visit(CallExpr &e)
+{
+  ++curr.size;
+  curr.calls.insert(e.fun_name.lexeme());
+  for (auto &arg : e.args)
+    arg.accept(*this);
+}
+
+void Inliner::visit(Expr &e)
+{
+  e.first->accept(*this);
+  if (e.op.has_value())
+  {
+    ++curr.size;
+    e.rest->accept(*this);
+  }
+}
+
+void Inliner::visit(SimpleTerm &t)
+{
+  t.rvalue->accept(*this);
+}
+
+void Inliner::visit(ComplexTerm &t)
+{
+  t.expr.accept(*this);
+}
+
+void Inliner::visit(SimpleRValue &v)
+{
+  ++curr.size;
+}
+
+void Inliner::visit(NewRValue &v)
+{
+  // struct allocation expands to a few instructions per field
+  curr.size += 2;
+  if (v.array_expr.has_value())
+    v.array_expr->accept(*this);
+  curr.size += v.const_array.size();
+}
+
+void Inliner::visit(VarRValue &v)
+{
+  curr.size += v.path.size();
+  for (auto &ref : v.path)
+    if (ref.array_expr.has_value())
+      ref.array_expr->accept(*this);
+}
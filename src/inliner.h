@@ -0,0 +1,69 @@
+//----------------------------------------------------------------------
+// FILE: inliner.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Analysis pass that picks the functions whose calls the code
+// generator expands in place (small, non-recursive functions).
+//----------------------------------------------------------------------
+
+#ifndef INLINER_H
+#define INLINER_H
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include "ast.h"
+
+class Inliner : public Visitor
+{
+public:
+  // largest function body (in AST nodes) that is inlined
+  static const int SIZE_LIMIT = 24;
+
+  // visitor functions
+  void visit(Program &p);
+  void visit(FunDef &f);
+  void visit(StructDef &s);
+  void visit(ReturnStmt &s);
+  void visit(WhileStmt &s);
+  void visit(ForStmt &s);
+  void visit(IfStmt &s);
+  void visit(VarDeclStmt &s);
+  void visit(AssignStmt &s);
+  void visit(CallExpr &e);
+  void visit(Expr &e);
+  void visit(SimpleTerm &t);
+  void visit(ComplexTerm &t);
+  void visit(SimpleRValue &v);
+  void visit(NewRValue &v);
+  void visit(VarRValue &v);
+
+  // the functions chosen for inlining, by name
+  const std::unordered_map<std::string, FunDef> &candidates() const;
+
+private:
+  // per-function facts gathered while visiting
+  struct Summary
+  {
+    int size = 0;
+    std::set<std::string> calls;
+    bool has_call_stmt = false;
+  };
+
+  // summary of the function currently being visited
+  Summary curr;
+
+  // summaries of every function in the program
+  std::unordered_map<std::string, Summary> summaries;
+
+  // chosen functions
+  std::unordered_map<std::string, FunDef> inline_funs;
+
+  // visit a statement block, noting calls whose results are discarded
+  void stmts(std::vector<std::shared_ptr<Stmt>> &body);
+
+  // true if the function can (transitively) call itself
+  bool recursive(const std::string &fun_name) const;
+};
+
+#endif
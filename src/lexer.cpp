@@ -461,6 +461,23 @@ Token Lexer::next_token()
             return Token(TokenType::ARRAY, lexeme, line, start_column);
           }
         }
+        else if (lexeme == "map")
+        {
+          if (isalpha(peek()) || isdigit(peek()) || peek() == '_')
+          {
+            ch = read();
+            lexeme += ch;
+            while (isalpha(peek()) || isdigit(peek()) || peek() == '_')
+            {
+              ch = read();
+              lexeme += ch;
+            }
+          }
+          else
+          {
+            return Token(TokenType::MAP, lexeme, line, start_column);
+          }
+        }
         else if (lexeme == "return")
         {
           if (isalpha(peek()) || isdigit(peek()) || peek() == '_')
@@ -0,0 +1,222 @@
+//----------------------------------------------------------------------
+// FILE: loop_optimizer.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Loop-invariant code motion implementation
+//----------------------------------------------------------------------
+
+#include <set>
+#include <string>
+#include <unordered_set>
+#include "loop_optimizer.h"
+
+using namespace std;
+
+bool is_jump(OpCode op)
+{
+  return op == OpCode::JMP or op == OpCode::JMPF or op == OpCode::JMPT;
+}
+
+// instructions without side effects (though they may raise errors)
+bool is_pure(OpCode op)
+{
+  switch (op)
+  {
+  case OpCode::PUSH:
+  case OpCode::POP:
+  case OpCode::LOAD:
+  case OpCode::ADD:
+  case OpCode::SUB:
+  case OpCode::MUL:
+  case OpCode::DIV:
+  case OpCode::AND:
+  case OpCode::OR:
+  case OpCode::NOT:
+  case OpCode::CMPLT:
+  case OpCode::CMPLE:
+  case OpCode::CMPGT:
+  case OpCode::CMPGE:
+  case OpCode::CMPEQ:
+  case OpCode::CMPNE:
+  case OpCode::SLEN:
+  case OpCode::ALEN:
+  case OpCode::GETC:
+  case OpCode::TOINT:
+  case OpCode::TODBL:
+  case OpCode::TOSTR:
+  case OpCode::CONCAT:
+  case OpCode::SUBSTR:
+  case OpCode::FIND:
+  case OpCode::STARTSW:
+  case OpCode::GETF:
+  case OpCode::GETI:
+  case OpCode::DUP:
+  case OpCode::NOP:
+    return true;
+  default:
+    return false;
+  }
+}
+
+int LoopOptimizer::hoisted() const
+{
+  return hoisted_count;
+}
+
+void LoopOptimizer::optimize(VMFrameInfo &frame)
+{
+  // every hoist shifts instruction indexes, so the loops are found
+  // again after each one (bounded in case of pathological code)
+  int limit = frame.instructions.size();
+  bool changed = true;
+  while (changed and limit-- > 0)
+  {
+    changed = false;
+    for (int i = 0; i < frame.instructions.size() and !changed; ++i)
+    {
+      const VMInstr &instr = frame.instructions[i];
+      if (instr.opcode() != OpCode::JMP)
+        continue;
+      int target = get<int>(instr.operand().value());
+      // a backward jump closes a loop starting at its target
+      if (target >= 0 and target <= i)
+        changed = hoist(frame, target, i);
+    }
+  }
+}
+
+bool LoopOptimizer::hoist(VMFrameInfo &frame, int start, int end)
+{
+  vector<VMInstr> &code = frame.instructions;
+
+  // the hoisted code runs on entry, so jumps from outside the loop
+  // must enter at its start
+  unordered_set<int> targets;
+  for (int k = 0; k < code.size(); ++k)
+  {
+    if (!is_jump(code[k].opcode()))
+      continue;
+    int target = get<int>(code[k].operand().value());
+    targets.insert(target);
+    if ((k < start or k > end) and target > start and target <= end)
+      return false;
+  }
+
+  // what the loop may change: variables, fields (by name, since any
+  // object may alias), array elements and lengths, and anything at all
+  // on a call
+  set<int> stored;
+  set<string> set_fields;
+  bool sets_elems = false;
+  bool resizes = false;
+  bool calls = false;
+  int max_slot = frame.arg_count - 1;
+  for (int k = 0; k < code.size(); ++k)
+  {
+    OpCode op = code[k].opcode();
+    if (op == OpCode::LOAD or op == OpCode::STORE)
+      max_slot = max(max_slot, get<int>(code[k].operand().value()));
+    if (k < start or k > end)
+      continue;
+    if (op == OpCode::STORE)
+      stored.insert(get<int>(code[k].operand().value()));
+    else if (op == OpCode::SETF)
+      set_fields.insert(get<VMString>(code[k].operand().value()).str());
+    else if (op == OpCode::SETI or op == OpCode::ACOPY)
+      sets_elems = true;
+    else if (op == OpCode::APPEND or op == OpCode::APOP or op == OpCode::ARESIZE)
+      sets_elems = resizes = true;
+    else if (op == OpCode::CALL or op == OpCode::TAILCALL)
+      calls = true;
+  }
+
+  // only the straight-line code at the top of the loop (its condition)
+  // is considered, since it runs every time the loop is entered and
+  // so hoisting it cannot introduce new errors
+  int prefix_end = start;
+  while (prefix_end <= end and is_pure(code[prefix_end].opcode()))
+  {
+    if (prefix_end > start and targets.contains(prefix_end))
+      break;
+    ++prefix_end;
+  }
+
+  for (int a = start; a < prefix_end; ++a)
+  {
+    if (code[a].opcode() != OpCode::LOAD or stored.contains(get<int>(code[a].operand().value())))
+      continue;
+    // extend the chain while each step only reads unchanged state
+    int b = a + 1;
+    while (b < prefix_end)
+    {
+      OpCode op = code[b].opcode();
+      if (op == OpCode::GETF and !calls and !set_fields.contains(get<VMString>(code[b].operand().value()).str()))
+        ++b;
+      else if (op == OpCode::SLEN or (op == OpCode::ALEN and !calls and !resizes))
+        ++b;
+      else if (op == OpCode::PUSH and holds_alternative<int>(code[b].operand().value()) and
+               b + 1 < prefix_end and code[b + 1].opcode() == OpCode::GETI and !calls and !sets_elems)
+        b += 2;
+      else
+        break;
+    }
+    if (b == a + 1)
+      continue;
+
+    // compute [a, b) into a fresh slot before the loop and load the
+    // slot in its place
+    int slot = max_slot + 1;
+    int length = (b - a) + 1;
+    vector<VMInstr> result;
+    vector<int> origin;
+    for (int k = 0; k < start; ++k)
+    {
+      result.push_back(code[k]);
+      origin.push_back(k);
+    }
+    for (int k = a; k < b; ++k)
+    {
+      result.push_back(code[k]);
+      origin.push_back(-1);
+    }
+    result.push_back(VMInstr::STORE(slot));
+    result.back().set_comment("hoisted loop invariant");
+    origin.push_back(-1);
+    for (int k = start; k < a; ++k)
+    {
+      result.push_back(code[k]);
+      origin.push_back(k);
+    }
+    result.push_back(VMInstr::LOAD(slot));
+    result.back().set_comment("hoisted loop invariant");
+    origin.push_back(-1);
+    for (int k = b; k < code.size(); ++k)
+    {
+      result.push_back(code[k]);
+      origin.push_back(k);
+    }
+
+    // retarget jumps: the back edge skips the hoisted code, jumps from
+    // before the loop run it, and everything else shifts
+    for (int k = 0; k < result.size(); ++k)
+    {
+      if (origin[k] < 0 or !is_jump(result[k].opcode()))
+        continue;
+      int target = get<int>(result[k].operand().value());
+      int from = origin[k];
+      int new_target = target;
+      if (target == start)
+        new_target = (from >= start and from <= end) ? start + length : start;
+      else if (target > start and target < a)
+        new_target = target + length;
+      else if (target >= b)
+        new_target = target + length + 1 - (b - a);
+      result[k].set_operand(new_target);
+    }
+    code = result;
+    frame.local_count = max(frame.local_count, slot + 1);
+    ++hoisted_count;
+    return true;
+  }
+  return false;
+}
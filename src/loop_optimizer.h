@@ -0,0 +1,34 @@
+//----------------------------------------------------------------------
+// FILE: loop_optimizer.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Loop-invariant code motion over generated VM instructions.
+// Pure computations rooted at a variable that the loop never stores
+// to (e.g., LOAD xs; ALEN or LOAD t; GETF left; GETF value) are
+// computed once before the loop and kept in a fresh variable slot.
+//----------------------------------------------------------------------
+
+#ifndef LOOP_OPTIMIZER_H
+#define LOOP_OPTIMIZER_H
+
+#include "vm_frame.h"
+
+class LoopOptimizer
+{
+public:
+  // hoist loop-invariant computations out of the frame's loops
+  void optimize(VMFrameInfo &frame);
+
+  // number of computations hoisted so far
+  int hoisted() const;
+
+private:
+  int hoisted_count = 0;
+
+  // hoist one invariant computation out of the loop spanning
+  // [start, end] (end is the backward jump), returns false if there
+  // is nothing to hoist
+  bool hoist(VMFrameInfo &frame, int start, int end);
+};
+
+#endif
@@ -7,6 +7,9 @@
 
 #include <iostream>
 #include <fstream>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
 #include "token.h"
 #include "lexer.h"
 #include "simple_parser.h"
@@ -14,9 +17,35 @@
 #include "print_visitor.h"
 #include "semantic_checker.h"
 #include "code_generator.h"
+#include "build_cache.h"
+#include "inliner.h"
+#include "ssa_builder.h"
+#include "ssa_lowering.h"
+#include "vm_profiler.h"
+#include "vm_sampler.h"
+#include "node_counter.h"
+#include "phase_timer.h"
+#include "perf_counters.h"
 
 using namespace std;
 
+// options that apply on top of the selected mode
+struct Options
+{
+  bool incremental = false;
+  bool inline_calls = true;
+  bool hoist_loops = true;
+  bool ssa = false;
+  bool profile = false;
+  int sample_rate = 0;
+  bool time_phases = false;
+  bool mem_stats = false;
+  bool perf_counters = false;
+  std::string cache_file;
+  std::string profile_file;
+  std::string sample_file;
+};
+
 void usage();
 void lex(istream *input);
 void parse(istream *input);
@@ -25,148 +54,226 @@ void check(istream *input);
 void ir(istream *input);
 void normalMode(istream *input);
 void LexerFunc(istream *input);
+void generate(Program &p, VM &vm);
+SSAProgram build_ssa(Program &p);
+void report_profile(VMProfiler &profiler);
+void report_samples(VMSampler &sampler);
+void begin_phase(const string &name);
+void report_phases(Program &p, VM &vm, int tokens, int nodes);
+void report_mem_stats(const VM &vm);
+void report_perf_counters(const PerfCounters &counters);
 
 char ch;
 int newlinecount;
+Options options;
+PhaseTimer *phase_timer = nullptr;
 
 int main(int argc, char *argv[])
 {
+  // Nothing uses C stdio, and the vm buffers its own output
+  ios::sync_with_stdio(false);
 
   istream *input;
-  string args[argc];
-  // Creating a new array named args that is the string type of the argv's
-  for (int i = 0; i < argc; i++)
-  {
-    args[i] = string(argv[i]);
-  }
-
-  // Making sure if the amount of arguments passed in is greater than 3 then the usage function will be called.
-  if (argc > 3)
-  {
-    usage();
-  }
-
-  // Setting input to &cin so that it will read the input the user enters
-  if (argc == 1)
-  {
-    input = &cin;
-    normalMode(input);
-  }
-
-  // Setting the value of input to a file, so that anytime the user enters 3 argc's it will recognize the 3rd as a file.
-  if (argc == 3)
+  string mode = "";
+  string file_name = "";
+  // Sorting the arguments into build options, the mode flag, and the script file
+  for (int i = 1; i < argc; i++)
   {
-    input = new ifstream(argv[2]);
-    if (args[1] == "--lex")
+    string arg = string(argv[i]);
+    if (arg == "--incremental")
     {
-      // Checking to see if the file is valid
-      if (input->fail())
-      {
-        cout << "ERROR: Could not read file" << args[2] << endl;
-      }
-      else
-      {
-        // If the file is valid I will call the lex function which will then gather the data and print the first letter.
-        lex(input);
-      }
+      options.incremental = true;
     }
-    // Similarly to --lex I tested to see if the file is valid, if so then I will call the parse function with the input still being a file.
-    else if (args[1] == "--parse")
+    else if (arg == "--no-inline")
     {
-      if (input->fail())
-      {
-        cout << "ERROR: Could not read file" << args[2] << endl;
-      }
-      else
-      {
-        parse(input);
-      }
+      options.inline_calls = false;
     }
-    // We continue to call the functions if the file is valid.
-    else if (args[1] == "--print")
+    else if (arg == "--no-licm")
     {
-      if (input->fail())
-      {
-        cout << "ERROR: Could not read file" << args[2] << endl;
-      }
-      else
-      {
-        print(input);
-      }
+      options.hoist_loops = false;
     }
-
-    else if (args[1] == "--check")
+    else if (arg == "--ssa")
     {
-      if (input->fail())
-      {
-        cout << "ERROR: Could not read file" << args[2] << endl;
-      }
-      else
-      {
-        check(input);
-      }
+      options.ssa = true;
     }
-
-    else if (args[1] == "--ir")
+    else if (arg == "--profile")
     {
-      if (input->fail())
-      {
-        cout << "ERROR: Could not read file" << args[2] << endl;
-      }
-      else
+      options.profile = true;
+    }
+    else if (arg == "--time-phases")
+    {
+      options.time_phases = true;
+    }
+    else if (arg == "--mem-stats")
+    {
+      options.mem_stats = true;
+    }
+    else if (arg == "--perf-counters")
+    {
+      options.perf_counters = true;
+    }
+    else if (arg == "--sample")
+    {
+      options.sample_rate = 1000;
+    }
+    else if (arg.starts_with("--sample="))
+    {
+      options.sample_rate = atoi(arg.substr(9).c_str());
+      if (options.sample_rate <= 0)
       {
-        ir(input);
+        usage();
+        return 1;
       }
     }
+    else if (arg.starts_with("--") and mode == "")
+    {
+      mode = arg;
+    }
+    else if (!arg.starts_with("--") and file_name == "")
+    {
+      file_name = arg;
+    }
+    else
+    {
+      // Too many modes or files were given
+      usage();
+      return 1;
+    }
+  }
+
+  if (mode == "--help")
+  {
+    usage();
+    return 0;
   }
 
-  // Here we see if the amount of arguments is 2 then we know it is a user input not a file
-  if (argc == 2)
+  // Setting input to &cin so that it will read the input the user enters, otherwise to the file
+  input = &cin;
+  if (file_name != "")
   {
-    input = &cin;
-    if (args[1] == "--lex")
+    input = new ifstream(file_name);
+    // Checking to see if the file is valid
+    if (input->fail())
     {
-      lex(input);
+      cout << "ERROR: Could not read file" << file_name << endl;
+      return 1;
     }
+  }
 
-    else if (args[1] == "--parse")
+  // Incremental builds keep their cache next to the script, so they need a file
+  if (options.incremental)
+  {
+    if (file_name == "")
     {
-      parse(input);
+      cout << "ERROR: --incremental requires a script file" << endl;
+      return 1;
     }
+    options.cache_file = file_name + ".cache";
+  }
 
-    else if (args[1] == "--print")
+  // The profile also goes next to the script (or the current directory for stdin)
+  options.profile_file = (file_name == "" ? "mypl" : file_name) + ".profile.json";
+  options.sample_file = (file_name == "" ? "mypl" : file_name) + ".folded";
+
+  if (mode == "--lex")
+  {
+    lex(input);
+  }
+  else if (mode == "--parse")
+  {
+    parse(input);
+  }
+  else if (mode == "--print")
+  {
+    print(input);
+  }
+  else if (mode == "--check")
+  {
+    check(input);
+  }
+  else if (mode == "--ir")
+  {
+    ir(input);
+  }
+  else if (mode == "")
+  {
+    normalMode(input);
+  }
+  else
+  {
+    usage();
+    return 1;
+  }
+}
+
+// Generates code for the program into the vm, going through the build cache for incremental builds
+void generate(Program &p, VM &vm)
+{
+  if (options.ssa)
+  {
+    SSAProgram ssa_program = build_ssa(p);
+    begin_phase("codegen");
+    SSALowering(ssa_program).lower(vm);
+  }
+  else if (options.incremental)
+  {
+    BuildCache cache(options.cache_file);
+    if (options.inline_calls)
     {
-      print(input);
+      cache.enable_inlining();
     }
-
-    else if (args[1] == "--check")
+    if (options.hoist_loops)
     {
-      check(input);
+      cache.enable_loop_hoisting();
     }
-
-    else if (args[1] == "--ir")
+    // Checking happens inside the build, only for the rebuilt functions
+    begin_phase("build");
+    cache.build(p, vm);
+    // Reporting on stderr so the program's own output is untouched
+    cerr << "[Incremental] rebuilt " << cache.rebuilt().size() << " of "
+         << (cache.rebuilt().size() + cache.reused().size()) << " functions";
+    for (int i = 0; i < cache.rebuilt().size(); i++)
     {
-      ir(input);
+      cerr << (i == 0 ? ": " : ", ") << cache.rebuilt()[i];
     }
-    else if (args[1] == "--help")
+    cerr << endl;
+  }
+  else
+  {
+    begin_phase("check");
+    SemanticChecker t;
+    p.accept(t);
+    begin_phase("codegen");
+    CodeGenerator g(vm);
+    // Choosing small functions to expand in place of their calls
+    if (options.inline_calls)
     {
-      usage();
+      Inliner inliner;
+      p.accept(inliner);
+      g.enable_inlining(inliner.candidates());
     }
-    else
+    if (options.hoist_loops)
     {
-      // Here is my one case where if argc == 2 then input needs to be set to file because we are in normal mode.
-      input = new ifstream(argv[1]);
-      if (input->fail())
-      {
-        // Instead of reading file args[2] like the rest, the file name is in args[1]
-        cout << "ERROR: Could not read file" << args[1] << endl;
-      }
-      else
-      {
-        normalMode(input);
-      }
+      g.enable_loop_hoisting();
     }
+    p.accept(g);
+  }
+}
+
+// Checks the program and builds its (verified) SSA form
+SSAProgram build_ssa(Program &p)
+{
+  begin_phase("check");
+  SemanticChecker t;
+  p.accept(t);
+  begin_phase("ssa");
+  SSABuilder builder;
+  p.accept(builder);
+  for (const SSAFunction &f : builder.program().functions)
+  {
+    verify(f, builder.program());
   }
+  return builder.program();
 }
 
 // I set up each of the commands into functions, so this one gets the first char and prints it using get().
@@ -253,11 +360,13 @@ void ir(istream *input)
     Lexer lexer(*input);
     ASTParser parser(lexer);
     Program p = parser.parse();
-    SemanticChecker t;
-    p.accept(t);
     VM vm;
-    CodeGenerator g(vm);
-    p.accept(g);
+    // With --ssa the SSA form is shown ahead of the VM code it lowers to
+    if (options.ssa)
+    {
+      cout << to_string(build_ssa(p)) << endl;
+    }
+    generate(p, vm);
     cout << to_string(vm) << endl;
   }
   catch (MyPLException &ex)
@@ -270,22 +379,220 @@ void ir(istream *input)
 void normalMode(istream *input)
 {
   cout << "[Normal Mode]" << endl;
+  PhaseTimer timer;
+  stringstream source;
+  int tokens = 0;
+  if (options.time_phases)
+  {
+    set_alloc_hook(count_allocation);
+    phase_timer = &timer;
+    // Lexing the script once on its own to time it and count the tokens
+    source << input->rdbuf();
+    input = &source;
+    begin_phase("lex");
+    Lexer lexer(source);
+    try
+    {
+      while (lexer.next_token().type() != TokenType::EOS)
+      {
+        tokens++;
+      }
+    }
+    catch (MyPLException &ex)
+    {
+      // The parser reports the error below
+    }
+    timer.end();
+    source.clear();
+    source.seekg(0);
+  }
+  Program p;
+  VM vm;
   try
   {
+    // The parser pulls its tokens from the lexer, so parsing includes lexing
+    begin_phase("parse");
     Lexer lexer(*input);
     ASTParser parser(lexer);
-    Program p = parser.parse();
-    SemanticChecker t;
-    p.accept(t);
-    VM vm;
-    CodeGenerator g(vm);
-    p.accept(g);
-    vm.run();
+    p = parser.parse();
+    timer.end();
+    generate(p, vm);
+    VMProfiler profiler;
+    VMSampler sampler(options.sample_rate > 0 ? options.sample_rate : 1000);
+    if (options.profile)
+    {
+      vm.set_profiler(&profiler);
+    }
+    if (options.sample_rate > 0)
+    {
+      vm.set_sampler(&sampler);
+    }
+    // Only opening the counters when asked, since each is a system call
+    unique_ptr<PerfCounters> counters;
+    if (options.perf_counters)
+    {
+      counters = make_unique<PerfCounters>();
+    }
+    // Reporting the profile and samples even when the program stops on an error
+    begin_phase("run");
+    try
+    {
+      if (counters)
+        counters->start();
+      vm.run();
+      if (counters)
+        counters->stop();
+    }
+    catch (MyPLException &ex)
+    {
+      timer.end();
+      if (counters)
+      {
+        counters->stop();
+        report_perf_counters(*counters);
+      }
+      if (options.profile)
+        report_profile(profiler);
+      if (options.sample_rate > 0)
+        report_samples(sampler);
+      if (options.mem_stats)
+        report_mem_stats(vm);
+      throw;
+    }
+    timer.end();
+    if (counters)
+      report_perf_counters(*counters);
+    if (options.profile)
+      report_profile(profiler);
+    if (options.sample_rate > 0)
+      report_samples(sampler);
+    if (options.mem_stats)
+      report_mem_stats(vm);
   }
   catch (MyPLException &ex)
   {
     cerr << ex.what() << endl;
   }
+  if (options.time_phases)
+  {
+    timer.end();
+    NodeCounter counter;
+    p.accept(counter);
+    report_phases(p, vm, tokens, counter.count());
+    phase_timer = nullptr;
+    set_alloc_hook(nullptr);
+  }
+}
+
+// Starts timing the named phase when --time-phases is on
+void begin_phase(const string &name)
+{
+  if (phase_timer)
+  {
+    phase_timer->begin(name);
+  }
+}
+
+// Prints the hardware counters read around the run on stderr
+void report_perf_counters(const PerfCounters &counters)
+{
+  cout.flush();
+  cerr << endl;
+  if (!counters.available())
+  {
+    cerr << "[Perf] hardware counters unavailable (perf_event_open refused, see "
+         << "/proc/sys/kernel/perf_event_paranoid)" << endl;
+    return;
+  }
+  for (const PerfCounters::Reading &reading : counters.readings())
+  {
+    cerr << "[Perf] " << reading.name << ": ";
+    if (reading.available)
+      cerr << reading.value << endl;
+    else
+      cerr << "n/a" << endl;
+  }
+}
+
+// Prints the vm's memory accounting on stderr
+void report_mem_stats(const VM &vm)
+{
+  VMStats stats = vm.stats();
+  cout.flush();
+  cerr << endl;
+  cerr << "[Memory] structs: " << stats.struct_objects << " objects, " << stats.struct_bytes << " bytes" << endl;
+  cerr << "[Memory] arrays: " << stats.array_objects << " objects, " << stats.array_bytes << " bytes" << endl;
+  if (stats.map_objects)
+    cerr << "[Memory] maps: " << stats.map_objects << " objects, " << stats.map_bytes << " bytes" << endl;
+  if (stats.mapped_bytes)
+    cerr << "[Memory] mapped files: " << stats.mapped_bytes << " bytes" << endl;
+  cerr << "[Memory] heap high-water mark: " << stats.peak_heap_bytes << " bytes" << endl;
+  cerr << "[Memory] strings in frames: " << stats.operand_string_bytes << " bytes on operand stacks, "
+       << stats.variable_string_bytes << " bytes in variables" << endl;
+  cerr << "[Memory] frames: " << stats.frames_allocated << " allocated, " << stats.frame_bytes
+       << " bytes, max call depth " << stats.max_call_depth << endl;
+}
+
+// Prints the phase times and sizes on stderr
+void report_phases(Program &p, VM &vm, int tokens, int nodes)
+{
+  cout.flush();
+  cerr << endl << "[Phases]" << endl;
+  phase_timer->report(cerr);
+  cerr << "[Phases] " << tokens << " tokens, " << nodes << " AST nodes, "
+       << vm.instructions_executed() << " instructions executed" << endl;
+  cerr << "[Phases] instructions generated:";
+  for (int i = 0; i < p.fun_defs.size(); i++)
+  {
+    string name = p.fun_defs[i].fun_name.lexeme();
+    cerr << (i == 0 ? " " : ", ") << name << " ";
+    try
+    {
+      cerr << vm.frame(name).instructions.size();
+    }
+    catch (MyPLException &ex)
+    {
+      // Not generated (the program stopped before code generation)
+      cerr << "-";
+    }
+  }
+  cerr << endl;
+}
+
+// Prints the profile report on stderr and saves the json version
+void report_profile(VMProfiler &profiler)
+{
+  profiler.stop();
+  cout.flush();
+  cerr << endl;
+  profiler.report(cerr);
+  ofstream out(options.profile_file);
+  profiler.write_json(out);
+  if (out.fail())
+  {
+    cerr << "ERROR: Could not write profile to " << options.profile_file << endl;
+  }
+  else
+  {
+    cerr << endl << "[Profile] saved to " << options.profile_file << endl;
+  }
+}
+
+// Saves the sampled call stacks in the folded format of flamegraph tools
+void report_samples(VMSampler &sampler)
+{
+  sampler.stop();
+  cout.flush();
+  ofstream out(options.sample_file);
+  sampler.write_folded(out);
+  if (out.fail())
+  {
+    cerr << "ERROR: Could not write samples to " << options.sample_file << endl;
+  }
+  else
+  {
+    cerr << endl << "[Sample] " << sampler.samples() << " samples saved to " << options.sample_file << endl;
+  }
 }
 
 void usage()
@@ -298,4 +605,13 @@ void usage()
   cout << "--print pretty prints program" << endl;
   cout << "--check statically checks program" << endl;
   cout << "--ir print intermediate (code) representation" << endl;
+  cout << "--no-inline keep calls to small functions instead of inlining them" << endl;
+  cout << "--no-licm keep loop-invariant code inside loops" << endl;
+  cout << "--profile report instruction counts and times (also saved to [script-file].profile.json)" << endl;
+  cout << "--perf-counters report hardware counters (instructions, cycles, misses) for the run" << endl;
+  cout << "--mem-stats report the vm's heap objects, frames, and their sizes" << endl;
+  cout << "--time-phases report the time, allocations, and sizes of each phase" << endl;
+  cout << "--sample[=hz] sample the call stack (default 1000 per second) into [script-file].folded for flamegraphs" << endl;
+  cout << "--ssa generate code through the SSA form (shown by --ir)" << endl;
+  cout << "--incremental reuse code for unchanged functions (cached in [script-file].cache)" << endl;
 }
\ No newline at end of file
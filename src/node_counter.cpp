@@ -0,0 +1,140 @@
+//----------------------------------------------------------------------
+// FILE: node_counter.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: AST node counting
+//----------------------------------------------------------------------
+
+#include "node_counter.h"
+
+using namespace std;
+
+int NodeCounter::count() const
+{
+  return nodes;
+}
+
+void NodeCounter::stmts(vector<shared_ptr<Stmt>> &body)
+{
+  for (auto &s : body)
+    s->accept(*this);
+}
+
+void NodeCounter::visit(Program &p)
+{
+  ++nodes;
+  for (auto &s : p.struct_defs)
+    s.accept(*this);
+  for (auto &f : p.fun_defs)
+    f.accept(*this);
+}
+
+void NodeCounter::visit(FunDef &f)
+{
+  ++nodes;
+  stmts(f.stmts);
+}
+
+void NodeCounter::visit(StructDef &s)
+{
+  ++nodes;
+}
+
+void NodeCounter::visit(ReturnStmt &s)
+{
+  ++nodes;
+  s.expr.accept(*this);
+}
+
+void NodeCounter::visit(WhileStmt &s)
+{
+  ++nodes;
+  s.condition.accept(*this);
+  stmts(s.stmts);
+}
+
+void NodeCounter::visit(ForStmt &s)
+{
+  ++nodes;
+  s.var_decl.accept(*this);
+  s.condition.accept(*this);
+  s.assign_stmt.accept(*this);
+  stmts(s.stmts);
+}
+
+void NodeCounter::visit(IfStmt &s)
+{
+  ++nodes;
+  s.if_part.condition.accept(*this);
+  stmts(s.if_part.stmts);
+  for (auto &else_if : s.else_ifs)
+  {
+    else_if.condition.accept(*this);
+    stmts(else_if.stmts);
+  }
+  stmts(s.else_stmts);
+}
+
+void NodeCounter::visit(VarDeclStmt &s)
+{
+  ++nodes;
+  s.expr.accept(*this);
+}
+
+void NodeCounter::visit(AssignStmt &s)
+{
+  ++nodes;
+  for (auto &ref : s.lvalue)
+    if (ref.array_expr.has_value())
+      ref.array_expr->accept(*this);
+  s.expr.accept(*this);
+}
+
+void NodeCounter::visit(CallExpr &e)
+{
+  ++nodes;
+  for (auto &arg : e.args)
+    arg.accept(*this);
+}
+
+void NodeCounter::visit(Expr &e)
+{
+  ++nodes;
+  e.first->accept(*this);
+  if (e.op.has_value())
+    e.rest->accept(*this);
+}
+
+void NodeCounter::visit(SimpleTerm &t)
+{
+  ++nodes;
+  t.rvalue->accept(*this);
+}
+
+void NodeCounter::visit(ComplexTerm &t)
+{
+  ++nodes;
+  t.expr.accept(*this);
+}
+
+void NodeCounter::visit(SimpleRValue &v)
+{
+  ++nodes;
+}
+
+void NodeCounter::visit(NewRValue &v)
+{
+  ++nodes;
+  if (v.array_expr.has_value())
+    v.array_expr->accept(*this);
+  for (auto &value : v.const_array)
+    value.accept(*this);
+}
+
+void NodeCounter::visit(VarRValue &v)
+{
+  ++nodes;
+  for (auto &ref : v.path)
+    if (ref.array_expr.has_value())
+      ref.array_expr->accept(*this);
+}
@@ -0,0 +1,44 @@
+//----------------------------------------------------------------------
+// FILE: node_counter.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Counts the nodes of an AST (every node with an accept, i.e.,
+// definitions, statements, expressions, terms, and rvalues).
+//----------------------------------------------------------------------
+
+#ifndef NODE_COUNTER_H
+#define NODE_COUNTER_H
+
+#include "ast.h"
+
+class NodeCounter : public Visitor
+{
+public:
+  // the number of nodes visited so far
+  int count() const;
+
+  // visitor functions
+  void visit(Program &p);
+  void visit(FunDef &f);
+  void visit(StructDef &s);
+  void visit(ReturnStmt &s);
+  void visit(WhileStmt &s);
+  void visit(ForStmt &s);
+  void visit(IfStmt &s);
+  void visit(VarDeclStmt &s);
+  void visit(AssignStmt &s);
+  void visit(CallExpr &e);
+  void visit(Expr &e);
+  void visit(SimpleTerm &t);
+  void visit(ComplexTerm &t);
+  void visit(SimpleRValue &v);
+  void visit(NewRValue &v);
+  void visit(VarRValue &v);
+
+private:
+  int nodes = 0;
+
+  void stmts(std::vector<std::shared_ptr<Stmt>> &body);
+};
+
+#endif
@@ -39,10 +39,12 @@ enum class OpCode
   // jump
   JMP,  // [operand] jump to given instruction v
   JMPF, // [operand] pop x, if x is false jump to instruction v
+  JMPT, // [operand] pop x, if x is true jump to instruction v
 
   // functions
   CALL, // [operand] call function v (pop and push args)
   RET,  // return from current function
+  TAILCALL, // [operand] call function v reusing the current frame
 
   // built-ins
   WRITE,  // pop x, write to stdout
@@ -54,16 +56,37 @@ enum class OpCode
   TODBL,  // pop x, push x as a double
   TOSTR,  // pop x, push x as string
   CONCAT, // pop x, pop y, push x + y (string concat)
+  SUBSTR,  // pop n, pop i, pop string x, push the n chars of x from i
+  FIND,    // pop y, pop string x, push index of the first y in x (or -1)
+  SPLIT,   // pop y, pop string x, push oid of a new array of x split at y
+  STARTSW, // pop y, pop string x, push true if x starts with y
   RAND,
+  READALL, // read all of stdin, push it as a string
+  READF,   // pop path x, push the contents of file x
+  READLNS, // pop path x, push oid of a new array of the lines of file x
+  MAPI,    // pop path x, push oid of a read-only array of file x's int32s
+  MAPD,    // pop path x, push oid of a read-only array of file x's doubles
 
   // heap
   ALLOCS, // allocate struct obj, push oid x
-  ALLOCA, // pop x, pop y, allocate array obj with y x values, push oid
+  ALLOCA, // [operand] pop x, pop y, allocate array obj with y x values, push oid
+          // (the optional element type v selects an unboxed store)
+  ALLOCA_CONST, // [operand] allocate array obj from the frame's array constant v, push oid
   ADDF,   // [operand] pop x, add field named v to obj(x)
   SETF,   // [operand] pop x and y, set obj(y).v = x
   GETF,   // [operand] pop x, push value of obj(x).v
   SETI,   // pop x, y, and z, set array obj(z)[y] = x
   GETI,   // pop x and y, push array obj(y)[x] value
+  APPEND, // pop x and y, add x after the last element of array obj(y)
+  APOP,   // pop x, remove the last element of array obj(x), push it
+  ARESIZE, // pop x and y, grow (with nulls) or shrink array obj(y) to x elements
+  ACOPY,  // pop n, i, x, and y, copy array obj(x)[0..n) over obj(y)[i..i+n)
+  ALLOCM, // [operand] allocate map obj with keys of type v, push oid x
+  MGET,   // pop x and y, push map obj(y)[x] value (null if x is missing)
+  MPUT,   // pop x, y, and z, set map obj(z)[y] = x
+  MHAS,   // pop x and y, push true if map obj(y) has key x
+  MDEL,   // pop x and y, remove key x from map obj(y)
+  MKEYS,  // pop x, allocate array obj of map obj(x)'s keys, push oid
 
   // special
   DUP, // pop x, push x, push x
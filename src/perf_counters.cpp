@@ -0,0 +1,148 @@
+//----------------------------------------------------------------------
+// FILE: perf_counters.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Hardware performance counter implementation
+//----------------------------------------------------------------------
+
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+using namespace std;
+
+#ifdef __linux__
+
+namespace {
+
+struct Event
+{
+  const char *name;
+  uint32_t type;
+  uint64_t config;
+};
+
+const Event EVENTS[] = {
+  {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+  {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+  {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  {"L1d-read-misses", PERF_TYPE_HW_CACHE,
+   PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+};
+
+int open_event(const Event &event)
+{
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = event.type;
+  attr.config = event.config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+}
+
+PerfCounters::PerfCounters()
+{
+  for (const Event &event : EVENTS)
+  {
+    fds.push_back(open_event(event));
+    counts.push_back(Reading{event.name});
+  }
+}
+
+PerfCounters::~PerfCounters()
+{
+  for (int fd : fds)
+    if (fd >= 0)
+      close(fd);
+}
+
+void PerfCounters::start()
+{
+  for (int fd : fds)
+  {
+    if (fd < 0)
+      continue;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+void PerfCounters::stop()
+{
+  for (int fd : fds)
+    if (fd >= 0)
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+  for (int i = 0; i < fds.size(); ++i)
+  {
+    // value, time enabled, time running
+    uint64_t data[3] = {0, 0, 0};
+    counts[i].available = fds[i] >= 0 and read(fds[i], data, sizeof(data)) == sizeof(data);
+    counts[i].value = data[0];
+    if (counts[i].available and data[2] > 0 and data[2] < data[1])
+      counts[i].value = (uint64_t)((double)data[0] * data[1] / data[2]);
+  }
+}
+
+#else
+
+PerfCounters::PerfCounters()
+{
+  for (const char *name : {"instructions", "cycles", "branch-misses", "L1d-read-misses"})
+  {
+    fds.push_back(-1);
+    counts.push_back(Reading{name});
+  }
+}
+
+PerfCounters::~PerfCounters()
+{
+}
+
+void PerfCounters::start()
+{
+}
+
+void PerfCounters::stop()
+{
+}
+
+#endif
+
+bool PerfCounters::available() const
+{
+  for (int fd : fds)
+    if (fd >= 0)
+      return true;
+  return false;
+}
+
+const vector<PerfCounters::Reading> &PerfCounters::readings() const
+{
+  return counts;
+}
+
+void PerfCounters::report(ostream &out) const
+{
+  for (const Reading &reading : counts)
+  {
+    out << reading.name << " ";
+    if (reading.available)
+      out << reading.value;
+    else
+      out << "n/a";
+    out << "\n";
+  }
+}
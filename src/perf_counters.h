@@ -0,0 +1,56 @@
+//----------------------------------------------------------------------
+// FILE: perf_counters.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Hardware performance counters (instructions, cycles, branch
+// misses, L1 data cache read misses) read through Linux
+// perf_event_open for this thread. Each counter is opened on its own,
+// so any that the kernel or container refuses are just reported as
+// unavailable (as all of them are on other systems).
+//----------------------------------------------------------------------
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class PerfCounters
+{
+public:
+  struct Reading
+  {
+    std::string name;
+    bool available = false;
+    std::uint64_t value = 0;
+  };
+
+  PerfCounters();
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  // true if at least one counter could be opened
+  bool available() const;
+
+  // reset and count until stop (counts from several start/stop pairs
+  // are not added up)
+  void start();
+  void stop();
+
+  // the counts between the last start and stop, scaled up when the
+  // kernel had to multiplex the counters
+  const std::vector<Reading> &readings() const;
+
+  // "name value" for each counter, n/a for unavailable ones
+  void report(std::ostream &out) const;
+
+private:
+  std::vector<int> fds;
+  std::vector<Reading> counts;
+};
+
+#endif
@@ -0,0 +1,59 @@
+//----------------------------------------------------------------------
+// FILE: phase_timer.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Phase timing implementation
+//----------------------------------------------------------------------
+
+#include <iomanip>
+#include "phase_timer.h"
+
+using namespace std;
+
+void PhaseTimer::begin(const string &name)
+{
+  end();
+  running = true;
+  curr_name = name;
+  start_counts = alloc_counts();
+  started = Clock::now();
+}
+
+void PhaseTimer::end()
+{
+  if (!running)
+    return;
+  Clock::time_point now = Clock::now();
+  AllocCounts counts = alloc_counts();
+  Phase phase{curr_name};
+  phase.ms = chrono::duration<double, milli>(now - started).count();
+  phase.allocations = counts.allocations - start_counts.allocations;
+  phase.bytes = counts.bytes - start_counts.bytes;
+  ended.push_back(phase);
+  running = false;
+}
+
+const vector<PhaseTimer::Phase> &PhaseTimer::phases() const
+{
+  return ended;
+}
+
+void PhaseTimer::report(ostream &out) const
+{
+  Phase total{"total"};
+  out << left << setw(10) << "phase" << right << setw(12) << "ms"
+      << setw(12) << "allocs" << setw(14) << "bytes" << "\n";
+  auto line = [&out](const Phase &phase) {
+    out << left << setw(10) << phase.name << right << fixed << setprecision(3)
+        << setw(12) << phase.ms << setw(12) << phase.allocations
+        << setw(14) << phase.bytes << "\n";
+  };
+  for (const Phase &phase : ended)
+  {
+    line(phase);
+    total.ms += phase.ms;
+    total.allocations += phase.allocations;
+    total.bytes += phase.bytes;
+  }
+  line(total);
+}
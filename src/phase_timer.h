@@ -0,0 +1,53 @@
+//----------------------------------------------------------------------
+// FILE: phase_timer.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Times the phases of a run (lex, parse, check, ...) one after
+// the other, with the allocations counted during each (when the
+// count_allocation hook is installed).
+//----------------------------------------------------------------------
+
+#ifndef PHASE_TIMER_H
+#define PHASE_TIMER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "alloc_hook.h"
+
+class PhaseTimer
+{
+public:
+  struct Phase
+  {
+    std::string name;
+    double ms = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+  };
+
+  // end the current phase (if any) and start the named one
+  void begin(const std::string &name);
+
+  // end the current phase
+  void end();
+
+  // the ended phases in order
+  const std::vector<Phase> &phases() const;
+
+  // one line per phase plus the total
+  void report(std::ostream &out) const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::vector<Phase> ended;
+  bool running = false;
+  std::string curr_name;
+  Clock::time_point started;
+  AllocCounts start_counts;
+};
+
+#endif
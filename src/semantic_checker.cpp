@@ -15,7 +15,12 @@ using namespace std;
 // hash table of names of the base data types and built-in functions
 const unordered_set<string> BASE_TYPES{"int", "double", "char", "string", "bool"};
 const unordered_set<string> BUILT_INS{"print", "input", "to_string", "to_int",
-                                      "to_double", "length", "get", "concat"};
+                                      "to_double", "length", "get", "concat",
+                                      "read_all", "read_file", "read_lines",
+                                      "mmap_ints", "mmap_doubles", "substr", "index_of",
+                                      "split", "starts_with", "append", "pop",
+                                      "resize", "copy", "map_get", "map_put", "map_has",
+                                      "map_remove", "map_keys"};
 
 // helper functions
 
@@ -28,6 +33,14 @@ optional<VarDef> SemanticChecker::get_field(const StructDef &struct_def,
   return nullopt;
 }
 
+bool SemanticChecker::valid_map_type(const DataType &data_type)
+{
+  if (!data_type.is_map())
+    return false;
+  string value_type = data_type.value_type();
+  return BASE_TYPES.contains(value_type) or struct_defs.contains(value_type);
+}
+
 void SemanticChecker::error(const string &msg, const Token &token)
 {
   string s = msg;
@@ -79,7 +92,13 @@ void SemanticChecker::visit(Program &p)
     d.accept(*this);
   // check each function
   for (FunDef &d : p.fun_defs)
-    d.accept(*this);
+    if (!checked_funs.has_value() or checked_funs->contains(d.fun_name.lexeme()))
+      d.accept(*this);
+}
+
+void SemanticChecker::check_only(const unordered_set<string> &fun_names)
+{
+  checked_funs = fun_names;
 }
 
 void SemanticChecker::visit(SimpleRValue &v)
@@ -106,7 +125,7 @@ void SemanticChecker::visit(FunDef &f)
   DataType return_type = f.return_type;
   if (return_type.type_name != "int" && return_type.type_name != "string" && return_type.type_name != "char" && return_type.type_name != "double" && return_type.type_name != "void" && return_type.type_name != "bool")
   {
-    if (!struct_defs.contains(return_type.type_name))
+    if (!struct_defs.contains(return_type.type_name) && !valid_map_type(return_type))
     {
       error("Return type is invalid");
     }
@@ -119,7 +138,7 @@ void SemanticChecker::visit(FunDef &f)
     }
     if (f.params[i].data_type.type_name != "int" && f.params[i].data_type.type_name != "double" && f.params[i].data_type.type_name != "string" && f.params[i].data_type.type_name != "char" && f.params[i].data_type.type_name != "bool")
     {
-      if (!symbol_table.name_exists(f.params[i].data_type.type_name) && !struct_defs.contains(f.params[i].data_type.type_name))
+      if (!symbol_table.name_exists(f.params[i].data_type.type_name) && !struct_defs.contains(f.params[i].data_type.type_name) && !valid_map_type(f.params[i].data_type))
       {
         error("Invalid parameter type", f.params[i].var_name);
       }
@@ -152,7 +171,7 @@ void SemanticChecker::visit(StructDef &s)
   {
     if (s.fields[i].data_type.type_name != "int" && s.fields[i].data_type.type_name != "double" && s.fields[i].data_type.type_name != "string" && s.fields[i].data_type.type_name != "char" && s.fields[i].data_type.type_name != "bool")
     {
-      if (!symbol_table.name_exists(s.fields[i].data_type.type_name) && (!struct_defs.contains(s.fields[i].data_type.type_name)))
+      if (!symbol_table.name_exists(s.fields[i].data_type.type_name) && (!struct_defs.contains(s.fields[i].data_type.type_name)) && !valid_map_type(s.fields[i].data_type))
       {
         error("Invalid parameter type", s.fields[i].var_name);
       }
@@ -262,7 +281,7 @@ void SemanticChecker::visit(VarDeclStmt &s)
 {
   if (s.var_def.data_type.type_name != "int" && s.var_def.data_type.type_name != "string" && s.var_def.data_type.type_name != "char" && s.var_def.data_type.type_name != "double" && s.var_def.data_type.type_name != "bool")
   {
-    if ((!struct_defs.contains(s.var_def.data_type.type_name)))
+    if ((!struct_defs.contains(s.var_def.data_type.type_name)) && !valid_map_type(s.var_def.data_type))
     {
       error("Invalid data type type", s.var_def.var_name);
     }
@@ -358,6 +377,10 @@ void SemanticChecker::visit(CallExpr &e)
     {
       error("Invalid parameter for argument cannot have an array", e.first_token());
     }
+    if (curr_type.is_map())
+    {
+      error("Cannot print type map", e.first_token());
+    }
     curr_type = {false, "void"};
   }
   else if (fun_name == "input")
@@ -368,6 +391,191 @@ void SemanticChecker::visit(CallExpr &e)
     }
     curr_type = {false, "string"};
   }
+  else if (fun_name == "read_all")
+  {
+    if (e.args.size() != 0)
+    {
+      error("Invalid number of parameters", e.first_token());
+    }
+    curr_type = {false, "string"};
+  }
+  else if (fun_name == "read_file" or fun_name == "read_lines")
+  {
+    if (e.args.size() != 1)
+    {
+      error("Invalid number of parameters", e.first_token());
+    }
+    e.args[0].accept(*this);
+    if (curr_type.type_name != "string" || curr_type.is_array)
+    {
+      error("Invalid parameter for argument, expecting a file path string", e.first_token());
+    }
+    curr_type = {fun_name == "read_lines", "string"};
+  }
+  else if (fun_name == "mmap_ints" or fun_name == "mmap_doubles")
+  {
+    if (e.args.size() != 1)
+    {
+      error("Invalid number of parameters", e.first_token());
+    }
+    e.args[0].accept(*this);
+    if (curr_type.type_name != "string" || curr_type.is_array)
+    {
+      error("Invalid parameter for argument, expecting a file path string", e.first_token());
+    }
+    curr_type = {true, fun_name == "mmap_ints" ? "int" : "double"};
+  }
+  else if (fun_name == "substr")
+  {
+    if (e.args.size() != 3)
+    {
+      error("Invalid number of parameters", e.first_token());
+    }
+    e.args[0].accept(*this);
+    if (curr_type.type_name != "string" || curr_type.is_array)
+    {
+      error("Invalid parameter for argument, expecting a string", e.first_token());
+    }
+    for (int i = 1; i < 3; i++)
+    {
+      e.args[i].accept(*this);
+      if (curr_type.type_name != "int" || curr_type.is_array)
+      {
+        error("Invalid parameter for argument, expecting an int", e.first_token());
+      }
+    }
+    curr_type = {false, "string"};
+  }
+  else if (fun_name == "index_of" or fun_name == "split" or fun_name == "starts_with")
+  {
+    if (e.args.size() != 2)
+    {
+      error("Invalid number of parameters", e.first_token());
+    }
+    e.args[0].accept(*this);
+    if (curr_type.type_name != "string" || curr_type.is_array)
+    {
+      error("Invalid parameter for argument, expecting a string", e.first_token());
+    }
+    e.args[1].accept(*this);
+    if ((curr_type.type_name != "string" && curr_type.type_name != "char") || curr_type.is_array)
+    {
+      error("Invalid parameter for argument, expecting a string or char", e.first_token());
+    }
+    if (fun_name == "index_of")
+    {
+      curr_type = {false, "int"};
+    }
+    else if (fun_name == "split")
+    {
+      curr_type = {true, "string"};
+    }
+    else
+    {
+      curr_type = {false, "bool"};
+    }
+  }
+  else if (fun_name == "append" or fun_name == "pop" or fun_name == "resize")
+  {
+    if (e.args.size() != (fun_name == "pop" ? 1 : 2))
+    {
+      error("Invalid number of parameters", e.first_token());
+    }
+    e.args[0].accept(*this);
+    if (!curr_type.is_array)
+    {
+      error("Invalid parameter for argument, expecting an array", e.first_token());
+    }
+    string element_type = curr_type.type_name;
+    if (fun_name == "append")
+    {
+      e.args[1].accept(*this);
+      if (curr_type.is_array || (curr_type.type_name != element_type && curr_type.type_name != "void"))
+      {
+        error("Invalid parameter for argument, expecting a " + element_type + " value", e.first_token());
+      }
+    }
+    else if (fun_name == "resize")
+    {
+      e.args[1].accept(*this);
+      if (curr_type.type_name != "int" || curr_type.is_array)
+      {
+        error("Invalid parameter for argument, expecting an int", e.first_token());
+      }
+    }
+    curr_type = {false, fun_name == "pop" ? element_type : "void"};
+  }
+  else if (fun_name == "copy")
+  {
+    if (e.args.size() != 4)
+    {
+      error("Invalid number of parameters", e.first_token());
+    }
+    e.args[0].accept(*this);
+    DataType dst_type = curr_type;
+    e.args[1].accept(*this);
+    if (!dst_type.is_array || !curr_type.is_array || curr_type.type_name != dst_type.type_name)
+    {
+      error("Invalid parameter for argument, expecting two arrays of the same type", e.first_token());
+    }
+    for (int i = 2; i < 4; i++)
+    {
+      e.args[i].accept(*this);
+      if (curr_type.type_name != "int" || curr_type.is_array)
+      {
+        error("Invalid parameter for argument, expecting an int", e.first_token());
+      }
+    }
+    curr_type = {false, "void"};
+  }
+  else if (fun_name == "map_get" or fun_name == "map_put" or fun_name == "map_has" or
+           fun_name == "map_remove" or fun_name == "map_keys")
+  {
+    int arg_count = fun_name == "map_keys" ? 1 : (fun_name == "map_put" ? 3 : 2);
+    if (e.args.size() != arg_count)
+    {
+      error("Invalid number of parameters", e.first_token());
+    }
+    e.args[0].accept(*this);
+    if (!curr_type.is_map())
+    {
+      error("Invalid parameter for argument, expecting a map", e.first_token());
+    }
+    string key_type = curr_type.key_type();
+    string value_type = curr_type.value_type();
+    if (fun_name != "map_keys")
+    {
+      e.args[1].accept(*this);
+      if (curr_type.is_array || curr_type.type_name != key_type)
+      {
+        error("Invalid parameter for argument, expecting a " + key_type + " key", e.first_token());
+      }
+    }
+    if (fun_name == "map_put")
+    {
+      e.args[2].accept(*this);
+      if (curr_type.is_array || (curr_type.type_name != value_type && curr_type.type_name != "void"))
+      {
+        error("Invalid parameter for argument, expecting a " + value_type + " value", e.first_token());
+      }
+    }
+    if (fun_name == "map_get")
+    {
+      curr_type = {false, value_type};
+    }
+    else if (fun_name == "map_has")
+    {
+      curr_type = {false, "bool"};
+    }
+    else if (fun_name == "map_keys")
+    {
+      curr_type = {true, key_type};
+    }
+    else
+    {
+      curr_type = {false, "void"};
+    }
+  }
   else if (fun_name == "to_string")
   {
     if (e.args.size() != 1)
@@ -606,6 +814,15 @@ void SemanticChecker::visit(ComplexTerm &t)
 
 void SemanticChecker::visit(NewRValue &v)
 {
+  if (v.type.type() == TokenType::MAP)
+  {
+    curr_type = {false, v.type.lexeme()};
+    if (!valid_map_type(curr_type))
+    {
+      error("Invalid data type type", v.type);
+    }
+    return;
+  }
   if (v.type.lexeme() != "int" && v.type.lexeme() != "string" && v.type.lexeme() != "char" && v.type.lexeme() != "double" && v.type.lexeme() != "bool")
   {
     if (!symbol_table.name_exists(v.type.lexeme()) && (!struct_defs.contains(v.type.lexeme())))
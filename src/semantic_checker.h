@@ -8,7 +8,9 @@
 #ifndef SEMANTIC_CHECKER_H
 #define SEMANTIC_CHECKER_H
 
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
 #include "ast.h"
 #include "symbol_table.h"
 
@@ -33,7 +35,14 @@ public:
   void visit(NewRValue &v);
   void visit(VarRValue &v);
 
+  // only check the bodies of the given functions (all definitions are
+  // still registered so calls to the others are typed correctly)
+  void check_only(const std::unordered_set<std::string> &fun_names);
+
 private:
+  // functions whose bodies are checked (all when empty)
+  std::optional<std::unordered_set<std::string>> checked_funs;
+
   // symbol table
   SymbolTable symbol_table;
 
@@ -50,6 +59,9 @@ private:
   std::optional<VarDef> get_field(const StructDef &struct_def,
                                   const std::string &field_name);
 
+  // true if the type is a map of a base or struct value type
+  bool valid_map_type(const DataType &data_type);
+
   // error helper functions
   void error(const std::string &msg, const Token &token);
   void error(const std::string &msg);
@@ -144,6 +144,18 @@ void SimpleParser::data_type()
     else
       base_type();
   }
+  else if (match(TokenType::MAP))
+    map_type();
+  else
+    base_type();
+}
+
+void SimpleParser::map_type()
+{
+  eat(TokenType::MAP, "Expecting MAP");
+  base_type();
+  if (match(TokenType::ID))
+    advance();
   else
     base_type();
 }
@@ -162,7 +174,7 @@ void SimpleParser::base_type()
 
 void SimpleParser::stmt()
 {
-  if (match(TokenType::DOUBLE_TYPE) || match(TokenType::INT_TYPE) || match(TokenType::STRING_TYPE) || match(TokenType::CHAR_TYPE) || match(TokenType::BOOL_TYPE) || match(TokenType::ARRAY))
+  if (match(TokenType::DOUBLE_TYPE) || match(TokenType::INT_TYPE) || match(TokenType::STRING_TYPE) || match(TokenType::CHAR_TYPE) || match(TokenType::BOOL_TYPE) || match(TokenType::ARRAY) || match(TokenType::MAP))
   {
     vdecl_stmt();
   }
@@ -376,7 +388,9 @@ void SimpleParser::rvalue()
 void SimpleParser::new_rvalue()
 {
   eat(TokenType::NEW, "Expecting NEW");
-  if (match(TokenType::ID))
+  if (match(TokenType::MAP))
+    map_type();
+  else if (match(TokenType::ID))
   {
     advance();
     if (match(TokenType::LBRACKET))
@@ -40,6 +40,7 @@ private:
   void fields();
   void params();
   void data_type();
+  void map_type();
   void base_type();
   void stmt();
   void vdecl_stmt();
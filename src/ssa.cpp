@@ -0,0 +1,479 @@
+//----------------------------------------------------------------------
+// FILE: ssa.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: SSA helpers, verifier, and pretty printer
+//----------------------------------------------------------------------
+
+#include <algorithm>
+#include <unordered_map>
+#include "mypl_exception.h"
+#include "ssa.h"
+
+using namespace std;
+
+bool produces_value(const SSAInstr &instr)
+{
+  if (instr.kind != SSAKind::OP)
+    return true;
+  return instr.op != OpCode::WRITE and instr.op != OpCode::SETF and
+         instr.op != OpCode::SETI and instr.op != OpCode::APPEND and
+         instr.op != OpCode::ARESIZE and instr.op != OpCode::ACOPY and
+         instr.op != OpCode::MPUT and instr.op != OpCode::MDEL;
+}
+
+bool has_side_effects(const SSAInstr &instr)
+{
+  if (instr.kind == SSAKind::NEW_STRUCT)
+    return true;
+  if (instr.kind != SSAKind::OP)
+    return false;
+  switch (instr.op)
+  {
+  case OpCode::CALL:
+  case OpCode::WRITE:
+  case OpCode::READ:
+  case OpCode::READALL:
+  case OpCode::READF:
+  case OpCode::READLNS:
+  case OpCode::MAPI:
+  case OpCode::MAPD:
+  case OpCode::SPLIT:
+  case OpCode::RAND:
+  case OpCode::SETF:
+  case OpCode::SETI:
+  case OpCode::ALLOCA:
+  case OpCode::APPEND:
+  case OpCode::APOP:
+  case OpCode::ARESIZE:
+  case OpCode::ACOPY:
+  case OpCode::ALLOCM:
+  case OpCode::MPUT:
+  case OpCode::MDEL:
+  case OpCode::MKEYS:
+    return true;
+  default:
+    return false;
+  }
+}
+
+VMInstr make_instr(OpCode op, const VMValue &operand)
+{
+  switch (op)
+  {
+  case OpCode::PUSH: return VMInstr::PUSH(operand);
+  case OpCode::POP: return VMInstr::POP();
+  case OpCode::LOAD: return VMInstr::LOAD(get<int>(operand));
+  case OpCode::STORE: return VMInstr::STORE(get<int>(operand));
+  case OpCode::ADD: return VMInstr::ADD();
+  case OpCode::SUB: return VMInstr::SUB();
+  case OpCode::MUL: return VMInstr::MUL();
+  case OpCode::DIV: return VMInstr::DIV();
+  case OpCode::AND: return VMInstr::AND();
+  case OpCode::OR: return VMInstr::OR();
+  case OpCode::NOT: return VMInstr::NOT();
+  case OpCode::CMPLT: return VMInstr::CMPLT();
+  case OpCode::CMPLE: return VMInstr::CMPLE();
+  case OpCode::CMPGT: return VMInstr::CMPGT();
+  case OpCode::CMPGE: return VMInstr::CMPGE();
+  case OpCode::CMPEQ: return VMInstr::CMPEQ();
+  case OpCode::CMPNE: return VMInstr::CMPNE();
+  case OpCode::RAND: return VMInstr::RAND();
+  case OpCode::JMP: return VMInstr::JMP(get<int>(operand));
+  case OpCode::JMPF: return VMInstr::JMPF(get<int>(operand));
+  case OpCode::JMPT: return VMInstr::JMPT(get<int>(operand));
+  case OpCode::CALL: return VMInstr::CALL(get<VMString>(operand).str());
+  case OpCode::RET: return VMInstr::RET();
+  case OpCode::TAILCALL: return VMInstr::TAILCALL(get<VMString>(operand).str());
+  case OpCode::WRITE: return VMInstr::WRITE();
+  case OpCode::READ: return VMInstr::READ();
+  case OpCode::READALL: return VMInstr::READALL();
+  case OpCode::READF: return VMInstr::READF();
+  case OpCode::READLNS: return VMInstr::READLNS();
+  case OpCode::MAPI: return VMInstr::MAPI();
+  case OpCode::MAPD: return VMInstr::MAPD();
+  case OpCode::SLEN: return VMInstr::SLEN();
+  case OpCode::ALEN: return VMInstr::ALEN();
+  case OpCode::GETC: return VMInstr::GETC();
+  case OpCode::TOINT: return VMInstr::TOINT();
+  case OpCode::TODBL: return VMInstr::TODBL();
+  case OpCode::TOSTR: return VMInstr::TOSTR();
+  case OpCode::CONCAT: return VMInstr::CONCAT();
+  case OpCode::SUBSTR: return VMInstr::SUBSTR();
+  case OpCode::FIND: return VMInstr::FIND();
+  case OpCode::SPLIT: return VMInstr::SPLIT();
+  case OpCode::STARTSW: return VMInstr::STARTSW();
+  case OpCode::ALLOCS: return VMInstr::ALLOCS();
+  case OpCode::ALLOCA:
+    if (holds_alternative<VMString>(operand))
+      return VMInstr::ALLOCA(get<VMString>(operand).str());
+    return VMInstr::ALLOCA();
+  case OpCode::ADDF: return VMInstr::ADDF(get<VMString>(operand).str());
+  case OpCode::SETF: return VMInstr::SETF(get<VMString>(operand).str());
+  case OpCode::GETF: return VMInstr::GETF(get<VMString>(operand).str());
+  case OpCode::SETI: return VMInstr::SETI();
+  case OpCode::GETI: return VMInstr::GETI();
+  case OpCode::APPEND: return VMInstr::APPEND();
+  case OpCode::APOP: return VMInstr::APOP();
+  case OpCode::ARESIZE: return VMInstr::ARESIZE();
+  case OpCode::ACOPY: return VMInstr::ACOPY();
+  case OpCode::ALLOCM: return VMInstr::ALLOCM(get<VMString>(operand).str());
+  case OpCode::MGET: return VMInstr::MGET();
+  case OpCode::MPUT: return VMInstr::MPUT();
+  case OpCode::MHAS: return VMInstr::MHAS();
+  case OpCode::MDEL: return VMInstr::MDEL();
+  case OpCode::MKEYS: return VMInstr::MKEYS();
+  case OpCode::DUP: return VMInstr::DUP();
+  default: return VMInstr::NOP();
+  }
+}
+
+//----------------------------------------------------------------------
+// Verifier
+//----------------------------------------------------------------------
+
+namespace {
+
+class Verifier
+{
+public:
+  Verifier(const SSAFunction &f, const SSAProgram &p) : f(f), p(p) {}
+
+  void run()
+  {
+    if (f.blocks.empty())
+      error("no entry block");
+    check_blocks();
+    check_definitions();
+    compute_dominators();
+    check_uses();
+    check_types();
+  }
+
+private:
+  const SSAFunction &f;
+  const SSAProgram &p;
+
+  // where each value is defined: (block, index)
+  unordered_map<int, pair<int, int>> defs;
+
+  // dominators of each block
+  vector<vector<bool>> dom;
+
+  void error(const string &msg) const
+  {
+    throw MyPLException("SSA Error: " + msg + " in function '" + f.name + "'");
+  }
+
+  string block_name(int b) const
+  {
+    return "b" + std::to_string(b);
+  }
+
+  void check_blocks()
+  {
+    vector<vector<int>> preds(f.blocks.size());
+    for (int b = 0; b < f.blocks.size(); ++b)
+    {
+      const SSABlock &block = f.blocks[b];
+      if (block.id != b)
+        error("block " + block_name(b) + " has id " + std::to_string(block.id));
+      const SSATerminator &term = block.term;
+      int expected = 0;
+      if (term.kind == SSATermKind::NONE)
+        error("block " + block_name(b) + " is not terminated");
+      else if (term.kind == SSATermKind::JUMP)
+        expected = 1;
+      else if (term.kind == SSATermKind::BRANCH)
+        expected = 2;
+      if (term.targets.size() != expected)
+        error("bad number of targets from " + block_name(b));
+      for (int t : term.targets)
+      {
+        if (t < 0 or t >= f.blocks.size())
+          error("jump to missing block from " + block_name(b));
+        if (t == 0)
+          error("jump to the entry block from " + block_name(b));
+        preds[t].push_back(b);
+      }
+    }
+    for (int b = 0; b < f.blocks.size(); ++b)
+    {
+      vector<int> expected = preds[b];
+      vector<int> actual = f.blocks[b].preds;
+      sort(expected.begin(), expected.end());
+      sort(actual.begin(), actual.end());
+      if (expected != actual)
+        error("wrong predecessors for " + block_name(b));
+      // phis come first and take one argument per predecessor
+      bool past_phis = false;
+      for (const SSAInstr &instr : f.blocks[b].instrs)
+      {
+        if (instr.kind != SSAKind::PHI)
+        {
+          past_phis = true;
+          continue;
+        }
+        if (past_phis)
+          error("phi %" + std::to_string(instr.id) + " after other instructions");
+        vector<int> from = instr.blocks;
+        sort(from.begin(), from.end());
+        if (instr.args.size() != instr.blocks.size() or from != actual)
+          error("phi %" + std::to_string(instr.id) + " does not match the predecessors of " + block_name(b));
+      }
+    }
+  }
+
+  void check_definitions()
+  {
+    for (const SSABlock &block : f.blocks)
+      for (int i = 0; i < block.instrs.size(); ++i)
+      {
+        int id = block.instrs[i].id;
+        if (id < 0 or id >= f.value_count)
+          error("value %" + std::to_string(id) + " out of range");
+        if (defs.contains(id))
+          error("value %" + std::to_string(id) + " defined more than once");
+        defs[id] = {block.id, i};
+        if (block.instrs[i].kind == SSAKind::PARAM and block.id != 0)
+          error("parameter outside the entry block");
+      }
+  }
+
+  // iterative dominator sets (functions are small)
+  void compute_dominators()
+  {
+    int n = f.blocks.size();
+    dom.assign(n, vector<bool>(n, true));
+    dom[0].assign(n, false);
+    dom[0][0] = true;
+    bool changed = true;
+    while (changed)
+    {
+      changed = false;
+      for (int b = 1; b < n; ++b)
+      {
+        vector<bool> d(n, !f.blocks[b].preds.empty());
+        for (int pred : f.blocks[b].preds)
+          for (int i = 0; i < n; ++i)
+            d[i] = d[i] and dom[pred][i];
+        d[b] = true;
+        if (d != dom[b])
+        {
+          dom[b] = d;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  // the value must be available at the given index of the block
+  void check_use(int value, int block, int index)
+  {
+    if (!defs.contains(value))
+      error("use of undefined value %" + std::to_string(value));
+    auto [def_block, def_index] = defs[value];
+    if (def_block == block ? def_index >= index : !dom[block][def_block])
+      error("definition of %" + std::to_string(value) + " does not dominate its use in " + block_name(block));
+  }
+
+  void check_uses()
+  {
+    for (const SSABlock &block : f.blocks)
+    {
+      for (int i = 0; i < block.instrs.size(); ++i)
+      {
+        const SSAInstr &instr = block.instrs[i];
+        for (int j = 0; j < instr.args.size(); ++j)
+        {
+          // phi arguments are used at the end of the predecessor
+          if (instr.kind == SSAKind::PHI)
+            check_use(instr.args[j], instr.blocks[j], f.blocks[instr.blocks[j]].instrs.size());
+          else
+            check_use(instr.args[j], block.id, i);
+        }
+      }
+      if (block.term.kind == SSATermKind::BRANCH or block.term.kind == SSATermKind::RETURN)
+        check_use(block.term.value, block.id, block.instrs.size());
+    }
+  }
+
+  const DataType &type_of(int value)
+  {
+    auto [b, i] = defs[value];
+    return f.blocks[b].instrs[i].type;
+  }
+
+  // null (void) may stand in for any type
+  bool compatible(const DataType &t1, const DataType &t2)
+  {
+    if (t1.type_name == "void" or t2.type_name == "void")
+      return true;
+    return t1.is_array == t2.is_array and t1.type_name == t2.type_name;
+  }
+
+  const StructDef *struct_def(const DataType &t)
+  {
+    for (const StructDef &s : p.struct_defs)
+      if (!t.is_array and s.struct_name.lexeme() == t.type_name)
+        return &s;
+    return nullptr;
+  }
+
+  void check_field(const SSAInstr &instr)
+  {
+    const DataType &t = type_of(instr.args[0]);
+    if (t.type_name == "void")
+      return;
+    const StructDef *s = struct_def(t);
+    if (!s)
+      error("field access on non-struct %" + std::to_string(instr.args[0]));
+    string field = get<VMString>(instr.value).str();
+    for (const VarDef &v : s->fields)
+      if (v.var_name.lexeme() == field)
+        return;
+    error("struct " + t.type_name + " has no field " + field);
+  }
+
+  void check_types()
+  {
+    for (const SSABlock &block : f.blocks)
+    {
+      for (const SSAInstr &instr : block.instrs)
+      {
+        string name = "%" + std::to_string(instr.id);
+        if (instr.kind == SSAKind::PHI)
+        {
+          for (int arg : instr.args)
+            if (!compatible(type_of(arg), instr.type))
+              error("phi " + name + " has argument %" + std::to_string(arg) + " of another type");
+        }
+        else if (instr.kind == SSAKind::OP)
+        {
+          OpCode op = instr.op;
+          if (op == OpCode::ADD or op == OpCode::SUB or op == OpCode::MUL or op == OpCode::DIV)
+          {
+            if (!compatible(type_of(instr.args[0]), type_of(instr.args[1])))
+              error("mismatched operand types for " + name);
+          }
+          else if (op == OpCode::GETF or op == OpCode::SETF)
+            check_field(instr);
+          else if (op == OpCode::GETI or op == OpCode::SETI)
+          {
+            const DataType &t = type_of(instr.args[0]);
+            if (!t.is_array and t.type_name != "void")
+              error("element access on non-array for " + name);
+            if (!compatible(type_of(instr.args[1]), DataType{false, "int"}))
+              error("non-int index for " + name);
+          }
+        }
+      }
+      const SSATerminator &term = block.term;
+      if (term.kind == SSATermKind::BRANCH and !compatible(type_of(term.value), DataType{false, "bool"}))
+        error("non-bool branch condition in " + block_name(block.id));
+      if (term.kind == SSATermKind::RETURN and f.return_type.type_name != "void" and
+          !compatible(type_of(term.value), f.return_type))
+        error("returned value of the wrong type in " + block_name(block.id));
+    }
+  }
+};
+
+}
+
+void verify(const SSAFunction &f, const SSAProgram &p)
+{
+  Verifier(f, p).run();
+}
+
+//----------------------------------------------------------------------
+// Pretty printer
+//----------------------------------------------------------------------
+
+string to_string(const DataType &t)
+{
+  return (t.is_array ? "array " : "") + t.type_name;
+}
+
+string value_name(int id)
+{
+  return "%" + to_string(id);
+}
+
+string to_string(const SSAInstr &instr)
+{
+  string s = "  ";
+  if (produces_value(instr))
+    s += value_name(instr.id) + ": " + to_string(instr.type) + " = ";
+  if (instr.kind == SSAKind::CONST)
+  {
+    if (holds_alternative<VMString>(instr.value))
+      return s + "const \"" + get<VMString>(instr.value).str() + "\"";
+    if (holds_alternative<char>(instr.value))
+      return s + "const '" + to_string(instr.value) + "'";
+    return s + "const " + to_string(instr.value);
+  }
+  if (instr.kind == SSAKind::PARAM)
+    return s + "param " + to_string(instr.value);
+  if (instr.kind == SSAKind::NEW_STRUCT)
+    return s + "new " + get<VMString>(instr.value).str();
+  if (instr.kind == SSAKind::PHI)
+  {
+    s += "phi";
+    for (int i = 0; i < instr.args.size(); ++i)
+      s += " [" + value_name(instr.args[i]) + ", b" + to_string(instr.blocks[i]) + "]";
+    return s;
+  }
+  string op = to_string(make_instr(instr.op, instr.value));
+  if (op.ends_with("()"))
+    op = op.substr(0, op.size() - 2);
+  s += op;
+  for (int arg : instr.args)
+    s += " " + value_name(arg);
+  return s;
+}
+
+string to_string(const SSAFunction &f)
+{
+  string s = "function " + f.name + "(";
+  for (int i = 0; i < f.param_types.size(); ++i)
+    s += (i ? ", " : "") + to_string(f.param_types[i]);
+  s += ") -> " + to_string(f.return_type) + "\n";
+  for (const SSABlock &block : f.blocks)
+  {
+    s += "b" + to_string(block.id) + ":";
+    if (!block.preds.empty())
+    {
+      s += "  // preds";
+      for (int pred : block.preds)
+        s += " b" + to_string(pred);
+    }
+    s += "\n";
+    for (const SSAInstr &instr : block.instrs)
+      s += to_string(instr) + "\n";
+    const SSATerminator &term = block.term;
+    if (term.kind == SSATermKind::JUMP)
+      s += "  jmp b" + to_string(term.targets[0]) + "\n";
+    else if (term.kind == SSATermKind::BRANCH)
+      s += "  br " + value_name(term.value) + " b" + to_string(term.targets[0]) +
+           " b" + to_string(term.targets[1]) + "\n";
+    else if (term.kind == SSATermKind::RETURN)
+      s += "  ret " + value_name(term.value) + "\n";
+  }
+  return s;
+}
+
+string to_string(const SSAProgram &p)
+{
+  string s = "";
+  for (const StructDef &def : p.struct_defs)
+  {
+    s += "struct " + def.struct_name.lexeme() + " {";
+    for (int i = 0; i < def.fields.size(); ++i)
+      s += string(i ? ", " : "") + def.fields[i].var_name.lexeme() + ": " +
+           to_string(def.fields[i].data_type);
+    s += "}\n";
+  }
+  for (const SSAFunction &f : p.functions)
+    s += "\n" + to_string(f);
+  return s;
+}
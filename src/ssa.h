@@ -0,0 +1,129 @@
+//----------------------------------------------------------------------
+// FILE: ssa.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Typed SSA intermediate representation that sits between the
+// AST and the VM instructions. A function is a list of basic blocks
+// ending in a terminator; every instruction defines one value (%n),
+// variables are resolved to values (joined by phi nodes), and struct
+// fields and array elements are read and written by explicit
+// GETF/SETF/GETI/SETI instructions.
+//----------------------------------------------------------------------
+
+#ifndef SSA_H
+#define SSA_H
+
+#include <string>
+#include <vector>
+#include "ast.h"
+#include "vm_instr.h"
+
+// the kinds of SSA instructions
+enum class SSAKind
+{
+  CONST,      // the constant in value
+  PARAM,      // the parameter whose index is in value
+  PHI,        // args[i] is the value coming from predecessor blocks[i]
+  OP,         // the VM operation op applied to args (operand in value)
+  NEW_STRUCT  // a new struct (named in value) with null fields
+};
+
+class SSAInstr
+{
+public:
+  // the value defined by the instruction
+  int id;
+
+  SSAKind kind;
+
+  // the VM operation for OP instructions
+  OpCode op = OpCode::NOP;
+
+  // constant, parameter index, field, function, or struct name
+  VMValue value = nullptr;
+
+  // values used, in the order the VM operation expects them pushed
+  std::vector<int> args;
+
+  // predecessor block of each phi argument
+  std::vector<int> blocks;
+
+  // the type of the defined value ("void" for no value or null)
+  DataType type;
+};
+
+// the kinds of block terminators
+enum class SSATermKind
+{
+  NONE,    // not yet terminated (only while building)
+  JUMP,    // go to targets[0]
+  BRANCH,  // go to targets[0] if value is true, else targets[1]
+  RETURN   // return value
+};
+
+class SSATerminator
+{
+public:
+  SSATermKind kind = SSATermKind::NONE;
+  int value = -1;
+  std::vector<int> targets;
+};
+
+class SSABlock
+{
+public:
+  // the index of the block within its function
+  int id;
+
+  // phi nodes first, then the remaining instructions
+  std::vector<SSAInstr> instrs;
+
+  SSATerminator term;
+
+  // blocks whose terminators target this block
+  std::vector<int> preds;
+};
+
+class SSAFunction
+{
+public:
+  std::string name;
+  std::vector<DataType> param_types;
+  DataType return_type;
+
+  // the entry block is blocks[0]
+  std::vector<SSABlock> blocks;
+
+  // the number of value ids handed out (%0 to %(value_count-1))
+  int value_count = 0;
+};
+
+class SSAProgram
+{
+public:
+  std::vector<StructDef> struct_defs;
+  std::vector<SSAFunction> functions;
+};
+
+// true if the instruction leaves a value for its users (e.g., not
+// WRITE, SETF, or SETI)
+bool produces_value(const SSAInstr &instr);
+
+// true if the instruction does more than compute its value
+bool has_side_effects(const SSAInstr &instr);
+
+// the VM instruction for the given operation and operand
+VMInstr make_instr(OpCode op, const VMValue &operand);
+
+// check that the function is well formed: terminated blocks that
+// agree with their predecessor lists, phis matching predecessors,
+// definitions that dominate their uses, and consistent types (throws
+// MyPLException on the first problem found)
+void verify(const SSAFunction &f, const SSAProgram &p);
+
+// pretty print the program, function, or type
+std::string to_string(const SSAProgram &p);
+std::string to_string(const SSAFunction &f);
+std::string to_string(const DataType &t);
+
+#endif
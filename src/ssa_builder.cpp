@@ -0,0 +1,657 @@
+//----------------------------------------------------------------------
+// FILE: ssa_builder.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: SSA construction from the AST
+//----------------------------------------------------------------------
+
+#include <algorithm>
+#include "mypl_exception.h"
+#include "ssa_builder.h"
+
+using namespace std;
+
+// VM operations for the binary operators
+const unordered_map<string, OpCode> BINARY_OPS = {
+  {"+", OpCode::ADD}, {"-", OpCode::SUB}, {"*", OpCode::MUL},
+  {"/", OpCode::DIV},
+  {"<", OpCode::CMPLT}, {"<=", OpCode::CMPLE}, {">", OpCode::CMPGT},
+  {">=", OpCode::CMPGE}, {"==", OpCode::CMPEQ}, {"!=", OpCode::CMPNE}};
+
+// VM operations and result types for the built-in functions
+const unordered_map<string, pair<OpCode, string>> BUILT_IN_OPS = {
+  {"print", {OpCode::WRITE, "void"}}, {"input", {OpCode::READ, "string"}},
+  {"get", {OpCode::GETC, "char"}}, {"length", {OpCode::SLEN, "int"}},
+  {"length_array", {OpCode::ALEN, "int"}},
+  {"to_string", {OpCode::TOSTR, "string"}},
+  {"to_int", {OpCode::TOINT, "int"}}, {"to_double", {OpCode::TODBL, "double"}},
+  {"concat", {OpCode::CONCAT, "string"}}, {"rand_int", {OpCode::RAND, "int"}},
+  {"read_all", {OpCode::READALL, "string"}}, {"read_file", {OpCode::READF, "string"}},
+  {"read_lines", {OpCode::READLNS, "string"}}, {"mmap_ints", {OpCode::MAPI, "int"}},
+  {"mmap_doubles", {OpCode::MAPD, "double"}}, {"substr", {OpCode::SUBSTR, "string"}},
+  {"index_of", {OpCode::FIND, "int"}}, {"split", {OpCode::SPLIT, "string"}},
+  {"starts_with", {OpCode::STARTSW, "bool"}}, {"append", {OpCode::APPEND, "void"}},
+  {"pop", {OpCode::APOP, ""}}, {"resize", {OpCode::ARESIZE, "void"}},
+  {"copy", {OpCode::ACOPY, "void"}}, {"map_get", {OpCode::MGET, ""}},
+  {"map_put", {OpCode::MPUT, "void"}}, {"map_has", {OpCode::MHAS, "bool"}},
+  {"map_remove", {OpCode::MDEL, "void"}}, {"map_keys", {OpCode::MKEYS, ""}}};
+
+// replace escape sequences the same way the code generator does
+string unescape(string s)
+{
+  vector<pair<string, string>> escapes = {{"\\n", "\n"}, {"\\t", "\t"}};
+  for (auto &[from, to] : escapes)
+    for (size_t i = s.find(from); i != string::npos; i = s.find(from, i + to.size()))
+      s.replace(i, from.size(), to);
+  return s;
+}
+
+const SSAProgram &SSABuilder::program() const
+{
+  return ssa_program;
+}
+
+//----------------------------------------------------------------------
+// Construction helpers
+//----------------------------------------------------------------------
+
+int SSABuilder::emit(SSAKind kind, OpCode op, const VMValue &value, const vector<int> &args, const DataType &type)
+{
+  SSAInstr instr{curr_fun.value_count++, kind, op, value, args, {}, type};
+  curr_fun.blocks[curr_block].instrs.push_back(instr);
+  value_types.push_back(type);
+  return instr.id;
+}
+
+int SSABuilder::emit_op(OpCode op, const vector<int> &args, const DataType &type, const VMValue &value)
+{
+  return emit(SSAKind::OP, op, value, args, type);
+}
+
+int SSABuilder::value_of(Expr &e)
+{
+  e.accept(*this);
+  return curr_value;
+}
+
+int SSABuilder::new_block()
+{
+  int id = curr_fun.blocks.size();
+  curr_fun.blocks.push_back(SSABlock{id});
+  block_defs.push_back({});
+  return id;
+}
+
+void SSABuilder::jump(int target)
+{
+  SSATerminator &term = curr_fun.blocks[curr_block].term;
+  if (term.kind != SSATermKind::NONE)
+    return;
+  term = SSATerminator{SSATermKind::JUMP, -1, {target}};
+  curr_fun.blocks[target].preds.push_back(curr_block);
+}
+
+void SSABuilder::branch(int cond, int if_true, int if_false)
+{
+  SSATerminator &term = curr_fun.blocks[curr_block].term;
+  if (term.kind != SSATermKind::NONE)
+    return;
+  term = SSATerminator{SSATermKind::BRANCH, cond, {if_true, if_false}};
+  curr_fun.blocks[if_true].preds.push_back(curr_block);
+  curr_fun.blocks[if_false].preds.push_back(curr_block);
+}
+
+void SSABuilder::ret(int value)
+{
+  SSATerminator &term = curr_fun.blocks[curr_block].term;
+  if (term.kind == SSATermKind::NONE)
+    term = SSATerminator{SSATermKind::RETURN, value, {}};
+}
+
+void SSABuilder::dead_block()
+{
+  curr_block = new_block();
+  seal(curr_block);
+}
+
+int SSABuilder::declare(const string &name, const DataType &type)
+{
+  int var = var_types.size();
+  var_types.push_back(type);
+  scopes.back()[name] = var;
+  return var;
+}
+
+int SSABuilder::lookup(const string &name) const
+{
+  for (int i = scopes.size() - 1; i >= 0; --i)
+    if (scopes[i].contains(name))
+      return scopes[i].at(name);
+  throw MyPLException("SSA Error: undefined variable '" + name + "'");
+}
+
+DataType SSABuilder::field_type(const DataType &t, const string &field) const
+{
+  if (!t.is_array and struct_defs.contains(t.type_name))
+    for (const VarDef &v : struct_defs.at(t.type_name).fields)
+      if (v.var_name.lexeme() == field)
+        return DataType{v.data_type.is_array, v.data_type.type_name};
+  return DataType{false, "void"};
+}
+
+//----------------------------------------------------------------------
+// On-the-fly SSA construction
+//----------------------------------------------------------------------
+
+void SSABuilder::write_var(int var, int block, int value)
+{
+  block_defs[block][var] = value;
+}
+
+int SSABuilder::read_var(int var, int block)
+{
+  if (block_defs[block].contains(var))
+    return block_defs[block][var];
+  return read_var_recursive(var, block);
+}
+
+int SSABuilder::read_var_recursive(int var, int block)
+{
+  SSABlock &b = curr_fun.blocks[block];
+  int value;
+  if (!sealed.contains(block))
+  {
+    // more predecessors may still be added (a loop header)
+    value = new_phi(block, var);
+    incomplete_phis[block].push_back({var, value});
+  }
+  else if (b.preds.empty())
+  {
+    // only in unreachable code, which is removed later
+    SSAInstr null_value{curr_fun.value_count++, SSAKind::CONST, OpCode::NOP, nullptr, {}, {}, DataType{false, "void"}};
+    b.instrs.insert(b.instrs.begin(), null_value);
+    value_types.push_back(null_value.type);
+    value = null_value.id;
+  }
+  else if (b.preds.size() == 1)
+    value = read_var(var, b.preds[0]);
+  else
+  {
+    // the phi is recorded first to break cycles through loops
+    value = new_phi(block, var);
+    write_var(var, block, value);
+    add_phi_operands(var, value, block);
+  }
+  write_var(var, block, value);
+  return value;
+}
+
+int SSABuilder::new_phi(int block, int var)
+{
+  vector<SSAInstr> &instrs = curr_fun.blocks[block].instrs;
+  SSAInstr phi{curr_fun.value_count++, SSAKind::PHI, OpCode::NOP, nullptr, {}, {}, var_types[var]};
+  auto pos = instrs.begin();
+  while (pos != instrs.end() and pos->kind == SSAKind::PHI)
+    ++pos;
+  instrs.insert(pos, phi);
+  value_types.push_back(phi.type);
+  return phi.id;
+}
+
+void SSABuilder::add_phi_operands(int var, int phi, int block)
+{
+  vector<int> preds = curr_fun.blocks[block].preds;
+  for (int pred : preds)
+  {
+    int value = read_var(var, pred);
+    // reading may have added instructions, so the phi is found again
+    for (SSAInstr &instr : curr_fun.blocks[block].instrs)
+      if (instr.id == phi)
+      {
+        instr.args.push_back(value);
+        instr.blocks.push_back(pred);
+      }
+  }
+}
+
+void SSABuilder::seal(int block)
+{
+  vector<pair<int, int>> phis = incomplete_phis[block];
+  for (auto [var, phi] : phis)
+    add_phi_operands(var, phi, block);
+  incomplete_phis.erase(block);
+  sealed.insert(block);
+}
+
+void SSABuilder::clean_up()
+{
+  vector<SSABlock> &blocks = curr_fun.blocks;
+
+  // lay blocks out in reverse postorder (the true branch of each
+  // branch first), dropping those that cannot be reached
+  vector<int> postorder;
+  vector<bool> visited(blocks.size(), false);
+  vector<pair<int, int>> stack = {{0, 0}};
+  visited[0] = true;
+  while (!stack.empty())
+  {
+    auto &[block, next] = stack.back();
+    const vector<int> &targets = blocks[block].term.targets;
+    if (next < targets.size())
+    {
+      int target = targets[targets.size() - 1 - next++];
+      if (!visited[target])
+      {
+        visited[target] = true;
+        stack.push_back({target, 0});
+      }
+    }
+    else
+    {
+      postorder.push_back(block);
+      stack.pop_back();
+    }
+  }
+  vector<int> new_id(blocks.size(), -1);
+  for (int i = 0; i < postorder.size(); ++i)
+    new_id[postorder[postorder.size() - 1 - i]] = i;
+
+  vector<SSABlock> laid_out(postorder.size());
+  for (int old = 0; old < blocks.size(); ++old)
+  {
+    if (new_id[old] < 0)
+      continue;
+    SSABlock block = blocks[old];
+    block.id = new_id[old];
+    for (int &target : block.term.targets)
+      target = new_id[target];
+    vector<int> preds;
+    for (int pred : block.preds)
+      if (new_id[pred] >= 0)
+        preds.push_back(new_id[pred]);
+    block.preds = preds;
+    for (SSAInstr &instr : block.instrs)
+    {
+      if (instr.kind != SSAKind::PHI)
+        continue;
+      SSAInstr phi = instr;
+      phi.args.clear();
+      phi.blocks.clear();
+      for (int i = 0; i < instr.args.size(); ++i)
+        if (new_id[instr.blocks[i]] >= 0)
+        {
+          phi.args.push_back(instr.args[i]);
+          phi.blocks.push_back(new_id[instr.blocks[i]]);
+        }
+      instr = phi;
+    }
+    laid_out[block.id] = block;
+  }
+  blocks = laid_out;
+
+  // a phi whose arguments are all one value (or itself) is that value
+  bool changed = true;
+  while (changed)
+  {
+    changed = false;
+    for (SSABlock &block : blocks)
+    {
+      for (int i = 0; i < block.instrs.size() and !changed; ++i)
+      {
+        SSAInstr &phi = block.instrs[i];
+        if (phi.kind != SSAKind::PHI)
+          continue;
+        int same = -1;
+        bool trivial = true;
+        for (int arg : phi.args)
+        {
+          if (arg == phi.id or arg == same)
+            continue;
+          if (same != -1)
+            trivial = false;
+          same = arg;
+        }
+        if (!trivial or same == -1)
+          continue;
+        int old = phi.id;
+        block.instrs.erase(block.instrs.begin() + i);
+        for (SSABlock &b : blocks)
+        {
+          for (SSAInstr &instr : b.instrs)
+            replace(instr.args.begin(), instr.args.end(), old, same);
+          if (b.term.value == old)
+            b.term.value = same;
+        }
+        changed = true;
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+// Top-level
+//----------------------------------------------------------------------
+
+void SSABuilder::visit(Program &p)
+{
+  for (auto &s : p.struct_defs)
+    s.accept(*this);
+  for (auto &f : p.fun_defs)
+    return_types[f.fun_name.lexeme()] = DataType{f.return_type.is_array, f.return_type.type_name};
+  for (auto &f : p.fun_defs)
+    f.accept(*this);
+}
+
+void SSABuilder::visit(StructDef &s)
+{
+  struct_defs[s.struct_name.lexeme()] = s;
+  ssa_program.struct_defs.push_back(s);
+}
+
+void SSABuilder::visit(FunDef &f)
+{
+  curr_fun = SSAFunction{f.fun_name.lexeme()};
+  curr_fun.return_type = DataType{f.return_type.is_array, f.return_type.type_name};
+  value_types.clear();
+  var_types.clear();
+  block_defs.clear();
+  sealed.clear();
+  incomplete_phis.clear();
+  scopes = {{}};
+  curr_block = new_block();
+  seal(curr_block);
+  for (int i = 0; i < f.params.size(); ++i)
+  {
+    DataType type{f.params[i].data_type.is_array, f.params[i].data_type.type_name};
+    curr_fun.param_types.push_back(type);
+    int value = emit(SSAKind::PARAM, OpCode::NOP, i, {}, type);
+    write_var(declare(f.params[i].var_name.lexeme(), type), curr_block, value);
+  }
+  for (auto &s : f.stmts)
+    s->accept(*this);
+  // falling off the end returns null
+  if (curr_fun.blocks[curr_block].term.kind == SSATermKind::NONE)
+    ret(emit(SSAKind::CONST, OpCode::NOP, nullptr, {}, DataType{false, "void"}));
+  clean_up();
+  ssa_program.functions.push_back(curr_fun);
+}
+
+//----------------------------------------------------------------------
+// Statements
+//----------------------------------------------------------------------
+
+void SSABuilder::visit(ReturnStmt &s)
+{
+  ret(value_of(s.expr));
+  dead_block();
+}
+
+void SSABuilder::visit(WhileStmt &s)
+{
+  int header = new_block();
+  jump(header);
+  curr_block = header;
+  int cond = value_of(s.condition);
+  int body = new_block();
+  int exit = new_block();
+  branch(cond, body, exit);
+  seal(body);
+  seal(exit);
+  curr_block = body;
+  scopes.push_back({});
+  for (auto &stmt : s.stmts)
+    stmt->accept(*this);
+  scopes.pop_back();
+  jump(header);
+  seal(header);
+  curr_block = exit;
+}
+
+void SSABuilder::visit(ForStmt &s)
+{
+  scopes.push_back({});
+  s.var_decl.accept(*this);
+  int header = new_block();
+  jump(header);
+  curr_block = header;
+  int cond = value_of(s.condition);
+  int body = new_block();
+  int exit = new_block();
+  branch(cond, body, exit);
+  seal(body);
+  seal(exit);
+  curr_block = body;
+  scopes.push_back({});
+  for (auto &stmt : s.stmts)
+    stmt->accept(*this);
+  scopes.pop_back();
+  s.assign_stmt.accept(*this);
+  jump(header);
+  seal(header);
+  scopes.pop_back();
+  curr_block = exit;
+}
+
+void SSABuilder::visit(IfStmt &s)
+{
+  int join = new_block();
+  vector<BasicIf *> parts = {&s.if_part};
+  for (auto &else_if : s.else_ifs)
+    parts.push_back(&else_if);
+  for (BasicIf *part : parts)
+  {
+    int cond = value_of(part->condition);
+    int then_block = new_block();
+    int next_block = new_block();
+    branch(cond, then_block, next_block);
+    seal(then_block);
+    seal(next_block);
+    curr_block = then_block;
+    scopes.push_back({});
+    for (auto &stmt : part->stmts)
+      stmt->accept(*this);
+    scopes.pop_back();
+    jump(join);
+    curr_block = next_block;
+  }
+  scopes.push_back({});
+  for (auto &stmt : s.else_stmts)
+    stmt->accept(*this);
+  scopes.pop_back();
+  jump(join);
+  seal(join);
+  curr_block = join;
+}
+
+void SSABuilder::visit(VarDeclStmt &s)
+{
+  int value = value_of(s.expr);
+  DataType type{s.var_def.data_type.is_array, s.var_def.data_type.type_name};
+  write_var(declare(s.var_def.var_name.lexeme(), type), curr_block, value);
+}
+
+void SSABuilder::visit(AssignStmt &s)
+{
+  int var = lookup(s.lvalue[0].var_name.lexeme());
+  if (s.lvalue.size() == 1 and !s.lvalue[0].array_expr.has_value())
+  {
+    write_var(var, curr_block, value_of(s.expr));
+    return;
+  }
+  // walk the path, storing into the last field or element (evaluating
+  // index expressions before the assigned value, like the VM code)
+  int obj = read_var(var, curr_block);
+  for (int i = 0; i < s.lvalue.size(); ++i)
+  {
+    VarRef &ref = s.lvalue[i];
+    bool last = i == s.lvalue.size() - 1;
+    string name = ref.var_name.lexeme();
+    if (i != 0)
+    {
+      if (last and !ref.array_expr.has_value())
+      {
+        emit_op(OpCode::SETF, {obj, value_of(s.expr)}, DataType{false, "void"}, name);
+        return;
+      }
+      obj = emit_op(OpCode::GETF, {obj}, field_type(value_types[obj], name), name);
+    }
+    if (ref.array_expr.has_value())
+    {
+      int index = value_of(*ref.array_expr);
+      if (last)
+      {
+        emit_op(OpCode::SETI, {obj, index, value_of(s.expr)}, DataType{false, "void"});
+        return;
+      }
+      obj = emit_op(OpCode::GETI, {obj, index}, DataType{false, value_types[obj].type_name});
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+// Expressions
+//----------------------------------------------------------------------
+
+void SSABuilder::visit(CallExpr &e)
+{
+  string fun_name = e.fun_name.lexeme();
+  vector<int> args;
+  for (auto &arg : e.args)
+    args.push_back(value_of(arg));
+  if (BUILT_IN_OPS.contains(fun_name))
+  {
+    auto [op, type] = BUILT_IN_OPS.at(fun_name);
+    bool is_array = op == OpCode::READLNS or op == OpCode::MAPI or op == OpCode::MAPD or
+      op == OpCode::SPLIT;
+    // pop gives an element of its array, and a map's values and keys
+    // have the types in its name
+    if (op == OpCode::APOP)
+      type = value_types[args[0]].type_name;
+    else if (op == OpCode::MGET)
+      type = value_types[args[0]].value_type();
+    else if (op == OpCode::MKEYS)
+    {
+      is_array = true;
+      type = value_types[args[0]].key_type();
+    }
+    curr_value = emit_op(op, args, DataType{is_array, type});
+  }
+  else
+    curr_value = emit_op(OpCode::CALL, args, return_types[fun_name], fun_name);
+}
+
+void SSABuilder::visit(Expr &e)
+{
+  e.first->accept(*this);
+  if (e.op.has_value() and (e.op->lexeme() == "and" or e.op->lexeme() == "or"))
+  {
+    // short circuit: the rest is only evaluated (in its own block) when
+    // the first operand does not decide the expression, and the result
+    // is merged through an unnamed variable
+    DataType type{false, "bool"};
+    int var = var_types.size();
+    var_types.push_back(type);
+    write_var(var, curr_block, curr_value);
+    int rest_block = new_block();
+    int join = new_block();
+    if (e.op->lexeme() == "and")
+      branch(curr_value, rest_block, join);
+    else
+      branch(curr_value, join, rest_block);
+    seal(rest_block);
+    curr_block = rest_block;
+    write_var(var, curr_block, value_of(*e.rest));
+    jump(join);
+    seal(join);
+    curr_block = join;
+    curr_value = read_var(var, curr_block);
+  }
+  else if (e.op.has_value())
+  {
+    int lhs = curr_value;
+    int rhs = value_of(*e.rest);
+    OpCode op = BINARY_OPS.at(e.op->lexeme());
+    DataType type{false, "bool"};
+    if (op == OpCode::ADD or op == OpCode::SUB or op == OpCode::MUL or op == OpCode::DIV)
+      type = value_types[lhs].type_name != "void" ? value_types[lhs] : value_types[rhs];
+    curr_value = emit_op(op, {lhs, rhs}, type);
+  }
+  if (e.negated)
+    curr_value = emit_op(OpCode::NOT, {curr_value}, DataType{false, "bool"});
+}
+
+void SSABuilder::visit(SimpleTerm &t)
+{
+  t.rvalue->accept(*this);
+}
+
+void SSABuilder::visit(ComplexTerm &t)
+{
+  t.expr.accept(*this);
+}
+
+void SSABuilder::visit(SimpleRValue &v)
+{
+  string lexeme = v.value.lexeme();
+  TokenType type = v.value.type();
+  if (type == TokenType::INT_VAL)
+    curr_value = emit(SSAKind::CONST, OpCode::NOP, stoi(lexeme), {}, DataType{false, "int"});
+  else if (type == TokenType::DOUBLE_VAL)
+    curr_value = emit(SSAKind::CONST, OpCode::NOP, stod(lexeme), {}, DataType{false, "double"});
+  else if (type == TokenType::STRING_VAL)
+    curr_value = emit(SSAKind::CONST, OpCode::NOP, VMString::intern(unescape(lexeme)), {}, DataType{false, "string"});
+  else if (type == TokenType::CHAR_VAL)
+  {
+    string c = unescape(lexeme);
+    VMValue value = c.size() == 1 ? VMValue(c[0]) : VMValue(c);
+    curr_value = emit(SSAKind::CONST, OpCode::NOP, value, {}, DataType{false, "char"});
+  }
+  else if (type == TokenType::BOOL_VAL)
+    curr_value = emit(SSAKind::CONST, OpCode::NOP, lexeme == "true", {}, DataType{false, "bool"});
+  else
+    curr_value = emit(SSAKind::CONST, OpCode::NOP, nullptr, {}, DataType{false, "void"});
+}
+
+void SSABuilder::visit(NewRValue &v)
+{
+  string type_name = v.type.lexeme();
+  if (v.type.type() == TokenType::MAP)
+  {
+    DataType type{false, type_name};
+    curr_value = emit_op(OpCode::ALLOCM, {}, type, type.key_type());
+  }
+  else if (v.array_expr.has_value() or !v.const_array.empty())
+  {
+    DataType type{true, type_name};
+    int size = v.array_expr.has_value() ? value_of(*v.array_expr) :
+      emit(SSAKind::CONST, OpCode::NOP, (int)v.const_array.size(), {}, DataType{false, "int"});
+    int init = emit(SSAKind::CONST, OpCode::NOP, nullptr, {}, DataType{false, "void"});
+    int array = emit_op(OpCode::ALLOCA, {size, init}, type, type_name);
+    for (int i = 0; i < v.const_array.size(); ++i)
+    {
+      int index = emit(SSAKind::CONST, OpCode::NOP, i, {}, DataType{false, "int"});
+      v.const_array[i].accept(*this);
+      emit_op(OpCode::SETI, {array, index, curr_value}, DataType{false, "void"});
+    }
+    curr_value = array;
+  }
+  else
+    curr_value = emit(SSAKind::NEW_STRUCT, OpCode::NOP, type_name, {}, DataType{false, type_name});
+}
+
+void SSABuilder::visit(VarRValue &v)
+{
+  int value = read_var(lookup(v.path[0].var_name.lexeme()), curr_block);
+  for (int i = 0; i < v.path.size(); ++i)
+  {
+    VarRef &ref = v.path[i];
+    if (i != 0)
+      value = emit_op(OpCode::GETF, {value}, field_type(value_types[value], ref.var_name.lexeme()), ref.var_name.lexeme());
+    if (ref.array_expr.has_value())
+    {
+      int index = value_of(*ref.array_expr);
+      value = emit_op(OpCode::GETI, {value, index}, DataType{false, value_types[value].type_name});
+    }
+  }
+  curr_value = value;
+}
@@ -0,0 +1,113 @@
+//----------------------------------------------------------------------
+// FILE: ssa_builder.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Builds the SSA form of a (semantically checked) program. Uses
+// on-the-fly SSA construction: each variable read is resolved to the
+// value reaching it, placing phis at joins and loop headers (loop
+// headers are sealed once their back edges are known), and trivial
+// phis and unreachable blocks are removed at the end of each function.
+//----------------------------------------------------------------------
+
+#ifndef SSA_BUILDER_H
+#define SSA_BUILDER_H
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+#include "ssa.h"
+
+class SSABuilder : public Visitor
+{
+public:
+  // the program built so far
+  const SSAProgram &program() const;
+
+  // top-level
+  void visit(Program &p);
+  void visit(FunDef &f);
+  void visit(StructDef &s);
+  // statements
+  void visit(ReturnStmt &s);
+  void visit(WhileStmt &s);
+  void visit(ForStmt &s);
+  void visit(IfStmt &s);
+  void visit(VarDeclStmt &s);
+  void visit(AssignStmt &s);
+  void visit(CallExpr &e);
+  void visit(Expr &e);
+  void visit(SimpleTerm &t);
+  void visit(ComplexTerm &t);
+  void visit(SimpleRValue &v);
+  void visit(NewRValue &v);
+  void visit(VarRValue &v);
+
+private:
+  SSAProgram ssa_program;
+
+  // struct definitions and function return types
+  std::unordered_map<std::string, StructDef> struct_defs;
+  std::unordered_map<std::string, DataType> return_types;
+
+  // the function and block being built
+  SSAFunction curr_fun;
+  int curr_block = 0;
+
+  // the value of the last visited expression
+  int curr_value = -1;
+
+  // the type of every value of the current function
+  std::vector<DataType> value_types;
+
+  // variable ids by name for each scope, and each variable's type
+  std::vector<std::unordered_map<std::string, int>> scopes;
+  std::vector<DataType> var_types;
+
+  // the value of each variable at the end of each block
+  std::vector<std::unordered_map<int, int>> block_defs;
+
+  // blocks whose predecessors are all known, and the phis waiting
+  // for the predecessors of the others (variable, phi)
+  std::unordered_set<int> sealed;
+  std::unordered_map<int, std::vector<std::pair<int, int>>> incomplete_phis;
+
+  // add an instruction to the current block, returning its value
+  int emit(SSAKind kind, OpCode op, const VMValue &value, const std::vector<int> &args, const DataType &type);
+  int emit_op(OpCode op, const std::vector<int> &args, const DataType &type, const VMValue &value = nullptr);
+
+  // evaluate the expression, returning its value
+  int value_of(Expr &e);
+
+  // create a block (nothing targets it yet)
+  int new_block();
+
+  // end the current block (unless already ended)
+  void jump(int target);
+  void branch(int cond, int if_true, int if_false);
+  void ret(int value);
+
+  // continue in a fresh block that nothing jumps to
+  void dead_block();
+
+  // variable scopes
+  int declare(const std::string &name, const DataType &type);
+  int lookup(const std::string &name) const;
+
+  // on-the-fly SSA construction
+  void write_var(int var, int block, int value);
+  int read_var(int var, int block);
+  int read_var_recursive(int var, int block);
+  int new_phi(int block, int var);
+  void add_phi_operands(int var, int phi, int block);
+  void seal(int block);
+
+  // remove unreachable blocks and trivial phis, renumbering blocks
+  void clean_up();
+
+  // type of the field of a struct value
+  DataType field_type(const DataType &t, const std::string &field) const;
+};
+
+#endif
@@ -0,0 +1,229 @@
+//----------------------------------------------------------------------
+// FILE: ssa_lowering.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: SSA to VM instruction lowering
+//----------------------------------------------------------------------
+
+#include "ssa_lowering.h"
+
+using namespace std;
+
+SSALowering::SSALowering(const SSAProgram &p)
+  : program(p)
+{
+}
+
+void SSALowering::lower(VM &vm)
+{
+  for (const SSAFunction &f : program.functions)
+    vm.add(lower(f));
+}
+
+VMFrameInfo SSALowering::lower(const SSAFunction &f)
+{
+  fun = &f;
+  frame = VMFrameInfo{f.name, (int)f.param_types.size()};
+  defs.clear();
+  use_counts.clear();
+  inlined.clear();
+  slots.clear();
+  block_jumps.clear();
+  next_slot = f.param_types.size();
+
+  for (const SSABlock &block : f.blocks)
+  {
+    for (int i = 0; i < block.instrs.size(); ++i)
+    {
+      const SSAInstr &instr = block.instrs[i];
+      defs[instr.id] = {block.id, i};
+      if (instr.kind == SSAKind::PARAM)
+        slots[instr.id] = get<int>(instr.value);
+      for (int arg : instr.args)
+        ++use_counts[arg];
+    }
+    if (block.term.kind == SSATermKind::BRANCH or block.term.kind == SSATermKind::RETURN)
+      ++use_counts[block.term.value];
+  }
+  for (const SSABlock &block : f.blocks)
+    find_inlined(block);
+
+  // arguments are on the stack with the first one on top
+  for (int i = 0; i < f.param_types.size(); ++i)
+    frame.instructions.push_back(VMInstr::STORE(i));
+  vector<int> block_starts;
+  for (const SSABlock &block : f.blocks)
+  {
+    block_starts.push_back(frame.instructions.size());
+    for (const SSAInstr &instr : block.instrs)
+    {
+      if (instr.kind == SSAKind::PHI or instr.kind == SSAKind::CONST or
+          instr.kind == SSAKind::PARAM or inlined.contains(instr.id))
+        continue;
+      emit(instr);
+      if (!produces_value(instr))
+        continue;
+      if (use_counts[instr.id] == 0)
+        frame.instructions.push_back(VMInstr::POP());
+      else
+        frame.instructions.push_back(VMInstr::STORE(slot(instr.id)));
+    }
+    emit_term(block);
+  }
+  for (auto [index, target] : block_jumps)
+    frame.instructions[index].set_operand(block_starts[target]);
+  frame.local_count = next_slot;
+  return frame;
+}
+
+void SSALowering::find_inlined(const SSABlock &block)
+{
+  // a value can stay on the stack if its user is the next thing
+  // generated, i.e., the instructions between the value and its user
+  // are exactly the (inlined) trees of the user's later arguments
+  const vector<SSAInstr> &instrs = block.instrs;
+  vector<int> tree_start(instrs.size() + 1);
+  for (int user = 0; user <= instrs.size(); ++user)
+  {
+    vector<int> args;
+    if (user < instrs.size())
+    {
+      if (instrs[user].kind != SSAKind::OP and instrs[user].kind != SSAKind::NEW_STRUCT)
+        continue;
+      args = instrs[user].args;
+    }
+    else if (block.term.kind == SSATermKind::BRANCH or block.term.kind == SSATermKind::RETURN)
+      args = {block.term.value};
+    int pos = user - 1;
+    for (int i = args.size() - 1; i >= 0; --i)
+    {
+      const SSAInstr &arg = def(args[i]);
+      // constants are pushed at each use, parameters loaded
+      if (arg.kind == SSAKind::CONST or arg.kind == SSAKind::PARAM)
+        continue;
+      while (pos >= 0 and (instrs[pos].kind == SSAKind::CONST or instrs[pos].kind == SSAKind::PARAM))
+        --pos;
+      if (pos < 0 or defs[arg.id] != make_pair(block.id, pos) or use_counts[arg.id] != 1 or
+          arg.kind == SSAKind::PHI or !produces_value(arg))
+        break;
+      inlined.insert(arg.id);
+      pos = tree_start[pos] - 1;
+    }
+    tree_start[user] = pos + 1;
+  }
+}
+
+const SSAInstr &SSALowering::def(int value) const
+{
+  auto [block, index] = defs.at(value);
+  return fun->blocks[block].instrs[index];
+}
+
+int SSALowering::slot(int value)
+{
+  if (!slots.contains(value))
+    slots[value] = next_slot++;
+  return slots[value];
+}
+
+void SSALowering::push(int value)
+{
+  const SSAInstr &instr = def(value);
+  if (instr.kind == SSAKind::CONST)
+    frame.instructions.push_back(VMInstr::PUSH(instr.value));
+  else if (inlined.contains(value))
+    emit(instr);
+  else
+    frame.instructions.push_back(VMInstr::LOAD(slot(value)));
+}
+
+void SSALowering::emit(const SSAInstr &instr)
+{
+  for (int arg : instr.args)
+    push(arg);
+  if (instr.kind == SSAKind::OP)
+  {
+    frame.instructions.push_back(make_instr(instr.op, instr.value));
+    return;
+  }
+  // a new struct with each field set to null
+  frame.instructions.push_back(VMInstr::ALLOCS());
+  for (const StructDef &s : program.struct_defs)
+  {
+    if (s.struct_name.lexeme() != get<VMString>(instr.value).str())
+      continue;
+    for (const VarDef &field : s.fields)
+    {
+      frame.instructions.push_back(VMInstr::DUP());
+      frame.instructions.push_back(VMInstr::ADDF(field.var_name.lexeme()));
+      frame.instructions.push_back(VMInstr::DUP());
+      frame.instructions.push_back(VMInstr::PUSH(nullptr));
+      frame.instructions.push_back(VMInstr::SETF(field.var_name.lexeme()));
+    }
+  }
+}
+
+void SSALowering::emit_term(const SSABlock &block)
+{
+  const SSATerminator &term = block.term;
+  int next = block.id + 1;
+  if (term.kind == SSATermKind::RETURN)
+  {
+    push(term.value);
+    frame.instructions.push_back(VMInstr::RET());
+  }
+  else if (term.kind == SSATermKind::JUMP)
+  {
+    emit_copies(block.id, term.targets[0]);
+    if (term.targets[0] != next)
+      emit_jump(OpCode::JMP, term.targets[0]);
+  }
+  else if (term.kind == SSATermKind::BRANCH)
+  {
+    int if_true = term.targets[0];
+    int if_false = term.targets[1];
+    bool false_copies = !fun->blocks[if_false].instrs.empty() and
+      fun->blocks[if_false].instrs[0].kind == SSAKind::PHI;
+    push(term.value);
+    int jmpf = frame.instructions.size();
+    if (false_copies)
+      frame.instructions.push_back(VMInstr::JMPF(-1));
+    else
+      emit_jump(OpCode::JMPF, if_false);
+    emit_copies(block.id, if_true);
+    if (if_true != next or false_copies)
+      emit_jump(OpCode::JMP, if_true);
+    if (false_copies)
+    {
+      // the false edge gets its own copies
+      frame.instructions[jmpf].set_operand((int)frame.instructions.size());
+      emit_copies(block.id, if_false);
+      if (if_false != next)
+        emit_jump(OpCode::JMP, if_false);
+    }
+  }
+}
+
+void SSALowering::emit_copies(int from, int to)
+{
+  // all incoming values are pushed before any phi is written, since
+  // one phi may be the incoming value of another
+  vector<int> phis;
+  for (const SSAInstr &instr : fun->blocks[to].instrs)
+  {
+    if (instr.kind != SSAKind::PHI)
+      break;
+    for (int i = 0; i < instr.args.size(); ++i)
+      if (instr.blocks[i] == from)
+        push(instr.args[i]);
+    phis.push_back(instr.id);
+  }
+  for (int i = phis.size() - 1; i >= 0; --i)
+    frame.instructions.push_back(VMInstr::STORE(slot(phis[i])));
+}
+
+void SSALowering::emit_jump(OpCode op, int target_block)
+{
+  block_jumps.push_back({(int)frame.instructions.size(), target_block});
+  frame.instructions.push_back(make_instr(op, -1));
+}
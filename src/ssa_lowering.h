@@ -0,0 +1,75 @@
+//----------------------------------------------------------------------
+// FILE: ssa_lowering.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Lowers SSA functions to VM frames. Values live in their own
+// variable slots, except that a value used once, right where it was
+// computed, stays on the operand stack (so expressions come out much
+// like the direct code generator's). Phis become copies on the
+// incoming edges.
+//----------------------------------------------------------------------
+
+#ifndef SSA_LOWERING_H
+#define SSA_LOWERING_H
+
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "ssa.h"
+#include "vm.h"
+
+class SSALowering
+{
+public:
+  SSALowering(const SSAProgram &p);
+
+  // add the frame of every function to the vm
+  void lower(VM &vm);
+
+  // generate the frame for one function of the program
+  VMFrameInfo lower(const SSAFunction &f);
+
+private:
+  const SSAProgram &program;
+
+  // the function and frame being generated
+  const SSAFunction *fun = nullptr;
+  VMFrameInfo frame;
+
+  // where each value is defined (block, index) and how often it is used
+  std::unordered_map<int, std::pair<int, int>> defs;
+  std::unordered_map<int, int> use_counts;
+
+  // values generated in place at their single use
+  std::unordered_set<int> inlined;
+
+  // variable slot of each stored value
+  std::unordered_map<int, int> slots;
+  int next_slot = 0;
+
+  // jump instructions still to be pointed at the start of a block
+  std::vector<std::pair<int, int>> block_jumps;
+
+  // find the values of the block that can stay on the stack
+  void find_inlined(const SSABlock &block);
+
+  // the instruction defining a value
+  const SSAInstr &def(int value) const;
+
+  // the slot holding the value
+  int slot(int value);
+
+  // push the value, generating it in place if inlined
+  void push(int value);
+
+  // generate an instruction (after its arguments)
+  void emit(const SSAInstr &instr);
+
+  // generate the end of the block, with phi copies on each edge
+  void emit_term(const SSABlock &block);
+  void emit_copies(int from, int to);
+  void emit_jump(OpCode op, int target_block);
+};
+
+#endif
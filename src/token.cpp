@@ -86,6 +86,7 @@ std::string to_string(const Token &token)
       // reserved words
       {TokenType::STRUCT, "STRUCT"},
       {TokenType::ARRAY, "ARRAY"},
+      {TokenType::MAP, "MAP"},
       {TokenType::CONST, "CONST"},
       {TokenType::FOR, "FOR"},
       {TokenType::WHILE, "WHILE"},
@@ -55,6 +55,7 @@ enum class TokenType
   // reserved words
   STRUCT,
   ARRAY,
+  MAP,
   FOR,
   WHILE,
   IF,
@@ -5,12 +5,15 @@
 // DESC: Var table implementation
 //----------------------------------------------------------------------
 
+#include <algorithm>
 #include "var_table.h"
 
 using namespace std;
 
 void VarTable::push_environment()
 {
+  if (empty())
+    max_index = 0;
   environments.push_back(unordered_map<string, int>());
 }
 
@@ -31,7 +34,15 @@ bool VarTable::empty() const
 void VarTable::add(const string &name)
 {
   if (!empty())
+  {
     environments.back()[name] = next_index++;
+    max_index = max(max_index, next_index);
+  }
+}
+
+int VarTable::max_size() const
+{
+  return max_index;
 }
 
 int VarTable::get(const string &name) const
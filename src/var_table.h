@@ -27,6 +27,10 @@ public:
   // add the var name to the current environment
   void add(const std::string &name);
 
+  // the most names in the table at once since it was last empty (the
+  // variable slots a frame needs)
+  int max_size() const;
+
   // return index for most recent name (or -1 if the name doesn't exist)
   int get(const std::string &name) const;
 
@@ -38,6 +42,7 @@ private:
   std::vector<std::unordered_map<std::string, int>> environments;
 
   int next_index = 0;
+  int max_index = 0;
 };
 
 #endif
@@ -8,6 +8,12 @@
 #include "vm.h"
 #include "mypl_exception.h"
 #include "vm_frame.h"
+#include "vm_profiler.h"
+#include "vm_sampler.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
@@ -22,8 +28,8 @@ void VM::error(string msg) const
 void VM::error(string msg, const VMFrame &frame) const
 {
   int pc = frame.pc - 1;
-  VMInstr instr = frame.info.instructions[pc];
-  string name = frame.info.function_name;
+  VMInstr instr = frame.info->instructions[pc];
+  string name = frame.info->function_name;
   msg += " (in " + name + " at " + to_string(pc) + ": " +
          to_string(instr) + ")";
   throw MyPLException::VMError(msg);
@@ -42,13 +48,112 @@ string to_string(const VM &vm)
       VMInstr instr = frame.instructions[i];
       s += "  " + to_string(i) + ": " + to_string(instr) + "\n";
     }
+    for (int i = 0; i < frame.array_constants.size(); ++i)
+    {
+      const VMArrayConstant &constant = frame.array_constants[i];
+      s += "  constant " + to_string(i) + ": " + to_string(constant.values.size()) +
+        " " + constant.element_type + " elements\n";
+    }
   }
   return s;
 }
 
 void VM::add(const VMFrameInfo &frame)
 {
-  frame_info[frame.function_name] = frame;
+  VMFrameInfo &info = frame_info[frame.function_name] = frame;
+  // frames built by hand need not give their slot count, and every
+  // slot used must exist since LOAD and STORE do not check
+  info.local_count = max(info.local_count, info.arg_count);
+  for (const VMInstr &instr : info.instructions)
+    if (instr.opcode() == OpCode::LOAD or instr.opcode() == OpCode::STORE)
+      info.local_count = max(info.local_count, get<int>(instr.operand().value()) + 1);
+}
+
+const VMFrameInfo &VM::frame(const string &name) const
+{
+  if (!frame_info.contains(name))
+    error("No '" + name + "' function");
+  return frame_info.at(name);
+}
+
+void VM::set_profiler(VMProfiler *p)
+{
+  profiler = p;
+}
+
+void VM::set_sampler(VMSampler *s)
+{
+  sampler = s;
+}
+
+uint64_t VM::instructions_executed() const
+{
+  return executed;
+}
+
+// heap space estimates: string contents plus the containers' own
+// storage (hash table nodes for struct fields, one slot per element)
+static uint64_t string_bytes(const VMValue &x)
+{
+  return holds_alternative<VMString>(x) ? get<VMString>(x).size() : 0;
+}
+
+// string contents of elements [from, to) of an array
+static uint64_t string_bytes(const VMArray &array, size_t from, size_t to)
+{
+  uint64_t bytes = 0;
+  if (array.storage() == VMArray::Storage::VALUES)
+    for (size_t i = from; i < to; ++i)
+      bytes += string_bytes(array.get(i));
+  return bytes;
+}
+
+static const uint64_t STRUCT_BYTES = sizeof(unordered_map<string, VMValue>);
+static const uint64_t FIELD_BYTES = sizeof(pair<const string, VMValue>) + 2 * sizeof(void *);
+static const uint64_t ARRAY_BYTES = sizeof(VMArray);
+static const uint64_t MAP_BYTES = sizeof(VMMap);
+
+VMStats VM::stats() const
+{
+  VMStats s = mem_stats;
+  stack<shared_ptr<VMFrame>> frames = call_stack;
+  while (!frames.empty())
+  {
+    stack<VMValue> operands = frames.top()->operand_stack;
+    for (; !operands.empty(); operands.pop())
+      s.operand_string_bytes += string_bytes(operands.top());
+    frames.pop();
+  }
+  for (const VMValue &x : locals)
+    s.variable_string_bytes += string_bytes(x);
+  return s;
+}
+
+void VM::note_frame(const VMFrame &frame)
+{
+  ++mem_stats.frames_allocated;
+  mem_stats.frame_bytes += sizeof(VMFrame) + frame.info->local_count * sizeof(VMValue);
+  if (call_stack.size() > mem_stats.max_call_depth)
+    mem_stats.max_call_depth = call_stack.size();
+}
+
+void VM::note_heap()
+{
+  uint64_t bytes = mem_stats.struct_bytes + mem_stats.array_bytes + mem_stats.map_bytes;
+  if (bytes > mem_stats.peak_heap_bytes)
+    mem_stats.peak_heap_bytes = bytes;
+}
+
+vector<string> VM::call_stack_names() const
+{
+  stack<shared_ptr<VMFrame>> frames = call_stack;
+  vector<string> names(frames.size());
+  for (int i = names.size() - 1; i >= 0; --i)
+  {
+    names[i] = frames.top()->info->function_name;
+    frames.pop();
+  }
+  return names;
 }
 
 void VM::run(bool DEBUG)
@@ -58,18 +163,38 @@ void VM::run(bool DEBUG)
   if (!frame_info.contains("main"))
     error("No 'main' function");
   shared_ptr<VMFrame> frame = make_shared<VMFrame>();
-  frame->info = frame_info["main"];
+  frame->info = &frame_info["main"];
+  frame->locals_base = locals.size();
+  locals.resize(frame->locals_base + frame->info->local_count);
   call_stack.push(frame);
+  note_frame(*frame);
+  if (profiler)
+    profiler->call(*frame->info);
+  if (sampler)
+    sampler->start();
+
+  // the output is flushed however the run ends (including errors)
+  struct FlushOutput
+  {
+    VMOutput &output;
+    ~FlushOutput() { output.flush(); }
+  } flush_output{output};
 
   // run loop (keep going until we run out of instructions)
-  while (!call_stack.empty() and frame->pc < frame->info.instructions.size())
+  while (!call_stack.empty() and frame->pc < frame->info->instructions.size())
   {
 
     // get the next instruction
-    VMInstr &instr = frame->info.instructions[frame->pc];
+    const VMInstr &instr = frame->info->instructions[frame->pc];
+
+    if (profiler)
+      profiler->step(frame->pc);
+    if (sampler and sampler->due())
+      sampler->sample(call_stack_names());
 
     // increment the program counter
     ++frame->pc;
+    ++executed;
 
     // for debugging
     if (DEBUG)
@@ -77,7 +202,7 @@ void VM::run(bool DEBUG)
       // TODO
       cerr << endl
            << endl;
-      cerr << "\t FRAME.........: " << frame->info.function_name << endl;
+      cerr << "\t FRAME.........: " << frame->info->function_name << endl;
       cerr << "\t PC............: " << (frame->pc - 1) << endl;
       cerr << "\t INSTR.........: " << to_string(instr) << endl;
       cerr << "\t NEXT OPERAND..: ";
@@ -87,7 +212,7 @@ void VM::run(bool DEBUG)
         cerr << "empty" << endl;
       cerr << "\t NEXT FUNCTION.: ";
       if (!call_stack.empty())
-        cerr << call_stack.top()->info.function_name << endl;
+        cerr << call_stack.top()->info->function_name << endl;
       else
         cerr << "empty" << endl;
     }
@@ -112,21 +237,12 @@ void VM::run(bool DEBUG)
     {
       VMValue x = frame->operand_stack.top();
       frame->operand_stack.pop();
-      int pos = get<int>(instr.operand().value());
-      if (pos >= frame->variables.size())
-      {
-        frame->variables.push_back(x);
-      }
-      else
-      {
-        frame->variables.at(pos) = x;
-      }
+      locals[frame->locals_base + get<int>(instr.operand().value())] = x;
     }
 
     else if (instr.opcode() == OpCode::LOAD)
     {
-      VMValue x = frame->variables.at(get<int>(instr.operand().value()));
-      frame->operand_stack.push(x);
+      frame->operand_stack.push(locals[frame->locals_base + get<int>(instr.operand().value())]);
     }
 
     //----------------------------------------------------------------------
@@ -303,6 +419,15 @@ void VM::run(bool DEBUG)
       }
     }
 
+    else if (instr.opcode() == OpCode::JMPT)
+    {
+      VMValue x = frame->operand_stack.top();
+      frame->operand_stack.pop();
+      int index = get<int>(instr.operand().value());
+      if (holds_alternative<bool>(x) and get<bool>(x))
+        frame->pc = index;
+    }
+
     //----------------------------------------------------------------------
     // Functions
     //----------------------------------------------------------------------
@@ -310,28 +435,63 @@ void VM::run(bool DEBUG)
     // TODO: Finish CALL, RET
     else if (instr.opcode() == OpCode::CALL)
     {
-      string fun_name = get<string>(instr.operand().value());
+      string fun_name = get<VMString>(instr.operand().value()).str();
       shared_ptr<VMFrame> new_frame = make_shared<VMFrame>();
-      new_frame->info = frame_info[fun_name];
+      new_frame->info = &frame_info[fun_name];
+      // the callee's slots follow the caller's
+      new_frame->locals_base = locals.size();
+      locals.resize(new_frame->locals_base + new_frame->info->local_count);
       call_stack.push(new_frame);
-      for (int i = 0; i < frame_info[fun_name].arg_count; i++)
+      for (int i = 0; i < new_frame->info->arg_count; i++)
       {
         VMValue x = frame->operand_stack.top();
         new_frame->operand_stack.push(x);
         frame->operand_stack.pop();
       }
       frame = new_frame;
+      note_frame(*frame);
+      if (profiler)
+        profiler->call(*frame->info);
+    }
+
+    else if (instr.opcode() == OpCode::TAILCALL)
+    {
+      // the callee takes over the current frame instead of pushing a
+      // new one, so tail recursion runs in constant stack space
+      string fun_name = get<VMString>(instr.operand().value()).str();
+      const VMFrameInfo &info = frame_info[fun_name];
+      vector<VMValue> args;
+      for (int i = 0; i < info.arg_count; i++)
+      {
+        args.push_back(frame->operand_stack.top());
+        frame->operand_stack.pop();
+      }
+      frame->info = &info;
+      frame->pc = 0;
+      // fresh slots for the callee (dropping the old values)
+      locals.resize(frame->locals_base);
+      locals.resize(frame->locals_base + info.local_count);
+      frame->operand_stack = {};
+      for (VMValue &x : args)
+      {
+        frame->operand_stack.push(x);
+      }
+      if (profiler)
+        profiler->call(*frame->info);
     }
 
     else if (instr.opcode() == OpCode::RET)
     {
       VMValue v = frame->operand_stack.top();
       frame->operand_stack.pop();
+      locals.resize(frame->locals_base);
       call_stack.pop();
       if (!call_stack.empty())
       {
         frame = call_stack.top();
         frame->operand_stack.push(v);
+        if (profiler)
+          profiler->resume(*frame->info);
       }
     }
 
@@ -343,23 +503,103 @@ void VM::run(bool DEBUG)
     {
       VMValue x = frame->operand_stack.top();
       frame->operand_stack.pop();
-      cout << to_string(x);
+      output.write(x);
+      if (DEBUG)
+        output.flush();
     }
 
     else if (instr.opcode() == OpCode::READ)
     {
+      // a prompt must show up before waiting on the input
+      output.flush();
       string val = "";
       getline(cin, val);
       frame->operand_stack.push(val);
     }
 
+    else if (instr.opcode() == OpCode::READALL)
+    {
+      // a prompt must show up before waiting on the input
+      output.flush();
+      string val = "";
+      char block[1 << 16];
+      streamsize n;
+      while ((n = cin.rdbuf()->sgetn(block, sizeof(block))) > 0)
+      {
+        val.append(block, n);
+      }
+      frame->operand_stack.push(val);
+    }
+
+    else if (instr.opcode() == OpCode::READF)
+    {
+      VMValue x = frame->operand_stack.top();
+      ensure_not_null(*frame, x);
+      frame->operand_stack.pop();
+      string val = "";
+      with_file(get<VMString>(x).str(), *frame, [&val](string_view contents) {
+        val = contents;
+      });
+      frame->operand_stack.push(val);
+    }
+
+    else if (instr.opcode() == OpCode::READLNS)
+    {
+      VMValue x = frame->operand_stack.top();
+      ensure_not_null(*frame, x);
+      frame->operand_stack.pop();
+      vector<VMValue> lines;
+      uint64_t bytes = ARRAY_BYTES;
+      with_file(get<VMString>(x).str(), *frame, [&lines, &bytes](string_view contents) {
+        // a final newline does not start another (empty) line
+        while (!contents.empty())
+        {
+          size_t end = contents.find('\n');
+          string_view line = contents.substr(0, end);
+          lines.push_back(string(line));
+          bytes += sizeof(VMValue) + line.size();
+          if (end == string_view::npos)
+            break;
+          contents.remove_prefix(end + 1);
+        }
+      });
+      array_heap[next_obj_id] = VMArray(std::move(lines));
+      frame->operand_stack.push(next_obj_id);
+      ++next_obj_id;
+      ++mem_stats.array_objects;
+      mem_stats.array_bytes += bytes;
+      note_heap();
+    }
+
+    else if (instr.opcode() == OpCode::MAPI or instr.opcode() == OpCode::MAPD)
+    {
+      VMValue x = frame->operand_stack.top();
+      ensure_not_null(*frame, x);
+      frame->operand_stack.pop();
+      const string path = get<VMString>(x).str();
+      VMArray array;
+      if (!array.map_file(path, instr.opcode() == OpCode::MAPD))
+      {
+        string kind = instr.opcode() == OpCode::MAPD ? "doubles" : "ints";
+        error("could not map file '" + path + "' as " + kind, *frame);
+      }
+      // the file's pages are shared with the os, so only the array
+      // object itself counts toward the heap
+      mem_stats.mapped_bytes += array.mapped_bytes();
+      array_heap[next_obj_id] = std::move(array);
+      frame->operand_stack.push(next_obj_id);
+      ++next_obj_id;
+      ++mem_stats.array_objects;
+      mem_stats.array_bytes += ARRAY_BYTES;
+      note_heap();
+    }
+
     else if (instr.opcode() == OpCode::SLEN)
     {
       VMValue x1 = frame->operand_stack.top();
       ensure_not_null(*frame, x1);
-      string x = get<string>(frame->operand_stack.top());
+      int length = get<VMString>(frame->operand_stack.top()).size();
       frame->operand_stack.pop();
-      int length = x.size();
       frame->operand_stack.push(length);
     }
 
@@ -369,8 +609,7 @@ void VM::run(bool DEBUG)
       ensure_not_null(*frame, x1);
       int x = get<int>(frame->operand_stack.top());
       frame->operand_stack.pop();
-      vector<VMValue> val = array_heap[x];
-      int length = val.size();
+      int length = array_heap[x].size();
       frame->operand_stack.push(length);
     }
 
@@ -379,9 +618,10 @@ void VM::run(bool DEBUG)
       VMValue x = frame->operand_stack.top();
       ensure_not_null(*frame, x);
       frame->operand_stack.pop();
-      string word = get<string>(x);
+      const VMString &word = get<VMString>(x);
       VMValue y = frame->operand_stack.top();
       ensure_not_null(*frame, y);
+      frame->operand_stack.pop();
       int index = get<int>(y);
       if (index >= word.size())
       {
@@ -391,9 +631,7 @@ void VM::run(bool DEBUG)
       {
         error("out-of-bounds string index (in main at 2: GETC())");
       }
-      string ch;
-      ch.push_back(word[index]);
-      frame->operand_stack.push(ch);
+      frame->operand_stack.push(word[index]);
     }
 
     // TODO: Finish SLEN, ALEN, GETC, TODBL, TOSTR, CONCAT, TOINT
@@ -408,17 +646,12 @@ void VM::run(bool DEBUG)
         int y = (int)get<double>(x);
         frame->operand_stack.push(y);
       }
-      else if (holds_alternative<string>(x))
+      else if (holds_alternative<VMString>(x) or holds_alternative<char>(x))
       {
-        try
-        {
-          int y = stoi(get<string>(x));
-          frame->operand_stack.push(y);
-        }
-        catch (exception &err)
-        {
+        int y;
+        if (!parse_int(pattern(x), y))
           error("cannot convert string to int (in main at 1: TOINT())");
-        }
+        frame->operand_stack.push(y);
       }
     }
 
@@ -432,18 +665,12 @@ void VM::run(bool DEBUG)
         double y = (double)get<int>(x);
         frame->operand_stack.push(y);
       }
-      else if (holds_alternative<string>(x))
+      else if (holds_alternative<VMString>(x))
       {
-        string word = get<string>(x);
-        try
-        {
-          double y = stod(get<string>(x));
-          frame->operand_stack.push(y);
-        }
-        catch (exception &err)
-        {
+        double y;
+        if (!parse_double(get<VMString>(x), y))
           error("cannot convert string to double (in main at 1: TODBL())");
-        }
+        frame->operand_stack.push(y);
       }
     }
 
@@ -452,7 +679,14 @@ void VM::run(bool DEBUG)
       VMValue x = frame->operand_stack.top();
       ensure_not_null(*frame, x);
       frame->operand_stack.pop();
-      frame->operand_stack.push(to_string(x));
+      if (holds_alternative<int>(x) or holds_alternative<double>(x))
+      {
+        // short numbers fit inline in the string, without allocating
+        char digits[NUMBER_CHARS];
+        frame->operand_stack.push(VMString(format_number(x, digits)));
+      }
+      else
+        frame->operand_stack.push(to_string(x));
     }
 
     else if (instr.opcode() == OpCode::CONCAT)
@@ -460,13 +694,92 @@ void VM::run(bool DEBUG)
       VMValue x = frame->operand_stack.top();
       ensure_not_null(*frame, x);
       frame->operand_stack.pop();
-      string word1 = get<string>(x);
-      x = frame->operand_stack.top();
+      VMValue y = frame->operand_stack.top();
+      ensure_not_null(*frame, y);
+      frame->operand_stack.pop();
+      frame->operand_stack.push(VMString::concat(get<VMString>(y), get<VMString>(x)));
+    }
+
+    else if (instr.opcode() == OpCode::SUBSTR)
+    {
+      VMValue n = frame->operand_stack.top();
+      ensure_not_null(*frame, n);
+      frame->operand_stack.pop();
+      VMValue i = frame->operand_stack.top();
+      ensure_not_null(*frame, i);
+      frame->operand_stack.pop();
+      VMValue x = frame->operand_stack.top();
       ensure_not_null(*frame, x);
       frame->operand_stack.pop();
-      string word2 = get<string>(x);
-      string concat = word2 + word1;
-      frame->operand_stack.push(concat);
+      const VMString &word = get<VMString>(x);
+      int start = get<int>(i);
+      int count = get<int>(n);
+      if (start < 0 or count < 0 or start > word.size() or count > word.size() - start)
+      {
+        error("out-of-bounds substring", *frame);
+      }
+      frame->operand_stack.push(word.substr(start, count));
+    }
+
+    else if (instr.opcode() == OpCode::FIND)
+    {
+      VMValue y = frame->operand_stack.top();
+      ensure_not_null(*frame, y);
+      frame->operand_stack.pop();
+      VMValue x = frame->operand_stack.top();
+      ensure_not_null(*frame, x);
+      frame->operand_stack.pop();
+      // string_view::find scans for the first character with memchr
+      size_t index = get<VMString>(x).view().find(pattern(y));
+      frame->operand_stack.push(index == string_view::npos ? -1 : (int)index);
+    }
+
+    else if (instr.opcode() == OpCode::STARTSW)
+    {
+      VMValue y = frame->operand_stack.top();
+      ensure_not_null(*frame, y);
+      frame->operand_stack.pop();
+      VMValue x = frame->operand_stack.top();
+      ensure_not_null(*frame, x);
+      frame->operand_stack.pop();
+      frame->operand_stack.push(get<VMString>(x).view().starts_with(pattern(y)));
+    }
+
+    else if (instr.opcode() == OpCode::SPLIT)
+    {
+      VMValue y = frame->operand_stack.top();
+      ensure_not_null(*frame, y);
+      frame->operand_stack.pop();
+      VMValue x = frame->operand_stack.top();
+      ensure_not_null(*frame, x);
+      frame->operand_stack.pop();
+      string_view separator = pattern(y);
+      if (separator.empty())
+      {
+        error("cannot split on an empty separator", *frame);
+      }
+      // the pieces share the string's buffer where they can
+      const VMString &word = get<VMString>(x);
+      string_view rest = word.view();
+      vector<VMValue> pieces;
+      uint64_t bytes = ARRAY_BYTES;
+      size_t start = 0;
+      while (true)
+      {
+        size_t end = rest.find(separator, start);
+        size_t n = (end == string_view::npos ? rest.size() : end) - start;
+        pieces.push_back(word.substr(start, n));
+        bytes += sizeof(VMValue) + n;
+        if (end == string_view::npos)
+          break;
+        start = end + separator.size();
+      }
+      array_heap[next_obj_id] = VMArray(std::move(pieces));
+      frame->operand_stack.push(next_obj_id);
+      ++next_obj_id;
+      ++mem_stats.array_objects;
+      mem_stats.array_bytes += bytes;
+      note_heap();
     }
 
     //----------------------------------------------------------------------
@@ -480,9 +793,32 @@ void VM::run(bool DEBUG)
       frame->operand_stack.pop();
       int size = get<int>(frame->operand_stack.top());
       frame->operand_stack.pop();
-      array_heap[next_obj_id] = vector<VMValue>(size, x);
+      // the element type (if given) selects an unboxed store
+      VMArray &array = array_heap[next_obj_id];
+      if (instr.operand().has_value())
+        array = VMArray(size, x, get<VMString>(instr.operand().value()).str());
+      else
+        array = VMArray(size, x);
       frame->operand_stack.push(next_obj_id);
       ++next_obj_id;
+      ++mem_stats.array_objects;
+      mem_stats.array_bytes += ARRAY_BYTES + array.storage_bytes() + size * string_bytes(x);
+      note_heap();
+    }
+
+    else if (instr.opcode() == OpCode::ALLOCA_CONST)
+    {
+      // the literal's elements are copied in one step
+      const VMArrayConstant &constant = frame->info->array_constants[get<int>(instr.operand().value())];
+      VMArray &array = array_heap[next_obj_id];
+      array = VMArray(constant.values, constant.element_type);
+      frame->operand_stack.push(next_obj_id);
+      ++next_obj_id;
+      ++mem_stats.array_objects;
+      mem_stats.array_bytes += ARRAY_BYTES + array.storage_bytes();
+      for (const VMValue &x : constant.values)
+        mem_stats.array_bytes += string_bytes(x);
+      note_heap();
     }
 
     else if (instr.opcode() == OpCode::ALLOCS)
@@ -490,6 +826,9 @@ void VM::run(bool DEBUG)
       struct_heap[next_obj_id] = {};
       frame->operand_stack.push(next_obj_id);
       ++next_obj_id;
+      ++mem_stats.struct_objects;
+      mem_stats.struct_bytes += STRUCT_BYTES;
+      note_heap();
     }
 
     else if (instr.opcode() == OpCode::ADDF)
@@ -498,7 +837,12 @@ void VM::run(bool DEBUG)
       ensure_not_null(*frame, x);
       frame->operand_stack.pop();
       int oid = get<int>(x);
-      struct_heap[oid][get<string>(instr.operand().value())];
+      const string field = get<VMString>(instr.operand().value()).str();
+      if (struct_heap[oid].try_emplace(field).second)
+      {
+        mem_stats.struct_bytes += FIELD_BYTES + field.size();
+        note_heap();
+      }
     }
 
     else if (instr.opcode() == OpCode::SETF)
@@ -509,7 +853,11 @@ void VM::run(bool DEBUG)
       ensure_not_null(*frame, y);
       frame->operand_stack.pop();
       int oid = get<int>(y);
-      struct_heap[oid][get<string>(instr.operand().value())] = x;
+      VMValue &field = struct_heap[oid][get<VMString>(instr.operand().value()).str()];
+      mem_stats.struct_bytes -= string_bytes(field);
+      mem_stats.struct_bytes += string_bytes(x);
+      field = x;
+      note_heap();
     }
 
     else if (instr.opcode() == OpCode::GETF)
@@ -518,7 +866,7 @@ void VM::run(bool DEBUG)
       ensure_not_null(*frame, x);
       frame->operand_stack.pop();
       int oid = get<int>(x);
-      frame->operand_stack.push(struct_heap[oid][get<string>(instr.operand().value())]);
+      frame->operand_stack.push(struct_heap[oid][get<VMString>(instr.operand().value()).str()]);
     }
 
     else if (instr.opcode() == OpCode::SETI)
@@ -533,13 +881,32 @@ void VM::run(bool DEBUG)
       ensure_not_null(*frame, z);
       frame->operand_stack.pop();
       int oid = get<int>(z);
-      if (get<int>(y) < array_heap[oid].size())
+      VMArray &array = array_heap[oid];
+      if (array.read_only())
+      {
+        error("cannot modify a read-only (mapped) array", *frame);
+      }
+      if (get<int>(y) < array.size())
       {
         if (get<int>(y) < 0)
         {
           error("out-of-bounds array index (in main at 5: SETI())");
         }
-        array_heap[oid][get<int>(y)] = x;
+        if (array.storage() == VMArray::Storage::VALUES)
+        {
+          VMValue &element = array.at(get<int>(y));
+          mem_stats.array_bytes -= string_bytes(element);
+          mem_stats.array_bytes += string_bytes(x);
+          element = x;
+        }
+        else
+        {
+          // storing a value of another type boxes the elements
+          uint64_t before = array.storage_bytes();
+          array.set(get<int>(y), x);
+          mem_stats.array_bytes += array.storage_bytes() - before + string_bytes(x);
+        }
+        note_heap();
       }
       else
       {
@@ -547,6 +914,82 @@ void VM::run(bool DEBUG)
       }
     }
 
+    else if (instr.opcode() == OpCode::APPEND)
+    {
+      VMValue x = frame->operand_stack.top();
+      frame->operand_stack.pop();
+      VMValue y = frame->operand_stack.top();
+      ensure_not_null(*frame, y);
+      frame->operand_stack.pop();
+      VMArray &array = array_heap[get<int>(y)];
+      if (array.read_only())
+        error("cannot modify a read-only (mapped) array", *frame);
+      uint64_t before = array.storage_bytes();
+      array.push_back(x);
+      mem_stats.array_bytes += array.storage_bytes() - before + string_bytes(x);
+      note_heap();
+    }
+
+    else if (instr.opcode() == OpCode::APOP)
+    {
+      VMValue x = frame->operand_stack.top();
+      ensure_not_null(*frame, x);
+      frame->operand_stack.pop();
+      VMArray &array = array_heap[get<int>(x)];
+      if (array.read_only())
+        error("cannot modify a read-only (mapped) array", *frame);
+      if (array.size() == 0)
+        error("cannot pop from an empty array", *frame);
+      uint64_t before = array.storage_bytes();
+      VMValue last = array.pop_back();
+      mem_stats.array_bytes -= before - array.storage_bytes() + string_bytes(last);
+      frame->operand_stack.push(last);
+    }
+
+    else if (instr.opcode() == OpCode::ARESIZE)
+    {
+      VMValue x = frame->operand_stack.top();
+      ensure_not_null(*frame, x);
+      frame->operand_stack.pop();
+      VMValue y = frame->operand_stack.top();
+      ensure_not_null(*frame, y);
+      frame->operand_stack.pop();
+      VMArray &array = array_heap[get<int>(y)];
+      if (array.read_only())
+        error("cannot modify a read-only (mapped) array", *frame);
+      int size = get<int>(x);
+      if (size < 0)
+        error("negative array size", *frame);
+      uint64_t before = array.storage_bytes() + string_bytes(array, size, array.size());
+      array.resize(size);
+      mem_stats.array_bytes += array.storage_bytes() - before;
+      note_heap();
+    }
+
+    else if (instr.opcode() == OpCode::ACOPY)
+    {
+      // arguments in call order: destination, source, offset, count
+      VMValue args[4];
+      for (int i = 3; i >= 0; --i)
+      {
+        args[i] = frame->operand_stack.top();
+        ensure_not_null(*frame, args[i]);
+        frame->operand_stack.pop();
+      }
+      VMArray &dst = array_heap[get<int>(args[0])];
+      const VMArray &src = array_heap[get<int>(args[1])];
+      int offset = get<int>(args[2]);
+      int count = get<int>(args[3]);
+      if (dst.read_only())
+        error("cannot modify a read-only (mapped) array", *frame);
+      if (offset < 0 or count < 0 or count > src.size() or (size_t)offset + count > dst.size())
+        error("out-of-bounds array copy", *frame);
+      uint64_t before = dst.storage_bytes() + string_bytes(dst, offset, offset + count);
+      dst.copy(offset, src, count);
+      mem_stats.array_bytes += dst.storage_bytes() + string_bytes(dst, offset, offset + count) - before;
+      note_heap();
+    }
+
     else if (instr.opcode() == OpCode::GETI)
     {
       VMValue x = frame->operand_stack.top();
@@ -556,13 +999,14 @@ void VM::run(bool DEBUG)
       ensure_not_null(*frame, y);
       frame->operand_stack.pop();
       int oid = get<int>(y);
-      if (get<int>(x) < array_heap[oid].size())
+      const VMArray &array = array_heap[oid];
+      if (get<int>(x) < array.size())
       {
         if (get<int>(x) < 0)
         {
           error("out-of-bounds array index (in main at 4: GETI())");
         }
-        frame->operand_stack.push(array_heap[oid][get<int>(x)]);
+        frame->operand_stack.push(array.get(get<int>(x)));
       }
       else
       {
@@ -570,6 +1014,88 @@ void VM::run(bool DEBUG)
       }
     }
 
+    else if (instr.opcode() == OpCode::ALLOCM)
+    {
+      map_heap[next_obj_id] = VMMap(get<VMString>(instr.operand().value()).str());
+      frame->operand_stack.push(next_obj_id);
+      ++next_obj_id;
+      ++mem_stats.map_objects;
+      mem_stats.map_bytes += MAP_BYTES;
+      note_heap();
+    }
+
+    else if (instr.opcode() == OpCode::MGET or instr.opcode() == OpCode::MHAS)
+    {
+      VMValue x = frame->operand_stack.top();
+      ensure_not_null(*frame, x);
+      frame->operand_stack.pop();
+      VMValue y = frame->operand_stack.top();
+      ensure_not_null(*frame, y);
+      frame->operand_stack.pop();
+      const VMValue *value = map_heap[get<int>(y)].find(x);
+      if (instr.opcode() == OpCode::MHAS)
+        frame->operand_stack.push(value != nullptr);
+      else if (value)
+        frame->operand_stack.push(*value);
+      else
+        frame->operand_stack.push(nullptr);
+    }
+
+    else if (instr.opcode() == OpCode::MPUT)
+    {
+      VMValue x = frame->operand_stack.top();
+      frame->operand_stack.pop();
+      VMValue y = frame->operand_stack.top();
+      ensure_not_null(*frame, y);
+      frame->operand_stack.pop();
+      VMValue z = frame->operand_stack.top();
+      ensure_not_null(*frame, z);
+      frame->operand_stack.pop();
+      VMMap &map = map_heap[get<int>(z)];
+      uint64_t before = map.storage_bytes();
+      size_t size = map.size();
+      VMValue &value = map.put(y);
+      if (map.size() != size)
+        mem_stats.map_bytes += string_bytes(y);
+      mem_stats.map_bytes += map.storage_bytes() - before + string_bytes(x) - string_bytes(value);
+      value = x;
+      note_heap();
+    }
+
+    else if (instr.opcode() == OpCode::MDEL)
+    {
+      VMValue x = frame->operand_stack.top();
+      ensure_not_null(*frame, x);
+      frame->operand_stack.pop();
+      VMValue y = frame->operand_stack.top();
+      ensure_not_null(*frame, y);
+      frame->operand_stack.pop();
+      VMMap &map = map_heap[get<int>(y)];
+      const VMValue *value = map.find(x);
+      if (value)
+      {
+        uint64_t bytes = map.storage_bytes() + string_bytes(x) + string_bytes(*value);
+        map.remove(x);
+        mem_stats.map_bytes -= bytes - map.storage_bytes();
+      }
+    }
+
+    else if (instr.opcode() == OpCode::MKEYS)
+    {
+      VMValue x = frame->operand_stack.top();
+      ensure_not_null(*frame, x);
+      frame->operand_stack.pop();
+      const VMMap &map = map_heap[get<int>(x)];
+      VMArray &array = array_heap[next_obj_id];
+      array = VMArray(map.keys(), map.key_type());
+      frame->operand_stack.push(next_obj_id);
+      ++next_obj_id;
+      ++mem_stats.array_objects;
+      mem_stats.array_bytes += ARRAY_BYTES + array.storage_bytes() +
+        string_bytes(array, 0, array.size());
+      note_heap();
+    }
+
     //----------------------------------------------------------------------
     // special
     //----------------------------------------------------------------------
@@ -592,6 +1118,41 @@ void VM::run(bool DEBUG)
       error("unsupported operation " + to_string(instr));
     }
   }
+  if (profiler)
+    profiler->stop();
+  if (sampler)
+    sampler->stop();
+}
+
+void VM::with_file(const string &path, const VMFrame &frame,
+                   const function<void(string_view)> &f) const
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  struct stat info;
+  if (fd < 0 or fstat(fd, &info) != 0)
+  {
+    if (fd >= 0)
+      close(fd);
+    error("could not read file '" + path + "'", frame);
+  }
+  if (S_ISREG(info.st_mode) and info.st_size > 0)
+  {
+    void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+      error("could not read file '" + path + "'", frame);
+    f(string_view((const char *)data, info.st_size));
+    munmap(data, info.st_size);
+    return;
+  }
+  // pipes and devices (and empty files) are read in large blocks
+  string contents = "";
+  char block[1 << 16];
+  ssize_t n;
+  while ((n = read(fd, block, sizeof(block))) > 0)
+    contents.append(block, n);
+  close(fd);
+  f(contents);
 }
 
 void VM::ensure_not_null(const VMFrame &f, const VMValue &x) const
@@ -600,6 +1161,13 @@ void VM::ensure_not_null(const VMFrame &f, const VMValue &x) const
     error("null reference", f);
 }
 
+string_view VM::pattern(const VMValue &x) const
+{
+  if (holds_alternative<char>(x))
+    return string_view(&get<char>(x), 1);
+  return get<VMString>(x).view();
+}
+
 VMValue VM::add(const VMValue &x, const VMValue &y) const
 {
   if (holds_alternative<int>(x))
@@ -661,8 +1229,10 @@ VMValue VM::eq(const VMValue &x, const VMValue &y) const
     return get<int>(x) == get<int>(y);
   else if (holds_alternative<double>(x))
     return get<double>(x) == get<double>(y);
-  else if (holds_alternative<string>(x))
-    return get<string>(x) == get<string>(y);
+  else if (holds_alternative<VMString>(x))
+    return get<VMString>(x) == get<VMString>(y);
+  else if (holds_alternative<char>(x))
+    return get<char>(x) == get<char>(y);
   else
     return get<bool>(x) == get<bool>(y);
 }
@@ -679,8 +1249,10 @@ VMValue VM::neq(const VMValue &x, const VMValue &y) const
     return get<int>(x) != get<int>(y);
   else if (holds_alternative<double>(x))
     return get<double>(x) != get<double>(y);
-  else if (holds_alternative<string>(x))
-    return get<string>(x) != get<string>(y);
+  else if (holds_alternative<VMString>(x))
+    return get<VMString>(x) != get<VMString>(y);
+  else if (holds_alternative<char>(x))
+    return get<char>(x) != get<char>(y);
   else
     return get<bool>(x) != get<bool>(y);
 }
@@ -693,8 +1265,10 @@ VMValue VM::lt(const VMValue &x, const VMValue &y) const
     return get<int>(x) < get<int>(y);
   else if (holds_alternative<double>(x) && holds_alternative<double>(y))
     return get<double>(x) < get<double>(y);
+  else if (holds_alternative<char>(x) && holds_alternative<char>(y))
+    return (unsigned char)get<char>(x) < (unsigned char)get<char>(y);
   else
-    return get<string>(x) < get<string>(y);
+    return get<VMString>(x) < get<VMString>(y);
 }
 
 VMValue VM::le(const VMValue &x, const VMValue &y) const
@@ -703,8 +1277,10 @@ VMValue VM::le(const VMValue &x, const VMValue &y) const
     return get<int>(x) <= get<int>(y);
   else if (holds_alternative<double>(x) && holds_alternative<double>(y))
     return get<double>(x) <= get<double>(y);
+  else if (holds_alternative<char>(x) && holds_alternative<char>(y))
+    return (unsigned char)get<char>(x) <= (unsigned char)get<char>(y);
   else
-    return get<string>(x) <= get<string>(y);
+    return get<VMString>(x) <= get<VMString>(y);
 }
 
 VMValue VM::gt(const VMValue &x, const VMValue &y) const
@@ -713,8 +1289,10 @@ VMValue VM::gt(const VMValue &x, const VMValue &y) const
     return get<int>(x) > get<int>(y);
   else if (holds_alternative<double>(x) && holds_alternative<double>(y))
     return get<double>(x) > get<double>(y);
+  else if (holds_alternative<char>(x) && holds_alternative<char>(y))
+    return (unsigned char)get<char>(x) > (unsigned char)get<char>(y);
   else
-    return get<string>(x) > get<string>(y);
+    return get<VMString>(x) > get<VMString>(y);
 }
 
 VMValue VM::ge(const VMValue &x, const VMValue &y) const
@@ -723,15 +1301,17 @@ VMValue VM::ge(const VMValue &x, const VMValue &y) const
     return get<int>(x) >= get<int>(y);
   else if (holds_alternative<double>(x) && holds_alternative<double>(y))
     return get<double>(x) >= get<double>(y);
+  else if (holds_alternative<char>(x) && holds_alternative<char>(y))
+    return (unsigned char)get<char>(x) >= (unsigned char)get<char>(y);
   else
-    return get<string>(x) >= get<string>(y);
+    return get<VMString>(x) >= get<VMString>(y);
 }
 
 VMValue VM::to_int(const VMValue &x) const
 {
   if (holds_alternative<double>(x))
     return get<int>(x);
-  else if (holds_alternative<string>(x))
+  else if (holds_alternative<VMString>(x))
     return get<int>(x);
 }
 
@@ -739,14 +1319,14 @@ VMValue VM::to_dbl(const VMValue &x) const
 {
   if (holds_alternative<int>(x))
     return get<double>(x);
-  else if (holds_alternative<string>(x))
+  else if (holds_alternative<VMString>(x))
     return get<double>(x);
 }
 
 VMValue VM::to_string_func(const VMValue &x) const
 {
   if (holds_alternative<double>(x))
-    return get<string>(x);
+    return get<VMString>(x);
   else if (holds_alternative<int>(x))
-    return get<string>(x);
+    return get<VMString>(x);
 }
@@ -8,13 +8,52 @@
 #ifndef VM_H
 #define VM_H
 
+#include <cstdint>
+#include <functional>
+#include <iostream>
 #include <memory>
 #include <stack>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include "vm_instr.h"
 #include "vm_frame.h"
+#include "vm_output.h"
+#include "vm_array.h"
+#include "vm_map.h"
+
+class VMProfiler;
+class VMSampler;
+
+// Memory accounting for a vm (byte counts are estimates of the space
+// taken by the heap containers, their values, and string contents)
+struct VMStats
+{
+  // live heap objects (objects are never freed)
+  std::uint64_t struct_objects = 0;
+  std::uint64_t struct_bytes = 0;
+  std::uint64_t array_objects = 0;
+  std::uint64_t array_bytes = 0;
+  std::uint64_t map_objects = 0;
+  std::uint64_t map_bytes = 0;
+
+  // file contents mapped by read-only arrays (not part of the heap)
+  std::uint64_t mapped_bytes = 0;
+
+  // largest struct_bytes + array_bytes + map_bytes seen
+  std::uint64_t peak_heap_bytes = 0;
+
+  // string contents held by the frames on the call stack
+  std::uint64_t operand_string_bytes = 0;
+  std::uint64_t variable_string_bytes = 0;
+
+  // frames created (one per call) and their size including their
+  // variable slots, and the deepest call stack
+  std::uint64_t frames_allocated = 0;
+  std::uint64_t frame_bytes = 0;
+  std::uint64_t max_call_depth = 0;
+};
 
 class VM
 {
@@ -22,9 +61,25 @@ public:
   // add a new frame type to the vm
   void add(const VMFrameInfo &frame);
 
+  // return the frame type added for the given function name
+  const VMFrameInfo &frame(const std::string &name) const;
+
   // run the virtual machine
   void run(bool DEBUG = false);
 
+  // record execution counts and times in the profiler while running
+  // (nullptr to stop profiling)
+  void set_profiler(VMProfiler *profiler);
+
+  // sample the call stack while running (nullptr to stop sampling)
+  void set_sampler(VMSampler *sampler);
+
+  // number of instructions executed by run
+  std::uint64_t instructions_executed() const;
+
+  // memory used by the heap and the call stack
+  VMStats stats() const;
+
   // to print the instructions for each VM frame
   friend std::string to_string(const VM &vm);
 
@@ -33,7 +88,10 @@ private:
   std::unordered_map<int, std::unordered_map<std::string, VMValue>> struct_heap;
 
   // heap for array objects
-  std::unordered_map<int, std::vector<VMValue>> array_heap;
+  std::unordered_map<int, VMArray> array_heap;
+
+  // heap for map objects
+  std::unordered_map<int, VMMap> map_heap;
 
   // next available object id
   int next_obj_id = 2023;
@@ -44,10 +102,43 @@ private:
   // VM function call stack
   std::stack<std::shared_ptr<VMFrame>> call_stack;
 
+  // the variable slots of the frames on the call stack (each frame's
+  // slots follow its caller's)
+  std::vector<VMValue> locals;
+
+  // buffered output of WRITE (flushed before READ and when run ends)
+  VMOutput output{std::cout};
+
+  // instructions executed so far
+  std::uint64_t executed = 0;
+
+  // heap and frame accounting (the call stack is measured on demand)
+  VMStats mem_stats;
+
+  // account for a new frame and a heap change
+  void note_frame(const VMFrame &frame);
+  void note_heap();
+
+  // the profiler, if profiling
+  VMProfiler *profiler = nullptr;
+
+  // the sampler, if sampling
+  VMSampler *sampler = nullptr;
+
+  // function names on the call stack (outermost first)
+  std::vector<std::string> call_stack_names() const;
+
   // helper functions to report VM errors
   void error(std::string msg) const;
   void error(std::string msg, const VMFrame &f) const;
 
+  // pass the contents of the file (mapped read-only) to f
+  void with_file(const std::string &path, const VMFrame &frame,
+                 const std::function<void(std::string_view)> &f) const;
+
+  // the characters of a string or char operand (valid while x is)
+  std::string_view pattern(const VMValue &x) const;
+
   // helper function to check for null values (throws mypl exception)
   void ensure_not_null(const VMFrame &f, const VMValue &x) const;
 
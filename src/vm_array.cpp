@@ -0,0 +1,328 @@
+//----------------------------------------------------------------------
+// FILE: vm_array.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: VM array object implementation
+//----------------------------------------------------------------------
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <utility>
+#include "vm_array.h"
+
+using namespace std;
+
+VMArray::VMArray(int n, const VMValue &x)
+  : values(n, x)
+{
+}
+
+VMArray::VMArray(int n, const VMValue &x, const string &element_type)
+{
+  bool null = holds_alternative<nullptr_t>(x);
+  if (element_type == "int" and (null or holds_alternative<int>(x)))
+  {
+    kind = Storage::INT;
+    ints.assign(n, null ? 0 : std::get<int>(x));
+  }
+  else if (element_type == "double" and (null or holds_alternative<double>(x)))
+  {
+    kind = Storage::DOUBLE;
+    doubles.assign(n, null ? 0.0 : std::get<double>(x));
+  }
+  else if (element_type == "bool" and (null or holds_alternative<bool>(x)))
+  {
+    kind = Storage::BOOL;
+    bools.assign(n, null ? false : std::get<bool>(x));
+  }
+  else
+  {
+    values.assign(n, x);
+    return;
+  }
+  nulls.assign(n, null);
+}
+
+VMArray::VMArray(vector<VMValue> &&values)
+  : values(std::move(values))
+{
+}
+
+VMArray::VMArray(const vector<VMValue> &values, const string &element_type)
+  : VMArray(values.size(), nullptr, element_type)
+{
+  for (size_t i = 0; i < values.size() and kind != Storage::VALUES; ++i)
+    set(i, values[i]);
+  if (kind == Storage::VALUES)
+    this->values = values;
+}
+
+VMArray::~VMArray()
+{
+  unmap();
+}
+
+VMArray::VMArray(VMArray &&other) noexcept
+  : kind(other.kind), values(std::move(other.values)), ints(std::move(other.ints)),
+    doubles(std::move(other.doubles)), bools(std::move(other.bools)),
+    nulls(std::move(other.nulls)), mapping(other.mapping),
+    mapping_bytes(other.mapping_bytes), length(other.length)
+{
+  other.kind = Storage::VALUES;
+  other.mapping = nullptr;
+  other.mapping_bytes = 0;
+  other.length = 0;
+}
+
+VMArray &VMArray::operator=(VMArray &&other) noexcept
+{
+  if (this != &other)
+  {
+    unmap();
+    kind = other.kind;
+    values = std::move(other.values);
+    ints = std::move(other.ints);
+    doubles = std::move(other.doubles);
+    bools = std::move(other.bools);
+    nulls = std::move(other.nulls);
+    mapping = other.mapping;
+    mapping_bytes = other.mapping_bytes;
+    length = other.length;
+    other.kind = Storage::VALUES;
+    other.mapping = nullptr;
+    other.mapping_bytes = 0;
+    other.length = 0;
+  }
+  return *this;
+}
+
+void VMArray::unmap()
+{
+  if (mapping)
+    munmap(mapping, mapping_bytes);
+  mapping = nullptr;
+  mapping_bytes = 0;
+  length = 0;
+}
+
+bool VMArray::map_file(const string &path, bool of_doubles)
+{
+  unmap();
+  values.clear();
+  ints.clear();
+  doubles.clear();
+  bools.clear();
+  nulls.clear();
+  kind = Storage::VALUES;
+  size_t element_size = of_doubles ? sizeof(double) : sizeof(int32_t);
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat info;
+  if (fstat(fd, &info) != 0 or !S_ISREG(info.st_mode) or info.st_size % element_size != 0)
+  {
+    close(fd);
+    return false;
+  }
+  if (info.st_size > 0)
+  {
+    void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+      close(fd);
+      return false;
+    }
+    // scans go front to back
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+    mapping = data;
+    mapping_bytes = info.st_size;
+  }
+  close(fd);
+  kind = of_doubles ? Storage::MAPPED_DOUBLE : Storage::MAPPED_INT;
+  length = info.st_size / element_size;
+  return true;
+}
+
+VMArray::Storage VMArray::storage() const
+{
+  return kind;
+}
+
+bool VMArray::read_only() const
+{
+  return kind == Storage::MAPPED_INT or kind == Storage::MAPPED_DOUBLE;
+}
+
+size_t VMArray::size() const
+{
+  switch (kind)
+  {
+  case Storage::VALUES: return values.size();
+  case Storage::INT: return ints.size();
+  case Storage::DOUBLE: return doubles.size();
+  case Storage::BOOL: return bools.size();
+  default: return length;
+  }
+}
+
+VMValue VMArray::get(size_t i) const
+{
+  switch (kind)
+  {
+  case Storage::VALUES:
+    return values[i];
+  case Storage::INT:
+    if (nulls[i])
+      return nullptr;
+    return (int)ints[i];
+  case Storage::DOUBLE:
+    if (nulls[i])
+      return nullptr;
+    return doubles[i];
+  case Storage::BOOL:
+    if (nulls[i])
+      return nullptr;
+    return (bool)bools[i];
+  case Storage::MAPPED_INT:
+    return (int)static_cast<const int32_t *>(mapping)[i];
+  default:
+    return static_cast<const double *>(mapping)[i];
+  }
+}
+
+VMValue &VMArray::at(size_t i)
+{
+  return values[i];
+}
+
+void VMArray::set(size_t i, const VMValue &x)
+{
+  if (kind != Storage::VALUES)
+  {
+    bool null = holds_alternative<nullptr_t>(x);
+    if (kind == Storage::INT and (null or holds_alternative<int>(x)))
+    {
+      nulls[i] = null;
+      ints[i] = null ? 0 : std::get<int>(x);
+      return;
+    }
+    if (kind == Storage::DOUBLE and (null or holds_alternative<double>(x)))
+    {
+      nulls[i] = null;
+      doubles[i] = null ? 0.0 : std::get<double>(x);
+      return;
+    }
+    if (kind == Storage::BOOL and (null or holds_alternative<bool>(x)))
+    {
+      nulls[i] = null;
+      bools[i] = null ? false : std::get<bool>(x);
+      return;
+    }
+    box();
+  }
+  values[i] = x;
+}
+
+void VMArray::push_back(const VMValue &x)
+{
+  bool null = holds_alternative<nullptr_t>(x);
+  if (kind == Storage::INT and (null or holds_alternative<int>(x)))
+    ints.push_back(null ? 0 : std::get<int>(x));
+  else if (kind == Storage::DOUBLE and (null or holds_alternative<double>(x)))
+    doubles.push_back(null ? 0.0 : std::get<double>(x));
+  else if (kind == Storage::BOOL and (null or holds_alternative<bool>(x)))
+    bools.push_back(null ? false : std::get<bool>(x));
+  else
+  {
+    if (kind != Storage::VALUES)
+      box();
+    values.push_back(x);
+    return;
+  }
+  nulls.push_back(null);
+}
+
+VMValue VMArray::pop_back()
+{
+  VMValue x = get(size() - 1);
+  resize(size() - 1);
+  return x;
+}
+
+void VMArray::resize(size_t n)
+{
+  if (kind == Storage::VALUES)
+  {
+    values.resize(n, nullptr);
+    return;
+  }
+  if (kind == Storage::INT)
+    ints.resize(n, 0);
+  else if (kind == Storage::DOUBLE)
+    doubles.resize(n, 0.0);
+  else
+    bools.resize(n, false);
+  nulls.resize(n, true);
+}
+
+void VMArray::copy(size_t offset, const VMArray &src, size_t n)
+{
+  // when copying within one array to a later position the elements go
+  // last to first so none are overwritten before they are read
+  bool backward = this == &src and offset > 0;
+  if (kind == src.kind and (kind == Storage::INT or kind == Storage::DOUBLE))
+  {
+    // unboxed elements are moved as one block (and their null bits)
+    if (kind == Storage::INT)
+      memmove(ints.data() + offset, src.ints.data(), n * sizeof(int32_t));
+    else
+      memmove(doubles.data() + offset, src.doubles.data(), n * sizeof(double));
+    for (size_t k = 0; k < n; ++k)
+    {
+      size_t i = backward ? n - 1 - k : k;
+      nulls[offset + i] = src.nulls[i];
+    }
+    return;
+  }
+  for (size_t k = 0; k < n; ++k)
+  {
+    size_t i = backward ? n - 1 - k : k;
+    set(offset + i, src.get(i));
+  }
+}
+
+size_t VMArray::storage_bytes() const
+{
+  size_t n = size();
+  size_t bits = (n + 7) / 8;
+  switch (kind)
+  {
+  case Storage::VALUES: return n * sizeof(VMValue);
+  case Storage::INT: return n * sizeof(int32_t) + bits;
+  case Storage::DOUBLE: return n * sizeof(double) + bits;
+  case Storage::BOOL: return 2 * bits;
+  default: return 0;
+  }
+}
+
+void VMArray::box()
+{
+  vector<VMValue> boxed;
+  boxed.reserve(size());
+  for (size_t i = 0; i < size(); ++i)
+    boxed.push_back(get(i));
+  values = std::move(boxed);
+  ints = {};
+  doubles = {};
+  bools = {};
+  nulls = {};
+  kind = Storage::VALUES;
+}
+
+size_t VMArray::mapped_bytes() const
+{
+  return mapping_bytes;
+}
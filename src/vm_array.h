@@ -0,0 +1,111 @@
+//----------------------------------------------------------------------
+// FILE: vm_array.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Array objects of the VM heap. An array either owns its
+// elements or is a read-only view of a binary file of int32 or float64
+// values mapped into memory (so large datasets are not copied). Owned
+// int, double, and bool arrays are stored unboxed (with a bit per
+// element marking nulls) until a value of another type is stored.
+//----------------------------------------------------------------------
+
+#ifndef VM_ARRAY_H
+#define VM_ARRAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "vm_instr.h"
+
+class VMArray
+{
+public:
+  // how the elements are stored
+  enum class Storage {VALUES, INT, DOUBLE, BOOL, MAPPED_INT, MAPPED_DOUBLE};
+
+  VMArray() = default;
+
+  // an array of n copies of x
+  VMArray(int n, const VMValue &x);
+
+  // an array of n copies of x stored unboxed for the given element
+  // type (int, double, or bool) when x is null or of that type
+  VMArray(int n, const VMValue &x, const std::string &element_type);
+
+  // an array of the given values
+  explicit VMArray(std::vector<VMValue> &&values);
+
+  // a copy of the given values, stored unboxed for the element type
+  // (int, double, or bool) when each is null or of that type
+  VMArray(const std::vector<VMValue> &values, const std::string &element_type);
+
+  ~VMArray();
+
+  // arrays own their mappings, so they can only be moved
+  VMArray(const VMArray &) = delete;
+  VMArray(VMArray &&other) noexcept;
+  VMArray &operator=(const VMArray &) = delete;
+  VMArray &operator=(VMArray &&other) noexcept;
+
+  // map the file's native-endian int32 (or float64) values read-only,
+  // returning false (leaving the array empty) if it cannot be mapped
+  bool map_file(const std::string &path, bool of_doubles);
+
+  Storage storage() const;
+  bool read_only() const;
+  std::size_t size() const;
+
+  // the element at i (which must be in bounds)
+  VMValue get(std::size_t i) const;
+
+  // the element at i of a VALUES array (which must be in bounds)
+  VMValue &at(std::size_t i);
+
+  // store x at i of a writable array (which must be in bounds),
+  // switching to VALUES storage if x does not fit the unboxed store
+  void set(std::size_t i, const VMValue &x);
+
+  // add x after the last element of a writable array (amortized
+  // constant time), switching storage like set
+  void push_back(const VMValue &x);
+
+  // remove and return the last element of a writable, nonempty array
+  VMValue pop_back();
+
+  // grow (with null elements) or shrink a writable array to n elements
+  void resize(std::size_t n);
+
+  // copy elements [0, n) of src over [offset, offset + n) of this
+  // writable array (both in bounds, and src may be this array)
+  void copy(std::size_t offset, const VMArray &src, std::size_t n);
+
+  // bytes taken by the elements (not counting string contents)
+  std::size_t storage_bytes() const;
+
+  // bytes of the mapped file (0 if not mapped)
+  std::size_t mapped_bytes() const;
+
+private:
+  Storage kind = Storage::VALUES;
+  std::vector<VMValue> values;
+
+  // the unboxed stores (only the one for the storage is used), with
+  // nulls[i] set when element i is null
+  std::vector<std::int32_t> ints;
+  std::vector<double> doubles;
+  std::vector<bool> bools;
+  std::vector<bool> nulls;
+
+  // the mapping (for the mapped storages)
+  void *mapping = nullptr;
+  std::size_t mapping_bytes = 0;
+  std::size_t length = 0;
+
+  void unmap();
+
+  // move the elements to VALUES storage
+  void box();
+};
+
+#endif
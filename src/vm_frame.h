@@ -9,6 +9,7 @@
 #ifndef VM_FRAME_H
 #define VM_FRAME_H
 
+#include <cstddef>
 #include <stack>
 #include <string>
 #include <vector>
@@ -16,6 +17,16 @@
 
 // The following are plain-old-data classes
 
+class VMArrayConstant
+{
+public:
+  // the declared element type of the array
+  std::string element_type;
+
+  // the elements of the array literal
+  std::vector<VMValue> values;
+};
+
 class VMFrameInfo
 {
 public:
@@ -25,21 +36,28 @@ public:
   // the number of parameters of the assocated function
   int arg_count;
 
+  // the number of variable slots (parameters and locals) of the frame
+  int local_count = 0;
+
   // the program instructions
   std::vector<VMInstr> instructions;
+
+  // the array literals created by ALLOCA_CONST (indexed by its operand)
+  std::vector<VMArrayConstant> array_constants;
 };
 
 class VMFrame
 {
 public:
-  // the type of the current frame
-  VMFrameInfo info;
+  // the type of the current frame (shared by every call)
+  const VMFrameInfo *info = nullptr;
 
   // the program counter
   int pc = 0;
 
-  // the internal memory of the function
-  std::vector<VMValue> variables;
+  // the first of the frame's info->local_count variable slots in the
+  // vm's locals (the internal memory of the function)
+  std::size_t locals_base = 0;
 
   // the operand stack
   std::stack<VMValue> operand_stack;
@@ -5,6 +5,8 @@
 // DESC: Virtual machine instructions
 //----------------------------------------------------------------------
 
+#include <cctype>
+#include <charconv>
 #include <unordered_map>
 #include "vm_instr.h"
 
@@ -145,6 +147,11 @@ VMInstr VMInstr::JMPF(int instruction_index)
   return VMInstr(OpCode::JMPF, instruction_index);
 }
 
+VMInstr VMInstr::JMPT(int instruction_index)
+{
+  return VMInstr(OpCode::JMPT, instruction_index);
+}
+
 VMInstr VMInstr::CALL(const std::string &function)
 {
   return VMInstr(OpCode::CALL, function);
@@ -155,6 +162,11 @@ VMInstr VMInstr::RET()
   return VMInstr(OpCode::RET);
 }
 
+VMInstr VMInstr::TAILCALL(const std::string &function)
+{
+  return VMInstr(OpCode::TAILCALL, function);
+}
+
 VMInstr VMInstr::WRITE()
 {
   return VMInstr(OpCode::WRITE);
@@ -165,6 +177,31 @@ VMInstr VMInstr::READ()
   return VMInstr(OpCode::READ);
 }
 
+VMInstr VMInstr::READALL()
+{
+  return VMInstr(OpCode::READALL);
+}
+
+VMInstr VMInstr::READF()
+{
+  return VMInstr(OpCode::READF);
+}
+
+VMInstr VMInstr::READLNS()
+{
+  return VMInstr(OpCode::READLNS);
+}
+
+VMInstr VMInstr::MAPI()
+{
+  return VMInstr(OpCode::MAPI);
+}
+
+VMInstr VMInstr::MAPD()
+{
+  return VMInstr(OpCode::MAPD);
+}
+
 VMInstr VMInstr::SLEN()
 {
   return VMInstr(OpCode::SLEN);
@@ -200,6 +237,26 @@ VMInstr VMInstr::CONCAT()
   return VMInstr(OpCode::CONCAT);
 }
 
+VMInstr VMInstr::SUBSTR()
+{
+  return VMInstr(OpCode::SUBSTR);
+}
+
+VMInstr VMInstr::FIND()
+{
+  return VMInstr(OpCode::FIND);
+}
+
+VMInstr VMInstr::SPLIT()
+{
+  return VMInstr(OpCode::SPLIT);
+}
+
+VMInstr VMInstr::STARTSW()
+{
+  return VMInstr(OpCode::STARTSW);
+}
+
 VMInstr VMInstr::ALLOCS()
 {
   return VMInstr(OpCode::ALLOCS);
@@ -210,6 +267,16 @@ VMInstr VMInstr::ALLOCA()
   return VMInstr(OpCode::ALLOCA);
 }
 
+VMInstr VMInstr::ALLOCA(const string &element_type)
+{
+  return VMInstr(OpCode::ALLOCA, element_type);
+}
+
+VMInstr VMInstr::ALLOCA_CONST(int constant_index)
+{
+  return VMInstr(OpCode::ALLOCA_CONST, constant_index);
+}
+
 VMInstr VMInstr::ADDF(const string &field)
 {
   return VMInstr(OpCode::ADDF, field);
@@ -235,6 +302,56 @@ VMInstr VMInstr::GETI()
   return VMInstr(OpCode::GETI);
 }
 
+VMInstr VMInstr::APPEND()
+{
+  return VMInstr(OpCode::APPEND);
+}
+
+VMInstr VMInstr::APOP()
+{
+  return VMInstr(OpCode::APOP);
+}
+
+VMInstr VMInstr::ARESIZE()
+{
+  return VMInstr(OpCode::ARESIZE);
+}
+
+VMInstr VMInstr::ACOPY()
+{
+  return VMInstr(OpCode::ACOPY);
+}
+
+VMInstr VMInstr::ALLOCM(const string &key_type)
+{
+  return VMInstr(OpCode::ALLOCM, key_type);
+}
+
+VMInstr VMInstr::MGET()
+{
+  return VMInstr(OpCode::MGET);
+}
+
+VMInstr VMInstr::MPUT()
+{
+  return VMInstr(OpCode::MPUT);
+}
+
+VMInstr VMInstr::MHAS()
+{
+  return VMInstr(OpCode::MHAS);
+}
+
+VMInstr VMInstr::MDEL()
+{
+  return VMInstr(OpCode::MDEL);
+}
+
+VMInstr VMInstr::MKEYS()
+{
+  return VMInstr(OpCode::MKEYS);
+}
+
 VMInstr VMInstr::DUP()
 {
   return VMInstr(OpCode::DUP);
@@ -247,24 +364,73 @@ VMInstr VMInstr::NOP()
 
 string to_string(const VMValue &val)
 {
-  if (holds_alternative<int>(val))
-    return to_string(get<int>(val));
-  else if (holds_alternative<double>(val))
-    return to_string(get<double>(val));
+  if (holds_alternative<int>(val) or holds_alternative<double>(val))
+  {
+    char buf[NUMBER_CHARS];
+    return string(format_number(val, buf));
+  }
   else if (holds_alternative<bool>(val) and get<bool>(val))
     return "true";
   else if (holds_alternative<bool>(val) and !get<bool>(val))
     return "false";
-  else if (holds_alternative<string>(val))
-    return get<string>(val);
+  else if (holds_alternative<VMString>(val))
+    return get<VMString>(val).str();
+  else if (holds_alternative<char>(val))
+    return string(1, get<char>(val));
   else
     return "null";
 }
 
+string_view format_number(const VMValue &val, char *buf)
+{
+  to_chars_result r;
+  if (holds_alternative<int>(val))
+    r = to_chars(buf, buf + NUMBER_CHARS, get<int>(val));
+  else
+    r = to_chars(buf, buf + NUMBER_CHARS, get<double>(val), chars_format::fixed, 6);
+  return string_view(buf, r.ptr - buf);
+}
+
+// the digits of s after any leading whitespace and a '+' sign (which
+// from_chars does not accept, unlike strtol and strtod)
+static string_view number_start(string_view s)
+{
+  size_t i = 0;
+  while (i < s.size() and isspace((unsigned char)s[i]))
+    ++i;
+  if (i + 1 < s.size() and s[i] == '+' and s[i + 1] != '-')
+    ++i;
+  return s.substr(i);
+}
+
+bool parse_int(string_view s, int &x)
+{
+  s = number_start(s);
+  return from_chars(s.data(), s.data() + s.size(), x).ec == errc();
+}
+
+bool parse_double(string_view s, double &x)
+{
+  s = number_start(s);
+  const char *first = s.data(), *last = s.data() + s.size();
+  // hexadecimal like strtod, e.g., "0x1p4" or "-0x10"
+  bool negative = first != last and *first == '-';
+  const char *digits = first + negative;
+  if (last - digits > 2 and digits[0] == '0' and (digits[1] | 0x20) == 'x' and digits[2] != '-')
+  {
+    if (from_chars(digits + 2, last, x, chars_format::hex).ec == errc())
+    {
+      x = negative ? -x : x;
+      return true;
+    }
+  }
+  return from_chars(first, last, x).ec == errc();
+}
+
 std::string to_string(const VMInstr &instr)
 {
   std::unordered_map<OpCode, string> os = {
-      {OpCode::PUSH, "PUSH"}, {OpCode::POP, "POP"}, {OpCode::LOAD, "LOAD"}, {OpCode::STORE, "STORE"}, {OpCode::ADD, "ADD"}, {OpCode::SUB, "SUB"}, {OpCode::MUL, "MUL"}, {OpCode::DIV, "DIV"}, {OpCode::AND, "AND"}, {OpCode::OR, "OR"}, {OpCode::NOT, "NOT"}, {OpCode::CMPLT, "CMPLT"}, {OpCode::CMPLE, "CMPLE"}, {OpCode::CMPGT, "CMPGT"}, {OpCode::CMPGE, "CMPGE"}, {OpCode::CMPEQ, "CMPEQ"}, {OpCode::CMPNE, "CMPNE"}, {OpCode::JMP, "JMP"}, {OpCode::JMPF, "JMPF"}, {OpCode::CALL, "CALL"}, {OpCode::RET, "RET"}, {OpCode::WRITE, "WRITE"}, {OpCode::READ, "READ"}, {OpCode::SLEN, "SLEN"}, {OpCode::ALEN, "ALEN"}, {OpCode::GETC, "GETC"}, {OpCode::TOINT, "TOINT"}, {OpCode::TODBL, "TODBL"}, {OpCode::TOSTR, "TOSTR"}, {OpCode::CONCAT, "CONCAT"}, {OpCode::ALLOCS, "ALLOCS"}, {OpCode::ALLOCA, "ALLOCA"}, {OpCode::ADDF, "ADDF"}, {OpCode::GETF, "GETF"}, {OpCode::SETF, "SETF"}, {OpCode::GETI, "GETI"}, {OpCode::SETI, "SETI"}, {OpCode::DUP, "DUP"}, {OpCode::NOP, "NOP"}};
+      {OpCode::PUSH, "PUSH"}, {OpCode::POP, "POP"}, {OpCode::LOAD, "LOAD"}, {OpCode::STORE, "STORE"}, {OpCode::ADD, "ADD"}, {OpCode::SUB, "SUB"}, {OpCode::MUL, "MUL"}, {OpCode::DIV, "DIV"}, {OpCode::AND, "AND"}, {OpCode::OR, "OR"}, {OpCode::NOT, "NOT"}, {OpCode::CMPLT, "CMPLT"}, {OpCode::CMPLE, "CMPLE"}, {OpCode::CMPGT, "CMPGT"}, {OpCode::CMPGE, "CMPGE"}, {OpCode::CMPEQ, "CMPEQ"}, {OpCode::CMPNE, "CMPNE"}, {OpCode::RAND, "RAND"}, {OpCode::JMP, "JMP"}, {OpCode::JMPF, "JMPF"}, {OpCode::JMPT, "JMPT"}, {OpCode::CALL, "CALL"}, {OpCode::RET, "RET"}, {OpCode::TAILCALL, "TAILCALL"}, {OpCode::WRITE, "WRITE"}, {OpCode::READ, "READ"}, {OpCode::READALL, "READALL"}, {OpCode::READF, "READF"}, {OpCode::READLNS, "READLNS"}, {OpCode::MAPI, "MAPI"}, {OpCode::MAPD, "MAPD"}, {OpCode::SLEN, "SLEN"}, {OpCode::ALEN, "ALEN"}, {OpCode::GETC, "GETC"}, {OpCode::TOINT, "TOINT"}, {OpCode::TODBL, "TODBL"}, {OpCode::TOSTR, "TOSTR"}, {OpCode::CONCAT, "CONCAT"}, {OpCode::SUBSTR, "SUBSTR"}, {OpCode::FIND, "FIND"}, {OpCode::SPLIT, "SPLIT"}, {OpCode::STARTSW, "STARTSW"}, {OpCode::ALLOCS, "ALLOCS"}, {OpCode::ALLOCA, "ALLOCA"}, {OpCode::ALLOCA_CONST, "ALLOCA_CONST"}, {OpCode::ADDF, "ADDF"}, {OpCode::GETF, "GETF"}, {OpCode::SETF, "SETF"}, {OpCode::GETI, "GETI"}, {OpCode::SETI, "SETI"}, {OpCode::APPEND, "APPEND"}, {OpCode::APOP, "APOP"}, {OpCode::ARESIZE, "ARESIZE"}, {OpCode::ACOPY, "ACOPY"}, {OpCode::ALLOCM, "ALLOCM"}, {OpCode::MGET, "MGET"}, {OpCode::MPUT, "MPUT"}, {OpCode::MHAS, "MHAS"}, {OpCode::MDEL, "MDEL"}, {OpCode::MKEYS, "MKEYS"}, {OpCode::DUP, "DUP"}, {OpCode::NOP, "NOP"}};
   string vstr = "";
   if (instr.operand().has_value())
   {
@@ -11,14 +11,30 @@
 #include <variant>
 #include <optional>
 #include <string>
+#include <string_view>
 #include "op_code.h"
+#include "vm_string.h"
 
-// vm values are one of int, double, bool, string, or nullptr_t
-typedef std::variant<int, double, bool, std::string, std::nullptr_t> VMValue;
+// vm values are one of int, double, bool, string, nullptr_t, or char
+// (strings are immutable and shared, see vm_string.h)
+typedef std::variant<int, double, bool, VMString, std::nullptr_t, char> VMValue;
 
 // function to get a string representation of a vm_value
 std::string to_string(const VMValue &val);
 
+// room for any int, and any double with six decimals
+const std::size_t NUMBER_CHARS = 512;
+
+// write an int or double into buf (NUMBER_CHARS long), doubles with six
+// decimals like printf's %f, returning the characters written
+std::string_view format_number(const VMValue &val, char *buf);
+
+// parse the number at the start of s like stoi and stod (skipping
+// leading whitespace and ignoring trailing characters), returning false
+// if there is none or it is out of range
+bool parse_int(std::string_view s, int &x);
+bool parse_double(std::string_view s, double &x);
+
 class VMInstr
 {
 public:
@@ -43,10 +59,17 @@ public:
   static VMInstr RAND();
   static VMInstr JMP(int instruction_index);
   static VMInstr JMPF(int instruction_index);
+  static VMInstr JMPT(int instruction_index);
   static VMInstr CALL(const std::string &function);
   static VMInstr RET();
+  static VMInstr TAILCALL(const std::string &function);
   static VMInstr WRITE();
   static VMInstr READ();
+  static VMInstr READALL();
+  static VMInstr READF();
+  static VMInstr READLNS();
+  static VMInstr MAPI();
+  static VMInstr MAPD();
   static VMInstr SLEN();
   static VMInstr ALEN();
   static VMInstr GETC();
@@ -54,13 +77,29 @@ public:
   static VMInstr TODBL();
   static VMInstr TOSTR();
   static VMInstr CONCAT();
+  static VMInstr SUBSTR();
+  static VMInstr FIND();
+  static VMInstr SPLIT();
+  static VMInstr STARTSW();
   static VMInstr ALLOCS();
   static VMInstr ALLOCA();
+  static VMInstr ALLOCA(const std::string &element_type);
+  static VMInstr ALLOCA_CONST(int constant_index);
   static VMInstr ADDF(const std::string &field);
   static VMInstr SETF(const std::string &field);
   static VMInstr GETF(const std::string &field);
   static VMInstr SETI();
   static VMInstr GETI();
+  static VMInstr APPEND();
+  static VMInstr APOP();
+  static VMInstr ARESIZE();
+  static VMInstr ACOPY();
+  static VMInstr ALLOCM(const std::string &key_type);
+  static VMInstr MGET();
+  static VMInstr MPUT();
+  static VMInstr MHAS();
+  static VMInstr MDEL();
+  static VMInstr MKEYS();
   static VMInstr DUP();
   static VMInstr NOP();
 
@@ -82,6 +121,9 @@ public:
   // pretty print the instruction
   friend std::string to_string(const VMInstr &instr);
 
+  // the build cache recreates instructions from their opcodes
+  friend class BuildCache;
+
 private:
   // each instruction has an opcode
   OpCode instr_opcode;
@@ -0,0 +1,161 @@
+//----------------------------------------------------------------------
+// FILE: vm_map.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: VM hash map object implementation
+//----------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <utility>
+#include "vm_map.h"
+
+using namespace std;
+
+VMMap::VMMap(const string &key_type)
+  : keys_type(key_type)
+{
+}
+
+const string &VMMap::key_type() const
+{
+  return keys_type;
+}
+
+size_t VMMap::size() const
+{
+  return entry_keys.size();
+}
+
+const VMValue *VMMap::find(const VMValue &key) const
+{
+  if (slots.empty())
+    return nullptr;
+  int32_t entry = slots[probe(key, hash(key))];
+  return entry == EMPTY ? nullptr : &entry_values[entry];
+}
+
+VMValue *VMMap::find(const VMValue &key)
+{
+  return const_cast<VMValue *>(as_const(*this).find(key));
+}
+
+VMValue &VMMap::put(const VMValue &key)
+{
+  size_t h = hash(key);
+  size_t i = 0;
+  if (!slots.empty())
+  {
+    i = probe(key, h);
+    if (slots[i] != EMPTY)
+      return entry_values[slots[i]];
+  }
+  if (2 * (size() + 1) > slots.size())
+  {
+    rehash(max<size_t>(8, 2 * slots.size()));
+    i = probe(key, h);
+  }
+  slots[i] = size();
+  entry_keys.push_back(key);
+  entry_values.push_back(nullptr);
+  hashes.push_back(h);
+  return entry_values.back();
+}
+
+bool VMMap::remove(const VMValue &key)
+{
+  if (slots.empty())
+    return false;
+  size_t i = probe(key, hash(key));
+  if (slots[i] == EMPTY)
+    return false;
+  size_t entry = slots[i];
+  // move back each later slot of the run whose probe sequence passes
+  // through the hole, so lookups never stop early at it
+  size_t mask = slots.size() - 1;
+  for (size_t j = (i + 1) & mask; slots[j] != EMPTY; j = (j + 1) & mask)
+  {
+    size_t home = hashes[slots[j]] & mask;
+    if (((j - home) & mask) >= ((j - i) & mask))
+    {
+      slots[i] = slots[j];
+      i = j;
+    }
+  }
+  slots[i] = EMPTY;
+  // keep the entries dense by moving the last one into the gap
+  size_t last = size() - 1;
+  if (entry != last)
+  {
+    slots[probe(entry_keys[last], hashes[last])] = entry;
+    entry_keys[entry] = std::move(entry_keys[last]);
+    entry_values[entry] = std::move(entry_values[last]);
+    hashes[entry] = hashes[last];
+  }
+  entry_keys.pop_back();
+  entry_values.pop_back();
+  hashes.pop_back();
+  return true;
+}
+
+const vector<VMValue> &VMMap::keys() const
+{
+  return entry_keys;
+}
+
+size_t VMMap::storage_bytes() const
+{
+  return size() * (2 * sizeof(VMValue) + sizeof(size_t)) +
+    slots.size() * sizeof(int32_t);
+}
+
+size_t VMMap::hash(const VMValue &key)
+{
+  if (holds_alternative<VMString>(key))
+    return std::hash<string_view>{}(get<VMString>(key).view());
+  uint64_t bits = 0;
+  if (holds_alternative<int>(key))
+    bits = static_cast<uint32_t>(get<int>(key));
+  else if (holds_alternative<double>(key))
+  {
+    // 0.0 and -0.0 are equal keys
+    double x = get<double>(key) == 0 ? 0.0 : get<double>(key);
+    memcpy(&bits, &x, sizeof(x));
+  }
+  else if (holds_alternative<char>(key))
+    bits = static_cast<unsigned char>(get<char>(key));
+  else if (holds_alternative<bool>(key))
+    bits = get<bool>(key);
+  // mix the bits (the splitmix64 finalizer) so that runs of keys such
+  // as consecutive ints spread over the table
+  bits ^= bits >> 30;
+  bits *= 0xbf58476d1ce4e5b9;
+  bits ^= bits >> 27;
+  bits *= 0x94d049bb133111eb;
+  bits ^= bits >> 31;
+  return bits;
+}
+
+size_t VMMap::probe(const VMValue &key, size_t h) const
+{
+  size_t mask = slots.size() - 1;
+  size_t i = h & mask;
+  while (slots[i] != EMPTY and (hashes[slots[i]] != h or entry_keys[slots[i]] != key))
+    i = (i + 1) & mask;
+  return i;
+}
+
+void VMMap::rehash(size_t n)
+{
+  slots.assign(n, EMPTY);
+  size_t mask = n - 1;
+  for (size_t entry = 0; entry < size(); ++entry)
+  {
+    size_t i = hashes[entry] & mask;
+    while (slots[i] != EMPTY)
+      i = (i + 1) & mask;
+    slots[i] = entry;
+  }
+}
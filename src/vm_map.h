@@ -0,0 +1,78 @@
+//----------------------------------------------------------------------
+// FILE: vm_map.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Hash map objects of the VM heap. The entries are kept densely
+// (keys, values, and their hashes in insertion order) and found through
+// an open-addressing table of entry indexes with linear probing, so a
+// lookup touches a few int32 slots and one key. Removing a key moves
+// the last entry into its place and shifts the probe sequence back
+// (the table has no tombstones).
+//----------------------------------------------------------------------
+
+#ifndef VM_MAP_H
+#define VM_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "vm_instr.h"
+
+class VMMap
+{
+public:
+  VMMap() = default;
+
+  // an empty map with keys of the given type
+  explicit VMMap(const std::string &key_type);
+
+  // the key type (which selects the store of the keys array as for
+  // an array of that element type)
+  const std::string &key_type() const;
+
+  std::size_t size() const;
+
+  // the value of key (nullptr if key is missing)
+  VMValue *find(const VMValue &key);
+  const VMValue *find(const VMValue &key) const;
+
+  // the value of key, adding key with a null value if missing
+  VMValue &put(const VMValue &key);
+
+  // remove key, returning false if it is missing
+  bool remove(const VMValue &key);
+
+  // the keys in insertion order (except that removing a key moves the
+  // last key into its place)
+  const std::vector<VMValue> &keys() const;
+
+  // bytes taken by the entries and the table (not counting string
+  // contents)
+  std::size_t storage_bytes() const;
+
+private:
+  static constexpr std::int32_t EMPTY = -1;
+
+  std::string keys_type;
+
+  // the entries
+  std::vector<VMValue> entry_keys;
+  std::vector<VMValue> entry_values;
+  std::vector<std::size_t> hashes;
+
+  // entry indexes (or EMPTY), a power of two in size and at most half
+  // full
+  std::vector<std::int32_t> slots;
+
+  static std::size_t hash(const VMValue &key);
+
+  // the slot holding key's entry, or the empty slot ending its probe
+  // sequence (the table must not be empty)
+  std::size_t probe(const VMValue &key, std::size_t h) const;
+
+  // rebuild the table with n slots
+  void rehash(std::size_t n);
+};
+
+#endif
@@ -0,0 +1,72 @@
+//----------------------------------------------------------------------
+// FILE: vm_output.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Buffered VM output implementation
+//----------------------------------------------------------------------
+
+#include "vm_output.h"
+
+using namespace std;
+
+VMOutput::VMOutput(ostream &out, size_t capacity)
+  : out(&out), capacity(capacity)
+{
+  buffer.reserve(capacity);
+}
+
+VMOutput::~VMOutput()
+{
+  flush();
+}
+
+void VMOutput::append(const char *s, size_t n)
+{
+  if (buffer.size() + n > capacity)
+  {
+    flush();
+    // too big to be worth buffering
+    if (n > capacity)
+    {
+      out->write(s, n);
+      return;
+    }
+  }
+  buffer.append(s, n);
+}
+
+void VMOutput::write(const VMValue &x)
+{
+  if (holds_alternative<int>(x) or holds_alternative<double>(x))
+  {
+    char digits[NUMBER_CHARS];
+    string_view s = format_number(x, digits);
+    append(s.data(), s.size());
+  }
+  else if (holds_alternative<bool>(x))
+  {
+    if (get<bool>(x))
+      append("true", 4);
+    else
+      append("false", 5);
+  }
+  else if (holds_alternative<VMString>(x))
+  {
+    const VMString &s = get<VMString>(x);
+    append(s.data(), s.size());
+  }
+  else if (holds_alternative<char>(x))
+    append(&get<char>(x), 1);
+  else
+    append("null", 4);
+}
+
+void VMOutput::flush()
+{
+  if (!buffer.empty())
+  {
+    out->write(buffer.data(), buffer.size());
+    buffer.clear();
+  }
+  out->flush();
+}
@@ -0,0 +1,45 @@
+//----------------------------------------------------------------------
+// FILE: vm_output.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Buffered output for the VM's WRITE instruction. Values are
+// formatted straight into a large buffer (ints and doubles with
+// to_chars, matching to_string) that is handed to the stream in one
+// write when it fills up or is flushed.
+//----------------------------------------------------------------------
+
+#ifndef VM_OUTPUT_H
+#define VM_OUTPUT_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include "vm_instr.h"
+
+class VMOutput
+{
+public:
+  // buffer up to capacity bytes before writing to out
+  explicit VMOutput(std::ostream &out, std::size_t capacity = 1 << 16);
+  ~VMOutput();
+
+  // moving keeps the buffered output (a copy would write it twice)
+  VMOutput(const VMOutput &) = delete;
+  VMOutput(VMOutput &&) = default;
+  VMOutput &operator=(const VMOutput &) = delete;
+
+  // append the value formatted as by to_string
+  void write(const VMValue &x);
+
+  // hand the buffered output to the stream and flush it
+  void flush();
+
+private:
+  std::ostream *out;
+  std::size_t capacity;
+  std::string buffer;
+
+  void append(const char *s, std::size_t n);
+};
+
+#endif
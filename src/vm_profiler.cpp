@@ -0,0 +1,257 @@
+//----------------------------------------------------------------------
+// FILE: vm_profiler.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: VM execution profiler implementation
+//----------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include "vm_profiler.h"
+
+using namespace std;
+
+// NOP is the last opcode
+const int OPCODE_COUNT = static_cast<int>(OpCode::NOP) + 1;
+
+VMProfiler::VMProfiler()
+  : opcodes(OPCODE_COUNT), opcode_names(OPCODE_COUNT)
+{
+}
+
+void VMProfiler::call(const VMFrameInfo &info)
+{
+  resume(info);
+  ++curr_fun->calls;
+}
+
+void VMProfiler::resume(const VMFrameInfo &info)
+{
+  FunctionProfile &profile = function_profiles[info.function_name];
+  if (profile.pcs.size() != info.instructions.size())
+  {
+    profile.pcs.resize(info.instructions.size());
+    profile.instructions.clear();
+    for (const VMInstr &instr : info.instructions)
+      profile.instructions.push_back(to_string(instr));
+  }
+  curr_fun = &profile;
+  curr_info = &info;
+}
+
+void VMProfiler::step(int pc)
+{
+  Clock::time_point now = Clock::now();
+  if (running)
+    charge(now);
+  const VMInstr &instr = curr_info->instructions[pc];
+  int op = static_cast<int>(instr.opcode());
+  if (opcode_names[op].empty())
+  {
+    string name = to_string(instr);
+    opcode_names[op] = name.substr(0, name.find('('));
+  }
+  curr_op = &opcodes[op];
+  curr_pc = &curr_fun->pcs[pc];
+  curr_total = &curr_fun->total;
+  ++curr_op->count;
+  ++curr_pc->count;
+  ++curr_total->count;
+  running = true;
+  started = now;
+}
+
+void VMProfiler::stop()
+{
+  if (running)
+    charge(Clock::now());
+  running = false;
+}
+
+void VMProfiler::charge(Clock::time_point now)
+{
+  uint64_t ns = chrono::duration_cast<chrono::nanoseconds>(now - started).count();
+  curr_op->ns += ns;
+  curr_pc->ns += ns;
+  curr_total->ns += ns;
+}
+
+VMProfiler::Counter VMProfiler::total() const
+{
+  Counter total;
+  for (const Counter &c : opcodes)
+  {
+    total.count += c.count;
+    total.ns += c.ns;
+  }
+  return total;
+}
+
+VMProfiler::Counter VMProfiler::opcode(OpCode op) const
+{
+  return opcodes[static_cast<int>(op)];
+}
+
+const unordered_map<string, VMProfiler::FunctionProfile> &VMProfiler::functions() const
+{
+  return function_profiles;
+}
+
+//----------------------------------------------------------------------
+// Output
+//----------------------------------------------------------------------
+
+namespace {
+
+// a single instruction of a function with its counter
+struct PCEntry
+{
+  string function;
+  int pc;
+  string instr;
+  VMProfiler::Counter counter;
+};
+
+// hottest first (then most executed, then by name for stable output)
+template <typename T>
+void sort_by_time(vector<T> &entries)
+{
+  sort(entries.begin(), entries.end(), [](const T &x, const T &y) {
+    if (x.counter.ns != y.counter.ns)
+      return x.counter.ns > y.counter.ns;
+    if (x.counter.count != y.counter.count)
+      return x.counter.count > y.counter.count;
+    return x.name < y.name;
+  });
+}
+
+struct NamedEntry
+{
+  string name;
+  uint64_t calls;
+  VMProfiler::Counter counter;
+};
+
+string ms(uint64_t ns)
+{
+  stringstream s;
+  s << fixed << setprecision(3) << ns / 1e6;
+  return s.str();
+}
+
+string percent(uint64_t part, uint64_t whole)
+{
+  stringstream s;
+  s << fixed << setprecision(1) << (whole ? 100.0 * part / whole : 0.0) << "%";
+  return s.str();
+}
+
+string json_string(const string &s)
+{
+  string result = "\"";
+  for (char c : s)
+  {
+    if (c == '"' or c == '\\')
+      result += string("\\") + c;
+    else if (c == '\n')
+      result += "\\n";
+    else if (c == '\t')
+      result += "\\t";
+    else if (static_cast<unsigned char>(c) < 0x20)
+    {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      result += buf;
+    }
+    else
+      result += c;
+  }
+  return result + "\"";
+}
+
+}
+
+void VMProfiler::report(ostream &out, int top_pcs) const
+{
+  Counter all = total();
+  out << "[Profile] " << all.count << " instructions in " << ms(all.ns) << " ms" << endl;
+
+  vector<NamedEntry> funs;
+  vector<PCEntry> pcs;
+  for (const auto &[name, profile] : function_profiles)
+  {
+    funs.push_back({name, profile.calls, profile.total});
+    for (int pc = 0; pc < profile.pcs.size(); ++pc)
+      if (profile.pcs[pc].count > 0)
+        pcs.push_back({name, pc, profile.instructions[pc], profile.pcs[pc]});
+  }
+  sort_by_time(funs);
+  out << endl << left << setw(20) << "function" << right << setw(10) << "calls"
+      << setw(14) << "instrs" << setw(12) << "ms" << setw(8) << "time" << endl;
+  for (const NamedEntry &f : funs)
+    out << left << setw(20) << f.name << right << setw(10) << f.calls
+        << setw(14) << f.counter.count << setw(12) << ms(f.counter.ns)
+        << setw(8) << percent(f.counter.ns, all.ns) << endl;
+
+  vector<NamedEntry> ops;
+  for (int op = 0; op < OPCODE_COUNT; ++op)
+    if (opcodes[op].count > 0)
+      ops.push_back({opcode_names[op], 0, opcodes[op]});
+  sort_by_time(ops);
+  out << endl << left << setw(20) << "opcode" << right << setw(24) << "count"
+      << setw(12) << "ms" << setw(8) << "time" << endl;
+  for (const NamedEntry &op : ops)
+    out << left << setw(20) << op.name << right << setw(24) << op.counter.count
+        << setw(12) << ms(op.counter.ns) << setw(8) << percent(op.counter.ns, all.ns) << endl;
+
+  stable_sort(pcs.begin(), pcs.end(), [](const PCEntry &x, const PCEntry &y) {
+    return x.counter.ns > y.counter.ns;
+  });
+  out << endl << left << setw(44) << "instruction" << right << setw(14) << "count"
+      << setw(12) << "ms" << setw(8) << "time" << endl;
+  for (int i = 0; i < pcs.size() and i < top_pcs; ++i)
+  {
+    string where = pcs[i].function + "@" + std::to_string(pcs[i].pc) + " " + pcs[i].instr;
+    out << left << setw(44) << where << right << setw(14) << pcs[i].counter.count
+        << setw(12) << ms(pcs[i].counter.ns) << setw(8) << percent(pcs[i].counter.ns, all.ns) << endl;
+  }
+}
+
+void VMProfiler::write_json(ostream &out) const
+{
+  Counter all = total();
+  out << "{\n  \"instructions\": " << all.count << ",\n  \"ns\": " << all.ns << ",\n";
+  out << "  \"opcodes\": [";
+  bool first = true;
+  for (int op = 0; op < OPCODE_COUNT; ++op)
+  {
+    if (opcodes[op].count == 0)
+      continue;
+    out << (first ? "\n" : ",\n") << "    {\"opcode\": " << json_string(opcode_names[op])
+        << ", \"count\": " << opcodes[op].count << ", \"ns\": " << opcodes[op].ns << "}";
+    first = false;
+  }
+  out << "\n  ],\n  \"functions\": [";
+  first = true;
+  for (const auto &[name, profile] : function_profiles)
+  {
+    out << (first ? "\n" : ",\n") << "    {\"name\": " << json_string(name)
+        << ", \"calls\": " << profile.calls << ", \"instructions\": " << profile.total.count
+        << ", \"ns\": " << profile.total.ns << ", \"pcs\": [";
+    bool first_pc = true;
+    for (int pc = 0; pc < profile.pcs.size(); ++pc)
+    {
+      if (profile.pcs[pc].count == 0)
+        continue;
+      out << (first_pc ? "\n" : ",\n") << "      {\"pc\": " << pc << ", \"instr\": "
+          << json_string(profile.instructions[pc]) << ", \"count\": " << profile.pcs[pc].count
+          << ", \"ns\": " << profile.pcs[pc].ns << "}";
+      first_pc = false;
+    }
+    out << "\n    ]}";
+    first = false;
+  }
+  out << "\n  ]\n}\n";
+}
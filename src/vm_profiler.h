@@ -0,0 +1,88 @@
+//----------------------------------------------------------------------
+// FILE: vm_profiler.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Execution profiler for the VM. Counts each executed
+// instruction and charges the steady_clock time until the next one to
+// it, totaled per opcode, per function, and per (function, pc).
+//----------------------------------------------------------------------
+
+#ifndef VM_PROFILER_H
+#define VM_PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "vm_frame.h"
+
+class VMProfiler
+{
+public:
+  VMProfiler();
+
+  // execution count and time (in nanoseconds)
+  struct Counter
+  {
+    std::uint64_t count = 0;
+    std::uint64_t ns = 0;
+  };
+
+  // totals for one function
+  struct FunctionProfile
+  {
+    std::uint64_t calls = 0;
+    Counter total;
+    std::vector<Counter> pcs;
+    std::vector<std::string> instructions;
+  };
+
+  // called by the vm when a call of the function starts and when
+  // execution returns into it
+  void call(const VMFrameInfo &info);
+  void resume(const VMFrameInfo &info);
+
+  // called by the vm before executing the instruction at pc of the
+  // current function
+  void step(int pc);
+
+  // charge the time of the last instruction (called when the vm stops)
+  void stop();
+
+  // the collected counters
+  Counter total() const;
+  Counter opcode(OpCode op) const;
+  const std::unordered_map<std::string, FunctionProfile> &functions() const;
+
+  // human-readable report, sorted by time (hottest first), listing
+  // at most top_pcs individual instructions
+  void report(std::ostream &out, int top_pcs = 20) const;
+
+  // the same data as json
+  void write_json(std::ostream &out) const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::vector<Counter> opcodes;
+  std::vector<std::string> opcode_names;
+  std::unordered_map<std::string, FunctionProfile> function_profiles;
+
+  // the instruction currently being timed
+  bool running = false;
+  Clock::time_point started;
+  Counter *curr_op = nullptr;
+  Counter *curr_pc = nullptr;
+  Counter *curr_total = nullptr;
+
+  // the function being executed and its instructions
+  FunctionProfile *curr_fun = nullptr;
+  const VMFrameInfo *curr_info = nullptr;
+
+  // charge the time since the current instruction started to it
+  void charge(Clock::time_point now);
+};
+
+#endif
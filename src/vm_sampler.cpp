@@ -0,0 +1,104 @@
+//----------------------------------------------------------------------
+// FILE: vm_sampler.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Statistical VM profiler implementation
+//----------------------------------------------------------------------
+
+#include <sys/time.h>
+#include "mypl_exception.h"
+#include "vm_sampler.h"
+
+using namespace std;
+
+volatile sig_atomic_t VMSampler::signaled = 0;
+
+VMSampler::VMSampler(int hz)
+  : hz(hz)
+{
+  if (hz <= 0 or hz > 1000000)
+    throw MyPLException("Sampler Error: rate must be between 1 and 1000000 per second");
+}
+
+VMSampler::~VMSampler()
+{
+  stop();
+}
+
+void VMSampler::set_instruction_interval(uint64_t instructions)
+{
+  interval = instructions;
+  countdown = instructions;
+}
+
+void VMSampler::on_signal(int)
+{
+  signaled = 1;
+}
+
+void VMSampler::start()
+{
+  if (running or interval)
+    return;
+  signaled = 0;
+  struct sigaction action = {};
+  action.sa_handler = on_signal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGPROF, &action, &old_action) != 0)
+    throw MyPLException("Sampler Error: could not install the SIGPROF handler");
+  // ITIMER_PROF counts the cpu time of the process, so time spent
+  // waiting (e.g., on input) is not sampled
+  // (tv_usec must stay below a second, so slow rates use tv_sec)
+  int period = 1000000 / hz;
+  itimerval timer = {};
+  timer.it_interval.tv_sec = period / 1000000;
+  timer.it_interval.tv_usec = period % 1000000;
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+  {
+    sigaction(SIGPROF, &old_action, nullptr);
+    throw MyPLException("Sampler Error: could not start the profiling timer");
+  }
+  running = true;
+}
+
+void VMSampler::stop()
+{
+  if (!running)
+    return;
+  itimerval timer = {};
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  sigaction(SIGPROF, &old_action, nullptr);
+  signaled = 0;
+  running = false;
+}
+
+void VMSampler::sample(const vector<string> &stack)
+{
+  string key;
+  for (const string &name : stack)
+  {
+    if (!key.empty())
+      key += ";";
+    key += name;
+  }
+  ++folded[key];
+  ++sample_count;
+}
+
+uint64_t VMSampler::samples() const
+{
+  return sample_count;
+}
+
+const map<string, uint64_t> &VMSampler::stacks() const
+{
+  return folded;
+}
+
+void VMSampler::write_folded(ostream &out) const
+{
+  for (const auto &[stack, count] : folded)
+    out << stack << " " << count << "\n";
+}
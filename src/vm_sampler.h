@@ -0,0 +1,81 @@
+//----------------------------------------------------------------------
+// FILE: vm_sampler.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Statistical profiler for the VM. A SIGPROF timer (or, for
+// deterministic runs, an instruction count) marks a sample as due,
+// the vm checks the mark between instructions and hands over its call
+// stack, and the stacks are counted in the folded format used by
+// flamegraph tools ("main;f;g 12").
+//----------------------------------------------------------------------
+
+#ifndef VM_SAMPLER_H
+#define VM_SAMPLER_H
+
+#include <csignal>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class VMSampler
+{
+public:
+  // sample at the given rate (per second of cpu time)
+  explicit VMSampler(int hz = 1000);
+  ~VMSampler();
+
+  VMSampler(const VMSampler &) = delete;
+  VMSampler &operator=(const VMSampler &) = delete;
+
+  // sample every given number of executed instructions instead of on
+  // the timer (0 to go back to the timer)
+  void set_instruction_interval(std::uint64_t instructions);
+
+  // arm and disarm the timer (only one sampler can run at a time)
+  void start();
+  void stop();
+
+  // called by the vm before each instruction, true if a sample is due
+  bool due()
+  {
+    if (interval)
+    {
+      if (--countdown)
+        return false;
+      countdown = interval;
+      return true;
+    }
+    if (!signaled)
+      return false;
+    signaled = 0;
+    return true;
+  }
+
+  // record a call stack (outermost function first)
+  void sample(const std::vector<std::string> &stack);
+
+  // the collected stacks
+  std::uint64_t samples() const;
+  const std::map<std::string, std::uint64_t> &stacks() const;
+
+  // one "f;g;h count" line per distinct stack
+  void write_folded(std::ostream &out) const;
+
+private:
+  int hz;
+  bool running = false;
+  std::uint64_t interval = 0;
+  std::uint64_t countdown = 0;
+  std::uint64_t sample_count = 0;
+  std::map<std::string, std::uint64_t> folded;
+
+  // set by the signal handler
+  static volatile std::sig_atomic_t signaled;
+  static void on_signal(int);
+
+  struct sigaction old_action;
+};
+
+#endif
@@ -0,0 +1,226 @@
+//----------------------------------------------------------------------
+// FILE: vm_string.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: VM string value implementation
+//----------------------------------------------------------------------
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <unordered_map>
+#include "vm_string.h"
+
+using namespace std;
+
+VMString::VMString() noexcept
+  : tag(0)
+{
+  chars[0] = '\0';
+}
+
+VMString::VMString(const char *s)
+{
+  assign(string_view(s));
+}
+
+VMString::VMString(const string &s)
+{
+  assign(string_view(s));
+}
+
+VMString::VMString(string_view s)
+{
+  assign(s);
+}
+
+VMString::VMString(const VMString &other) noexcept
+{
+  copy_from(other);
+  if (tag == SHARED)
+    ++shared.buffer->refs;
+}
+
+VMString::VMString(VMString &&other) noexcept
+{
+  copy_from(other);
+  other.tag = 0;
+  other.chars[0] = '\0';
+}
+
+VMString &VMString::operator=(const VMString &other) noexcept
+{
+  if (this != &other)
+  {
+    if (other.tag == SHARED)
+      ++other.shared.buffer->refs;
+    release();
+    copy_from(other);
+  }
+  return *this;
+}
+
+VMString &VMString::operator=(VMString &&other) noexcept
+{
+  if (this != &other)
+  {
+    release();
+    copy_from(other);
+    other.tag = 0;
+    other.chars[0] = '\0';
+  }
+  return *this;
+}
+
+VMString::~VMString()
+{
+  release();
+}
+
+void VMString::copy_from(const VMString &other) noexcept
+{
+  // the inline characters overlay the buffer pointer and length
+  memcpy(chars, other.chars, sizeof(chars));
+  tag = other.tag;
+}
+
+void VMString::assign(string_view s)
+{
+  memcpy(allocate(s.size(), s.size()), s.data(), s.size());
+}
+
+char *VMString::allocate(size_t size, size_t capacity)
+{
+  if (size <= INLINE_CAPACITY)
+  {
+    chars[size] = '\0';
+    tag = size;
+    return chars;
+  }
+  void *memory = malloc(sizeof(Buffer) + capacity);
+  if (!memory)
+    throw bad_alloc();
+  shared.buffer = new (memory) Buffer{1, size, capacity};
+  shared.length = size;
+  shared.offset = 0;
+  tag = SHARED;
+  return shared.buffer->chars();
+}
+
+VMString VMString::concat(const VMString &x, string_view y)
+{
+  size_t size = x.size() + y.size();
+  if (x.tag == SHARED)
+  {
+    Buffer *buffer = x.shared.buffer;
+    // x is the longest string in its buffer, so the space after it is
+    // free for the result
+    if (x.shared.offset + x.shared.length == buffer->size and
+        buffer->capacity - buffer->size >= y.size())
+    {
+      memcpy(buffer->chars() + buffer->size, y.data(), y.size());
+      buffer->size += y.size();
+      VMString s = x;
+      s.shared.length = size;
+      return s;
+    }
+  }
+  // leave room to grow, since the result is likely to be appended to
+  VMString s;
+  char *chars = s.allocate(size, size + size / 2);
+  memcpy(chars, x.data(), x.size());
+  memcpy(chars + x.size(), y.data(), y.size());
+  return s;
+}
+
+void VMString::release() noexcept
+{
+  if (tag == SHARED and --shared.buffer->refs == 0)
+    free(shared.buffer);
+  tag = 0;
+}
+
+VMString VMString::intern(string_view s)
+{
+  if (s.size() <= INLINE_CAPACITY)
+    return VMString(s);
+  // never freed, so interned strings outlive any static vm
+  static auto *table = new unordered_map<string, VMString>();
+  auto it = table->find(string(s));
+  if (it == table->end())
+    it = table->emplace(string(s), VMString(s)).first;
+  return it->second;
+}
+
+VMString VMString::substr(size_t pos, size_t n) const
+{
+  if (tag != SHARED or n <= INLINE_CAPACITY or shared.offset + pos > UINT32_MAX)
+    return VMString(view().substr(pos, n));
+  VMString s = *this;
+  s.shared.offset += pos;
+  s.shared.length = n;
+  return s;
+}
+
+size_t VMString::size() const
+{
+  return tag == SHARED ? shared.length : tag;
+}
+
+bool VMString::empty() const
+{
+  return size() == 0;
+}
+
+const char *VMString::data() const
+{
+  return tag == SHARED ? shared.buffer->chars() + shared.offset : chars;
+}
+
+char VMString::operator[](size_t i) const
+{
+  return data()[i];
+}
+
+string_view VMString::view() const
+{
+  return string_view(data(), size());
+}
+
+VMString::operator string_view() const
+{
+  return view();
+}
+
+string VMString::str() const
+{
+  return string(data(), size());
+}
+
+bool VMString::is_inline() const
+{
+  return tag != SHARED;
+}
+
+size_t VMString::use_count() const
+{
+  return tag == SHARED ? shared.buffer->refs : 1;
+}
+
+bool operator==(const VMString &x, const VMString &y)
+{
+  if (x.tag == VMString::SHARED and y.tag == VMString::SHARED and
+      x.shared.buffer == y.shared.buffer and x.shared.offset == y.shared.offset)
+    return x.shared.length == y.shared.length;
+  return x.view() == y.view();
+}
+
+strong_ordering operator<=>(const VMString &x, const VMString &y)
+{
+  return x.view() <=> y.view();
+}
+
+ostream &operator<<(ostream &out, const VMString &s)
+{
+  return out << s.view();
+}
@@ -0,0 +1,113 @@
+//----------------------------------------------------------------------
+// FILE: vm_string.h
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Immutable string values of the VM. Strings of up to 22
+// characters are stored in the handle itself, and longer ones in a
+// shared reference-counted buffer, so copying a string (on LOAD, DUP,
+// GETF, CALL, ...) never copies its characters. The counts are not
+// atomic: a vm and its values belong to one thread.
+//
+// A handle views a slice of its buffer (so substrings share it too),
+// and buffers have spare capacity, so concat(s, t) where s ends at the end of its buffer
+// writes t in place and returns a longer view of the same buffer
+// (the characters s sees never change). Accumulating a string with
+// s = concat(s, piece) is amortized linear.
+//----------------------------------------------------------------------
+
+#ifndef VM_STRING_H
+#define VM_STRING_H
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+class VMString
+{
+public:
+  // the empty string
+  VMString() noexcept;
+
+  VMString(const char *s);
+  VMString(const std::string &s);
+  VMString(std::string_view s);
+
+  VMString(const VMString &other) noexcept;
+  VMString(VMString &&other) noexcept;
+  VMString &operator=(const VMString &other) noexcept;
+  VMString &operator=(VMString &&other) noexcept;
+  ~VMString();
+
+  // a string sharing its buffer with every other interned copy of the
+  // same characters (for literal constants)
+  static VMString intern(std::string_view s);
+
+  // the characters of x followed by those of y
+  static VMString concat(const VMString &x, std::string_view y);
+
+  // the n characters starting at pos (which must be in bounds),
+  // sharing this string's buffer
+  VMString substr(std::size_t pos, std::size_t n) const;
+
+  std::size_t size() const;
+  bool empty() const;
+  // the characters (not null terminated)
+  const char *data() const;
+  char operator[](std::size_t i) const;
+
+  std::string_view view() const;
+  operator std::string_view() const;
+  std::string str() const;
+
+  // true if the characters are stored in the handle
+  bool is_inline() const;
+
+  // number of handles sharing the characters (1 if inline)
+  std::size_t use_count() const;
+
+  friend bool operator==(const VMString &x, const VMString &y);
+  friend std::strong_ordering operator<=>(const VMString &x, const VMString &y);
+
+private:
+  static const std::size_t INLINE_CAPACITY = 22;
+  static const unsigned char SHARED = 0xFF;
+
+  // header of a shared buffer (the characters follow it), where size
+  // is the length of the longest string using it
+  struct Buffer
+  {
+    std::size_t refs;
+    std::size_t size;
+    std::size_t capacity;
+    char *chars() { return reinterpret_cast<char *>(this + 1); }
+  };
+
+  union
+  {
+    char chars[INLINE_CAPACITY + 1];
+    struct
+    {
+      Buffer *buffer;
+      std::size_t length;
+      std::uint32_t offset;
+    } shared;
+  };
+
+  // the inline size, or SHARED
+  unsigned char tag;
+
+  void assign(std::string_view s);
+
+  // set up (uninitialized) space for size characters in a buffer
+  // holding at least capacity characters
+  char *allocate(std::size_t size, std::size_t capacity);
+  void copy_from(const VMString &other) noexcept;
+  void release() noexcept;
+};
+
+std::ostream &operator<<(std::ostream &out, const VMString &s);
+
+#endif
@@ -666,6 +666,25 @@ TEST(BasicASTParserTests, NewArrayExpression)
   ASSERT_EQ(nullptr, e.rest);
 }
 
+TEST(BasicASTParserTests, MapDeclAndNewExpression)
+{
+  stringstream in(build_string({"map string Node f(map int bool m) {",
+                                "  map string Node x = new map string Node",
+                                "}"}));
+  Program p = ASTParser(Lexer(in)).parse();
+  ASSERT_EQ("map string Node", p.fun_defs[0].return_type.type_name);
+  ASSERT_EQ("map int bool", p.fun_defs[0].params[0].data_type.type_name);
+  ASSERT_FALSE(p.fun_defs[0].params[0].data_type.is_array);
+  VarDeclStmt &s = (VarDeclStmt &)*p.fun_defs[0].stmts[0];
+  ASSERT_EQ("map string Node", s.var_def.data_type.type_name);
+  ASSERT_EQ("string", s.var_def.data_type.key_type());
+  ASSERT_EQ("Node", s.var_def.data_type.value_type());
+  NewRValue &v = (NewRValue &)*((SimpleTerm &)*s.expr.first).rvalue;
+  ASSERT_EQ(TokenType::MAP, v.type.type());
+  ASSERT_EQ("map string Node", v.type.lexeme());
+  ASSERT_FALSE(v.array_expr.has_value());
+}
+
 TEST(BasicASTParserTests, SimpleVarValue)
 {
   stringstream in(build_string({"void main() {",
@@ -0,0 +1,280 @@
+//----------------------------------------------------------------------
+// FILE: build_cache_tests.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Incremental build cache tests
+//----------------------------------------------------------------------
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "mypl_exception.h"
+#include "lexer.h"
+#include "ast_parser.h"
+#include "vm.h"
+#include "build_cache.h"
+
+using namespace std;
+
+
+streambuf* stream_buffer;
+
+
+void change_cout(stringstream& out)
+{
+  stream_buffer = cout.rdbuf();
+  cout.rdbuf(out.rdbuf());
+}
+
+void restore_cout()
+{
+  cout.rdbuf(stream_buffer);
+}
+
+string build_string(initializer_list<string> strs)
+{
+  string result = "";
+  for (string s : strs)
+    result += s + "\n";
+  return result;
+}
+
+// fresh cache file location for each test
+string cache_path(const string &name)
+{
+  string path = (filesystem::temp_directory_path() / (name + ".cache")).string();
+  remove(path.c_str());
+  return path;
+}
+
+// build the program through the cache and return what it prints
+string build_and_run(BuildCache &cache, const string &src)
+{
+  stringstream in(src);
+  Program p = ASTParser(Lexer(in)).parse();
+  VM vm;
+  cache.build(p, vm);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  return out.str();
+}
+
+string program(const string &f_body, const string &g_body)
+{
+  return build_string({
+      "int f(int x) {",
+      f_body,
+      "}",
+      "int g(int x) {",
+      g_body,
+      "}",
+      "void main() {",
+      "  print(f(1))",
+      "  print(g(1))",
+      "}"
+    });
+}
+
+//----------------------------------------------------------------------
+// Reuse of unchanged functions
+//----------------------------------------------------------------------
+
+TEST(BuildCacheTest, FirstBuildRebuildsEverything) {
+  BuildCache cache(cache_path("first_build"));
+  EXPECT_EQ("23", build_and_run(cache, program("  return x + 1", "  return x + 2")));
+  EXPECT_EQ(3, cache.rebuilt().size());
+  EXPECT_EQ(0, cache.reused().size());
+}
+
+TEST(BuildCacheTest, UnchangedProgramReusesEverything) {
+  string path = cache_path("unchanged");
+  BuildCache first(path);
+  build_and_run(first, program("  return x + 1", "  return x + 2"));
+  BuildCache second(path);
+  EXPECT_EQ("23", build_and_run(second, program("  return x + 1", "  return x + 2")));
+  EXPECT_EQ(0, second.rebuilt().size());
+  EXPECT_EQ(3, second.reused().size());
+}
+
+TEST(BuildCacheTest, WhitespaceAndCommentsDoNotInvalidate) {
+  string path = cache_path("whitespace");
+  BuildCache first(path);
+  build_and_run(first, program("  return x + 1", "  return x + 2"));
+  BuildCache second(path);
+  build_and_run(second, program("  # one more\n  return   x+1", "  return x + 2"));
+  EXPECT_EQ(0, second.rebuilt().size());
+}
+
+TEST(BuildCacheTest, OnlyChangedFunctionIsRebuilt) {
+  string path = cache_path("changed");
+  BuildCache first(path);
+  build_and_run(first, program("  return x + 1", "  return x + 2"));
+  BuildCache second(path);
+  EXPECT_EQ("25", build_and_run(second, program("  return x + 1", "  return x + 4")));
+  ASSERT_EQ(1, second.rebuilt().size());
+  EXPECT_EQ("g", second.rebuilt()[0]);
+}
+
+TEST(BuildCacheTest, SignatureChangeRebuildsCallers) {
+  string path = cache_path("signature");
+  string src1 = build_string({
+      "int f(int x) {return x}",
+      "int g(int x) {return x}",
+      "void main() {print(f(1))}"
+    });
+  string src2 = build_string({
+      "double f(double x) {return x}",
+      "int g(int x) {return x}",
+      "void main() {print(f(1.5))}"
+    });
+  BuildCache first(path);
+  build_and_run(first, src1);
+  BuildCache second(path);
+  EXPECT_EQ("1.500000", build_and_run(second, src2));
+  EXPECT_EQ(2, second.rebuilt().size());
+  EXPECT_EQ(1, second.reused().size());
+  EXPECT_EQ("g", second.reused()[0]);
+}
+
+TEST(BuildCacheTest, StructChangeRebuildsUsers) {
+  string path = cache_path("struct_change");
+  string src1 = build_string({
+      "struct T {int x}",
+      "void show(T t) {print(t.x)}",
+      "int id(int x) {return x}",
+      "void main() {T t = new T t.x = id(3) show(t)}"
+    });
+  string src2 = build_string({
+      "struct T {int x, int y}",
+      "void show(T t) {print(t.x)}",
+      "int id(int x) {return x}",
+      "void main() {T t = new T t.x = id(3) show(t)}"
+    });
+  BuildCache first(path);
+  build_and_run(first, src1);
+  BuildCache second(path);
+  EXPECT_EQ("3", build_and_run(second, src2));
+  ASSERT_EQ(1, second.reused().size());
+  EXPECT_EQ("id", second.reused()[0]);
+}
+
+TEST(BuildCacheTest, BodyChangeKeepsCallersCached) {
+  string path = cache_path("body_change");
+  BuildCache first(path);
+  build_and_run(first, program("  return x + 1", "  return x + 2"));
+  uint64_t main_fp = first.fingerprint("main");
+  BuildCache second(path);
+  build_and_run(second, program("  return x * 10", "  return x + 2"));
+  EXPECT_EQ(main_fp, second.fingerprint("main"));
+  ASSERT_EQ(1, second.rebuilt().size());
+  EXPECT_EQ("f", second.rebuilt()[0]);
+}
+
+TEST(BuildCacheTest, InlinedBodyChangeRebuildsCallers) {
+  string path = cache_path("inlined_body");
+  BuildCache first(path);
+  first.enable_inlining();
+  EXPECT_EQ("23", build_and_run(first, program("  return x + 1", "  return x + 2")));
+  BuildCache second(path);
+  second.enable_inlining();
+  EXPECT_EQ("1003", build_and_run(second, program("  return x * 100", "  return x + 2")));
+  ASSERT_EQ(2, second.rebuilt().size());
+  EXPECT_EQ("f", second.rebuilt()[0]);
+  EXPECT_EQ("main", second.rebuilt()[1]);
+}
+
+TEST(BuildCacheTest, InliningSettingIsPartOfFingerprint) {
+  string path = cache_path("inline_setting");
+  BuildCache first(path);
+  build_and_run(first, program("  return x + 1", "  return x + 2"));
+  BuildCache second(path);
+  second.enable_inlining();
+  build_and_run(second, program("  return x + 1", "  return x + 2"));
+  EXPECT_EQ(3, second.rebuilt().size());
+}
+
+//----------------------------------------------------------------------
+// Errors and bad caches
+//----------------------------------------------------------------------
+
+TEST(BuildCacheTest, ChangedFunctionIsStillChecked) {
+  string path = cache_path("checked");
+  BuildCache first(path);
+  build_and_run(first, program("  return x + 1", "  return x + 2"));
+  BuildCache second(path);
+  stringstream in(program("  return \"oops\"", "  return x + 2"));
+  Program p = ASTParser(Lexer(in)).parse();
+  VM vm;
+  try {
+    second.build(p, vm);
+    FAIL();
+  } catch (MyPLException& ex) {
+    string msg = ex.what();
+    ASSERT_TRUE(msg.starts_with("Static Error:"));
+  }
+}
+
+TEST(BuildCacheTest, CorruptCacheIsIgnored) {
+  string path = cache_path("corrupt");
+  BuildCache first(path);
+  build_and_run(first, program("  return x + 1", "  return x + 2"));
+  {
+    ofstream out(path, ios::app);
+    out << "3:bad 12 0 0 5\n1 +";
+  }
+  BuildCache second(path);
+  EXPECT_EQ("23", build_and_run(second, program("  return x + 1", "  return x + 2")));
+  EXPECT_EQ(3, second.rebuilt().size());
+}
+
+TEST(BuildCacheTest, CachedStringConstantsRoundTrip) {
+  string path = cache_path("strings");
+  string src = build_string({
+      "void main() {",
+      "  print(\"a b\\nc\")",
+      "  print(2.5)",
+      "  print(true)",
+      "  print(' ')",
+      "  print('x')",
+      "}"
+    });
+  BuildCache first(path);
+  string expected = build_and_run(first, src);
+  BuildCache second(path);
+  EXPECT_EQ(expected, build_and_run(second, src));
+  EXPECT_EQ(1, second.reused().size());
+}
+
+TEST(BuildCacheTest, CachedArrayLiteralsRoundTrip) {
+  string path = cache_path("array_literals");
+  string src = build_string({
+      "void main() {",
+      "  array int xs = new int {3, 1, 4}",
+      "  array string ys = new string {\"a b\", \"c\"}",
+      "  print(xs[0] + xs[2])",
+      "  print(ys[0])",
+      "  print(ys[1])",
+      "}"
+    });
+  BuildCache first(path);
+  EXPECT_EQ("7a bc", build_and_run(first, src));
+  BuildCache second(path);
+  EXPECT_EQ("7a bc", build_and_run(second, src));
+  EXPECT_EQ(1, second.reused().size());
+}
+
+//----------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -7,6 +7,8 @@
 
 
 
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -272,6 +274,63 @@ TEST(BasicCodeGenTest, SimpleOr) {
   restore_cout();
 }        
 
+TEST(BasicCodeGenTest, ShortCircuitSkipsRest) {
+  stringstream in(build_string({
+        "bool noisy(bool x) {",
+        "  print(x)",
+        "  return x",
+        "}",
+        "void main() {",
+        "  bool x1 = noisy(false) and noisy(true)",
+        "  bool x2 = noisy(true) or noisy(false)",
+        "  bool x3 = noisy(true) and noisy(false)",
+        "  bool x4 = not (noisy(false) or noisy(true))",
+        "  print(' ')",
+        "  print(x1)",
+        "  print(' ')",
+        "  print(x2)",
+        "  print(' ')",
+        "  print(x3)",
+        "  print(' ')",
+        "  print(x4)",
+        "}"
+      }));
+  VM vm;
+  CodeGenerator generator(vm);
+  ASTParser(Lexer(in)).parse().accept(generator);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  EXPECT_EQ("falsetruetruefalsefalsetrue false true false false", out.str());
+  restore_cout();
+}        
+
+TEST(BasicCodeGenTest, ShortCircuitNullGuard) {
+  stringstream in(build_string({
+        "struct Node {int val, Node next}",
+        "void main() {",
+        "  Node n = new Node",
+        "  n.val = 5",
+        "  int count = 0",
+        "  while ((n != null) and (n.val > 0)) {",
+        "    count = count + 1",
+        "    n = n.next",
+        "  }",
+        "  if ((n == null) or (n.val > 0)) {",
+        "    print(count)",
+        "  }",
+        "}"
+      }));
+  VM vm;
+  CodeGenerator generator(vm);
+  ASTParser(Lexer(in)).parse().accept(generator);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  EXPECT_EQ("1", out.str());
+  restore_cout();
+}        
+
 TEST(BasicCodeGenTest, SimpleNot) {
   stringstream in(build_string({
         "void main() {",
@@ -869,6 +928,91 @@ TEST(BasicCodeGenTest, BasicRecursion) {
   restore_cout();
 }
 
+TEST(BasicCodeGenTest, TailRecursiveReturn) {
+  stringstream in(build_string({
+        "int count_down(int x, int steps) {",
+        "  if (x <= 0) {",
+        "    return steps",
+        "  }",
+        "  return count_down(x - 1, steps + 1)",
+        "}",
+        "void main() {",
+        "  print(count_down(10000, 0))",
+        "}"
+      }));
+  VM vm;
+  CodeGenerator generator(vm);
+  ASTParser(Lexer(in)).parse().accept(generator);
+  EXPECT_NE(string::npos, to_string(vm).find("TAILCALL(count_down)"));
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  EXPECT_EQ("10000", out.str());
+  restore_cout();
+}
+
+TEST(BasicCodeGenTest, TailRecursiveVoidCall) {
+  stringstream in(build_string({
+        "struct Node {int val, Node next}",
+        "void print_list(Node n) {",
+        "  if (n != null) {",
+        "    print(n.val)",
+        "    print_list(n.next)",
+        "  }",
+        "}",
+        "void main() {",
+        "  Node head = null",
+        "  for (int i = 0; i < 3; i = i + 1) {",
+        "    Node n = new Node",
+        "    n.val = i",
+        "    n.next = head",
+        "    head = n",
+        "  }",
+        "  print_list(head)",
+        "}"
+      }));
+  VM vm;
+  CodeGenerator generator(vm);
+  ASTParser(Lexer(in)).parse().accept(generator);
+  EXPECT_NE(string::npos, to_string(vm).find("TAILCALL(print_list)"));
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  EXPECT_EQ("210", out.str());
+  restore_cout();
+}
+
+TEST(BasicCodeGenTest, NonTailCallsAreNotTailCalls) {
+  stringstream in(build_string({
+        "int f(int x) {",
+        "  if (x <= 0) {",
+        "    return 0",
+        "  }",
+        "  int y = f(x - 1)",
+        "  return y + 1",
+        "}",
+        "void g(int x) {",
+        "  if (x > 0) {",
+        "    g(x - 1)",
+        "    print(x)",
+        "  }",
+        "}",
+        "void main() {",
+        "  print(f(3))",
+        "  g(3)",
+        "}"
+      }));
+  VM vm;
+  CodeGenerator generator(vm);
+  ASTParser(Lexer(in)).parse().accept(generator);
+  EXPECT_EQ(string::npos, to_string(vm).find("TAILCALL"));
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  EXPECT_EQ("3123", out.str());
+  restore_cout();
+}
+
 //----------------------------------------------------------------------
 // Structs
 //----------------------------------------------------------------------
@@ -1094,6 +1238,68 @@ TEST(BasicCodeGenTest, ArrayInit) {
   restore_cout();
 }
 
+TEST(BasicCodeGenTest, ArrayLiterals) {
+  stringstream in(build_string({
+        "void main() {",
+        "  array int xs = new int {3, 1, 4}",
+        "  array double ys = new double {0.5, 2.25}",
+        "  array string zs = new string {\"a\\tb\", \"c\"}",
+        "  array char cs = new char {'x', 'y'}",
+        "  xs[1] = xs[0] + xs[2]",
+        "  print(xs[1])",
+        "  print(ys[0] + ys[1])",
+        "  print(zs[0])",
+        "  print(cs[1])",
+        "}"
+      }));
+  VM vm;
+  CodeGenerator generator(vm);
+  ASTParser(Lexer(in)).parse().accept(generator);
+  // each literal is created by one instruction from the constant pool
+  const VMFrameInfo &main = vm.frame("main");
+  EXPECT_EQ(4, main.array_constants.size());
+  EXPECT_EQ("int", main.array_constants[0].element_type);
+  for (const VMInstr &instr : main.instructions)
+    EXPECT_NE(OpCode::DUP, instr.opcode());
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  EXPECT_EQ("72.750000a\tby", out.str());
+  restore_cout();
+}
+
+TEST(BasicCodeGenTest, LocalCountCoversScopes) {
+  stringstream in(build_string({
+        "int f(int x, int y) {",
+        "  int z = x + y",
+        "  if (z > 0) {",
+        "    int a = 1",
+        "    int b = 2",
+        "    z = a + b",
+        "  }",
+        "  else {",
+        "    int c = 3",
+        "    z = c",
+        "  }",
+        "  return z",
+        "}",
+        "void main() {",
+        "  print(f(1, 2))",
+        "}"
+      }));
+  VM vm;
+  CodeGenerator generator(vm);
+  ASTParser(Lexer(in)).parse().accept(generator);
+  // the branches' variables share slots
+  EXPECT_EQ(5, vm.frame("f").local_count);
+  EXPECT_EQ(0, vm.frame("main").local_count);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  EXPECT_EQ("3", out.str());
+  restore_cout();
+}
+
 TEST(BasicCodeGenTest, ArrayOfStruct) {
   stringstream in(build_string({
         "struct T {bool x, int y}",
@@ -1293,6 +1499,190 @@ TEST(BasicCodeGenTest, StringConcat) {
 }   
 
 
+TEST(BasicCodeGenTest, ReadFileAndLines) {
+  string path = testing::TempDir() + "mypl_read_lines.txt";
+  ofstream file(path);
+  file << "first line\nsecond\n\nlast";
+  file.close();
+  stringstream in(build_string({
+        "void main() {",
+        "  string path = \"" + path + "\"",
+        "  print(length(read_file(path)))",
+        "  array string lines = read_lines(path)",
+        "  print(length_array(lines))",
+        "  for (int i = 0; i < length_array(lines); i = i + 1) {",
+        "    print(concat(concat(\"[\", lines[i]), \"]\"))",
+        "  }",
+        "}"
+      }));
+  VM vm;
+  CodeGenerator generator(vm);
+  ASTParser(Lexer(in)).parse().accept(generator);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  EXPECT_EQ("234[first line][second][][last]", out.str());
+  remove(path.c_str());
+}
+
+TEST(BasicCodeGenTest, ReadAll) {
+  stringstream in(build_string({
+        "void main() {",
+        "  string first = input()",
+        "  string rest = read_all()",
+        "  print(concat(first, \"|\"))",
+        "  print(rest)",
+        "}"
+      }));
+  VM vm;
+  CodeGenerator generator(vm);
+  ASTParser(Lexer(in)).parse().accept(generator);
+  stringstream input("one\ntwo\nthree\n");
+  streambuf *cin_buffer = cin.rdbuf(input.rdbuf());
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  cin.rdbuf(cin_buffer);
+  EXPECT_EQ("one|two\nthree\n", out.str());
+}
+
+TEST(BasicCodeGenTest, MappedFileArrays) {
+  string ints_path = testing::TempDir() + "mypl_mapped_ints.bin";
+  string doubles_path = testing::TempDir() + "mypl_mapped_doubles.bin";
+  int32_t ints[] = {7, -2, 40, 100000};
+  double doubles[] = {0.5, 2.25};
+  ofstream ints_file(ints_path, ios::binary);
+  ints_file.write(reinterpret_cast<const char *>(ints), sizeof(ints));
+  ints_file.close();
+  ofstream doubles_file(doubles_path, ios::binary);
+  doubles_file.write(reinterpret_cast<const char *>(doubles), sizeof(doubles));
+  doubles_file.close();
+  stringstream in(build_string({
+        "void main() {",
+        "  array int xs = mmap_ints(\"" + ints_path + "\")",
+        "  int total = 0",
+        "  for (int i = 0; i < length_array(xs); i = i + 1) {",
+        "    total = total + xs[i]",
+        "  }",
+        "  print(concat(to_string(length_array(xs)), \" \"))",
+        "  print(concat(to_string(total), \" \"))",
+        "  array double ys = mmap_doubles(\"" + doubles_path + "\")",
+        "  print(ys[0] + ys[1])",
+        "}"
+      }));
+  VM vm;
+  CodeGenerator generator(vm);
+  ASTParser(Lexer(in)).parse().accept(generator);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  EXPECT_EQ("4 100045 2.750000", out.str());
+  remove(ints_path.c_str());
+  remove(doubles_path.c_str());
+}
+
+TEST(BasicCodeGenTest, StringBuiltins) {
+  stringstream in(build_string({
+        "void main() {",
+        "  string log = \"GET /a 200\\nPOST /b 404\\nGET /c 200\"",
+        "  array string lines = split(log, '\\n')",
+        "  for (int i = 0; i < length_array(lines); i = i + 1) {",
+        "    string line = lines[i]",
+        "    if (starts_with(line, \"GET\")) {",
+        "      int space = index_of(line, ' ')",
+        "      array string fields = split(line, \" \")",
+        "      print(concat(substr(line, space + 1, 2), fields[2]))",
+        "    }",
+        "  }",
+        "  print(index_of(log, \"PUT\"))",
+        "  print(length_array(split(\"\", \",\")))",
+        "}"
+      }));
+  VM vm;
+  CodeGenerator generator(vm);
+  ASTParser(Lexer(in)).parse().accept(generator);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  EXPECT_EQ("/a200/c200-11", out.str());
+}
+
+TEST(BasicCodeGenTest, DynamicArrays) {
+  stringstream in(build_string({
+        "void main() {",
+        "  array int xs = new int[0]",
+        "  for (int i = 0; i < 5; i = i + 1) {",
+        "    append(xs, i * i)",
+        "  }",
+        "  print(pop(xs))",
+        "  print(length_array(xs))",
+        "  resize(xs, 6)",
+        "  print(xs[5])",
+        "  copy(xs, xs, 1, 3)",
+        "  for (int i = 0; i < 4; i = i + 1) {",
+        "    print(xs[i])",
+        "  }",
+        "  array string ss = new string[0]",
+        "  append(ss, \"a\")",
+        "  append(ss, \"b\")",
+        "  resize(ss, 1)",
+        "  print(length_array(ss))",
+        "  print(pop(ss))",
+        "}"
+      }));
+  VM vm;
+  CodeGenerator generator(vm);
+  ASTParser(Lexer(in)).parse().accept(generator);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  EXPECT_EQ("164null00141a", out.str());
+}
+
+TEST(BasicCodeGenTest, Maps) {
+  stringstream in(build_string({
+        "void main() {",
+        "  map int int squares = new map int int",
+        "  for (int i = 0; i < 1000; i = i + 1) {",
+        "    map_put(squares, i, i * i)",
+        "  }",
+        "  for (int i = 0; i < 1000; i = i + 2) {",
+        "    map_remove(squares, i)",
+        "  }",
+        "  int missing = 0",
+        "  for (int i = 0; i < 1000; i = i + 1) {",
+        "    if (map_has(squares, i) == (((i / 2) * 2) == i)) {",
+        "      missing = missing + 1",
+        "    }",
+        "  }",
+        "  print(missing)",
+        "  print(length_array(map_keys(squares)))",
+        "  print(map_get(squares, 31))",
+        "  print(map_get(squares, 30))",
+        "  map string string names = new map string string",
+        "  map_put(names, \"b\", \"x\")",
+        "  map_put(names, \"a\", \"y\")",
+        "  map_put(names, \"b\", \"z\")",
+        "  array string keys = map_keys(names)",
+        "  print(concat(keys[0], keys[1]))",
+        "  print(map_get(names, \"b\"))",
+        "}"
+      }));
+  VM vm;
+  CodeGenerator generator(vm);
+  ASTParser(Lexer(in)).parse().accept(generator);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  EXPECT_EQ("0500961nullbaz", out.str());
+}
+
 //----------------------------------------------------------------------
 // main
 //----------------------------------------------------------------------
@@ -0,0 +1,274 @@
+//----------------------------------------------------------------------
+// FILE: inliner_tests.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Function inlining tests
+//----------------------------------------------------------------------
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "mypl_exception.h"
+#include "lexer.h"
+#include "ast_parser.h"
+#include "semantic_checker.h"
+#include "vm.h"
+#include "code_generator.h"
+#include "inliner.h"
+
+using namespace std;
+
+
+streambuf* stream_buffer;
+
+
+void change_cout(stringstream& out)
+{
+  stream_buffer = cout.rdbuf();
+  cout.rdbuf(out.rdbuf());
+}
+
+void restore_cout()
+{
+  cout.rdbuf(stream_buffer);
+}
+
+string build_string(initializer_list<string> strs)
+{
+  string result = "";
+  for (string s : strs)
+    result += s + "\n";
+  return result;
+}
+
+// check and generate the program with inlining enabled
+void generate(const string &src, VM &vm, Inliner &inliner)
+{
+  stringstream in(src);
+  Program p = ASTParser(Lexer(in)).parse();
+  SemanticChecker checker;
+  p.accept(checker);
+  p.accept(inliner);
+  CodeGenerator generator(vm);
+  generator.enable_inlining(inliner.candidates());
+  p.accept(generator);
+}
+
+string run(VM &vm)
+{
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  return out.str();
+}
+
+//----------------------------------------------------------------------
+// Candidate selection
+//----------------------------------------------------------------------
+
+TEST(InlinerTest, SmallLeafFunctionIsCandidate) {
+  string src = build_string({
+      "int add_one(int z) {",
+      "  z = z + 1",
+      "  return z",
+      "}",
+      "void main() {",
+      "  print(add_one(9))",
+      "}"
+    });
+  VM vm;
+  Inliner inliner;
+  generate(src, vm, inliner);
+  EXPECT_TRUE(inliner.candidates().contains("add_one"));
+  EXPECT_FALSE(inliner.candidates().contains("main"));
+  string ir = to_string(vm);
+  EXPECT_EQ(string::npos, ir.find("CALL(add_one)"));
+  EXPECT_NE(string::npos, ir.find("// inlined add_one()"));
+  EXPECT_EQ("10", run(vm));
+}
+
+TEST(InlinerTest, RecursiveFunctionsAreNotCandidates) {
+  string src = build_string({
+      "int fac(int n) {",
+      "  if (n <= 1) {return 1}",
+      "  return n * fac(n - 1)",
+      "}",
+      "bool even(int n) {",
+      "  if (n == 0) {return true}",
+      "  return odd(n - 1)",
+      "}",
+      "bool odd(int n) {",
+      "  if (n == 0) {return false}",
+      "  return even(n - 1)",
+      "}",
+      "void main() {",
+      "  print(fac(5))",
+      "  print(even(4))",
+      "}"
+    });
+  VM vm;
+  Inliner inliner;
+  generate(src, vm, inliner);
+  EXPECT_TRUE(inliner.candidates().empty());
+  EXPECT_EQ("120true", run(vm));
+}
+
+TEST(InlinerTest, LargeFunctionsAreNotCandidates) {
+  string body = "";
+  for (int i = 0; i < 10; ++i)
+    body += "  x = x + " + to_string(i) + "\n";
+  string src = build_string({
+      "int big(int x) {",
+      body,
+      "  return x",
+      "}",
+      "void main() {",
+      "  print(big(0))",
+      "}"
+    });
+  VM vm;
+  Inliner inliner;
+  generate(src, vm, inliner);
+  EXPECT_FALSE(inliner.candidates().contains("big"));
+  EXPECT_EQ("45", run(vm));
+}
+
+TEST(InlinerTest, DiscardedCallResultsPreventInlining) {
+  string src = build_string({
+      "int one() {return 1}",
+      "int f() {",
+      "  one()",
+      "  return 2",
+      "}",
+      "void main() {",
+      "  print(f())",
+      "}"
+    });
+  VM vm;
+  Inliner inliner;
+  generate(src, vm, inliner);
+  EXPECT_TRUE(inliner.candidates().contains("one"));
+  EXPECT_FALSE(inliner.candidates().contains("f"));
+  EXPECT_EQ("2", run(vm));
+}
+
+//----------------------------------------------------------------------
+// Inlined code behavior
+//----------------------------------------------------------------------
+
+TEST(InlinerTest, ParametersDoNotClobberCallerVariables) {
+  string src = build_string({
+      "int add(int a, int b) {",
+      "  int c = a + b",
+      "  a = 100",
+      "  return c",
+      "}",
+      "void main() {",
+      "  int a = 1",
+      "  int b = 2",
+      "  int c = add(b, a)",
+      "  print(a)",
+      "  print(b)",
+      "  print(c)",
+      "  int d = add(add(a, b), c)",
+      "  print(d)",
+      "}"
+    });
+  VM vm;
+  Inliner inliner;
+  generate(src, vm, inliner);
+  EXPECT_EQ("1236", run(vm));
+}
+
+TEST(InlinerTest, EarlyReturnsJumpToEndOfBody) {
+  string src = build_string({
+      "int sign(int x) {",
+      "  if (x < 0) {return 0 - 1}",
+      "  elseif (x == 0) {return 0}",
+      "  return 1",
+      "}",
+      "void main() {",
+      "  print(sign(0 - 5))",
+      "  print(sign(0))",
+      "  print(sign(7))",
+      "}"
+    });
+  VM vm;
+  Inliner inliner;
+  generate(src, vm, inliner);
+  EXPECT_TRUE(inliner.candidates().contains("sign"));
+  EXPECT_EQ("-101", run(vm));
+}
+
+TEST(InlinerTest, VoidFunctionsReturnNull) {
+  string src = build_string({
+      "void greet(string name) {",
+      "  print(concat(\"hi \", name))",
+      "}",
+      "void main() {",
+      "  greet(\"bob\")",
+      "  print(\" \")",
+      "  greet(\"amy\")",
+      "}"
+    });
+  VM vm;
+  Inliner inliner;
+  generate(src, vm, inliner);
+  EXPECT_TRUE(inliner.candidates().contains("greet"));
+  EXPECT_EQ("hi bob hi amy", run(vm));
+}
+
+TEST(InlinerTest, InlinedCallsInsideLoops) {
+  string src = build_string({
+      "struct P {int x}",
+      "int get_x(P p) {return p.x}",
+      "int sum_to(int n) {",
+      "  int s = 0",
+      "  for (int i = 1; i <= n; i = i + 1) {s = s + i}",
+      "  return s",
+      "}",
+      "void main() {",
+      "  P p = new P",
+      "  p.x = 3",
+      "  int total = 0",
+      "  for (int i = 0; i < 4; i = i + 1) {",
+      "    total = total + get_x(p) + sum_to(i)",
+      "  }",
+      "  print(total)",
+      "}"
+    });
+  VM vm;
+  Inliner inliner;
+  generate(src, vm, inliner);
+  EXPECT_TRUE(inliner.candidates().contains("get_x"));
+  EXPECT_TRUE(inliner.candidates().contains("sum_to"));
+  EXPECT_EQ("22", run(vm));
+}
+
+TEST(InlinerTest, NestedInlining) {
+  string src = build_string({
+      "int twice(int x) {return x * 2}",
+      "int quad(int x) {return twice(twice(x))}",
+      "void main() {",
+      "  print(quad(3))",
+      "}"
+    });
+  VM vm;
+  Inliner inliner;
+  generate(src, vm, inliner);
+  string ir = to_string(vm);
+  EXPECT_EQ(string::npos, ir.find("CALL("));
+  EXPECT_EQ("12", run(vm));
+}
+
+//----------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
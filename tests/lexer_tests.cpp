@@ -374,6 +374,22 @@ TEST(BasicLexerTest, ComplexTypeReservedWords) {
   ASSERT_EQ(TokenType::EOS, t.type());
 }
 
+TEST(BasicLexerTest, MapReservedWord) {
+  stringstream in("map map_get");
+  Lexer lexer(in);
+  Token t = lexer.next_token();
+  ASSERT_EQ(TokenType::MAP, t.type());
+  ASSERT_EQ("map", t.lexeme());
+  ASSERT_EQ(1, t.line());
+  ASSERT_EQ(1, t.column());
+  t = lexer.next_token();
+  ASSERT_EQ(TokenType::ID, t.type());
+  ASSERT_EQ("map_get", t.lexeme());
+  ASSERT_EQ(5, t.column());
+  t = lexer.next_token();
+  ASSERT_EQ(TokenType::EOS, t.type());
+}
+
 TEST(BasicLexerTest, AdditionalReservedWords) {
   stringstream in("new");
   Lexer lexer(in);
@@ -0,0 +1,269 @@
+//----------------------------------------------------------------------
+// FILE: loop_optimizer_tests.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Loop-invariant code motion tests
+//----------------------------------------------------------------------
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "mypl_exception.h"
+#include "lexer.h"
+#include "ast_parser.h"
+#include "semantic_checker.h"
+#include "vm.h"
+#include "code_generator.h"
+#include "loop_optimizer.h"
+
+using namespace std;
+
+
+streambuf* stream_buffer;
+
+
+void change_cout(stringstream& out)
+{
+  stream_buffer = cout.rdbuf();
+  cout.rdbuf(out.rdbuf());
+}
+
+void restore_cout()
+{
+  cout.rdbuf(stream_buffer);
+}
+
+string build_string(initializer_list<string> strs)
+{
+  string result = "";
+  for (string s : strs)
+    result += s + "\n";
+  return result;
+}
+
+// check and generate the program with loop hoisting enabled
+void generate(const string &src, VM &vm)
+{
+  stringstream in(src);
+  Program p = ASTParser(Lexer(in)).parse();
+  SemanticChecker checker;
+  p.accept(checker);
+  CodeGenerator generator(vm);
+  generator.enable_loop_hoisting();
+  p.accept(generator);
+}
+
+string run(VM &vm)
+{
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  return out.str();
+}
+
+//----------------------------------------------------------------------
+// Hoisting on instruction sequences
+//----------------------------------------------------------------------
+
+TEST(LoopOptimizerTest, HoistsArrayLengthFromCondition) {
+  // i = 0; while (i < length_array(xs)) {i = i + 1}
+  VMFrameInfo frame {"main", 1};
+  frame.instructions.push_back(VMInstr::PUSH(0));     // 0
+  frame.instructions.push_back(VMInstr::STORE(1));    // 1
+  frame.instructions.push_back(VMInstr::LOAD(1));     // 2: loop start
+  frame.instructions.push_back(VMInstr::LOAD(0));     // 3
+  frame.instructions.push_back(VMInstr::ALEN());      // 4
+  frame.instructions.push_back(VMInstr::CMPLT());     // 5
+  frame.instructions.push_back(VMInstr::JMPF(12));    // 6
+  frame.instructions.push_back(VMInstr::LOAD(1));     // 7
+  frame.instructions.push_back(VMInstr::PUSH(1));     // 8
+  frame.instructions.push_back(VMInstr::ADD());       // 9
+  frame.instructions.push_back(VMInstr::STORE(1));    // 10
+  frame.instructions.push_back(VMInstr::JMP(2));      // 11
+  frame.instructions.push_back(VMInstr::NOP());       // 12
+  LoopOptimizer optimizer;
+  optimizer.optimize(frame);
+  EXPECT_EQ(1, optimizer.hoisted());
+  vector<VMInstr> &code = frame.instructions;
+  ASSERT_EQ(15, code.size());
+  EXPECT_EQ(OpCode::LOAD, code[2].opcode());
+  EXPECT_EQ(OpCode::ALEN, code[3].opcode());
+  EXPECT_EQ(OpCode::STORE, code[4].opcode());
+  EXPECT_EQ(2, get<int>(code[4].operand().value()));
+  // the loop now starts after the hoisted code
+  EXPECT_EQ(OpCode::LOAD, code[5].opcode());
+  EXPECT_EQ(1, get<int>(code[5].operand().value()));
+  EXPECT_EQ(OpCode::LOAD, code[6].opcode());
+  EXPECT_EQ(2, get<int>(code[6].operand().value()));
+  EXPECT_EQ(OpCode::CMPLT, code[7].opcode());
+  EXPECT_EQ(14, get<int>(code[8].operand().value()));
+  EXPECT_EQ(OpCode::JMP, code[13].opcode());
+  EXPECT_EQ(5, get<int>(code[13].operand().value()));
+  EXPECT_EQ(OpCode::NOP, code[14].opcode());
+}
+
+TEST(LoopOptimizerTest, AppendsKeepArrayLengthInLoop) {
+  // while (length_array(xs) < 3) {append(xs, 0)}
+  VMFrameInfo frame {"main", 1};
+  frame.instructions.push_back(VMInstr::LOAD(0));     // 0: loop start
+  frame.instructions.push_back(VMInstr::ALEN());      // 1
+  frame.instructions.push_back(VMInstr::PUSH(3));     // 2
+  frame.instructions.push_back(VMInstr::CMPLT());     // 3
+  frame.instructions.push_back(VMInstr::JMPF(9));     // 4
+  frame.instructions.push_back(VMInstr::LOAD(0));     // 5
+  frame.instructions.push_back(VMInstr::PUSH(0));     // 6
+  frame.instructions.push_back(VMInstr::APPEND());    // 7
+  frame.instructions.push_back(VMInstr::JMP(0));      // 8
+  frame.instructions.push_back(VMInstr::NOP());       // 9
+  LoopOptimizer optimizer;
+  optimizer.optimize(frame);
+  EXPECT_EQ(0, optimizer.hoisted());
+  EXPECT_EQ(10, frame.instructions.size());
+}
+
+TEST(LoopOptimizerTest, StoredVariablesAreNotHoisted) {
+  // while (length(s) < 3) {s = concat(s, "a")}
+  VMFrameInfo frame {"main", 1};
+  frame.instructions.push_back(VMInstr::LOAD(0));     // 0: loop start
+  frame.instructions.push_back(VMInstr::SLEN());      // 1
+  frame.instructions.push_back(VMInstr::PUSH(3));     // 2
+  frame.instructions.push_back(VMInstr::CMPLT());     // 3
+  frame.instructions.push_back(VMInstr::JMPF(10));    // 4
+  frame.instructions.push_back(VMInstr::LOAD(0));     // 5
+  frame.instructions.push_back(VMInstr::PUSH(string("a")));   // 6
+  frame.instructions.push_back(VMInstr::CONCAT());    // 7
+  frame.instructions.push_back(VMInstr::STORE(0));    // 8
+  frame.instructions.push_back(VMInstr::JMP(0));      // 9
+  frame.instructions.push_back(VMInstr::NOP());       // 10
+  LoopOptimizer optimizer;
+  optimizer.optimize(frame);
+  EXPECT_EQ(0, optimizer.hoisted());
+  EXPECT_EQ(11, frame.instructions.size());
+}
+
+TEST(LoopOptimizerTest, CallsKeepFieldReadsInLoop) {
+  // while (p.x < 3) {f(p)}
+  VMFrameInfo frame {"main", 1};
+  frame.instructions.push_back(VMInstr::LOAD(0));     // 0: loop start
+  frame.instructions.push_back(VMInstr::GETF("x"));   // 1
+  frame.instructions.push_back(VMInstr::PUSH(3));     // 2
+  frame.instructions.push_back(VMInstr::CMPLT());     // 3
+  frame.instructions.push_back(VMInstr::JMPF(9));     // 4
+  frame.instructions.push_back(VMInstr::LOAD(0));     // 5
+  frame.instructions.push_back(VMInstr::CALL("f"));   // 6
+  frame.instructions.push_back(VMInstr::POP());       // 7
+  frame.instructions.push_back(VMInstr::JMP(0));      // 8
+  frame.instructions.push_back(VMInstr::NOP());       // 9
+  LoopOptimizer optimizer;
+  optimizer.optimize(frame);
+  EXPECT_EQ(0, optimizer.hoisted());
+  EXPECT_EQ(10, frame.instructions.size());
+}
+
+//----------------------------------------------------------------------
+// Generated code
+//----------------------------------------------------------------------
+
+TEST(LoopOptimizerTest, ForLoopOverArrayLength) {
+  string src = build_string({
+      "void main() {",
+      "  array int xs = new int[5]",
+      "  for (int i = 0; i < length_array(xs); i = i + 1) {xs[i] = i * i}",
+      "  int sum = 0",
+      "  for (int i = 0; i < length_array(xs); i = i + 1) {sum = sum + xs[i]}",
+      "  print(sum)",
+      "}"
+    });
+  VM vm;
+  generate(src, vm);
+  EXPECT_NE(string::npos, to_string(vm).find("// hoisted loop invariant"));
+  EXPECT_EQ("30", run(vm));
+}
+
+TEST(LoopOptimizerTest, FieldChainsAreHoisted) {
+  string src = build_string({
+      "struct Node {int val, Node next}",
+      "struct List {Node head}",
+      "void main() {",
+      "  List l = new List",
+      "  l.head = new Node",
+      "  l.head.val = 4",
+      "  int i = 0",
+      "  while (i < l.head.val) {",
+      "    print(i)",
+      "    i = i + 1",
+      "  }",
+      "}"
+    });
+  VM vm;
+  generate(src, vm);
+  EXPECT_NE(string::npos, to_string(vm).find("// hoisted loop invariant"));
+  EXPECT_EQ("0123", run(vm));
+}
+
+TEST(LoopOptimizerTest, FieldsSetInLoopAreNotHoisted) {
+  string src = build_string({
+      "struct C {int n}",
+      "void main() {",
+      "  C c = new C",
+      "  c.n = 0",
+      "  while (c.n < 5) {c.n = c.n + 1}",
+      "  print(c.n)",
+      "}"
+    });
+  VM vm;
+  generate(src, vm);
+  EXPECT_EQ(string::npos, to_string(vm).find("// hoisted loop invariant"));
+  EXPECT_EQ("5", run(vm));
+}
+
+TEST(LoopOptimizerTest, NestedLoops) {
+  string src = build_string({
+      "void main() {",
+      "  array int xs = new int[3]",
+      "  string s = \"abcd\"",
+      "  int count = 0",
+      "  for (int i = 0; i < length_array(xs); i = i + 1) {",
+      "    for (int j = 0; j < length(s); j = j + 1) {",
+      "      count = count + 1",
+      "    }",
+      "  }",
+      "  print(count)",
+      "}"
+    });
+  VM vm;
+  generate(src, vm);
+  EXPECT_EQ("12", run(vm));
+}
+
+TEST(LoopOptimizerTest, EarlyReturnFromLoop) {
+  string src = build_string({
+      "int find(array int xs, int x) {",
+      "  for (int i = 0; i < length_array(xs); i = i + 1) {",
+      "    if (xs[i] == x) {return i}",
+      "  }",
+      "  return 0 - 1",
+      "}",
+      "void main() {",
+      "  array int xs = new int[4]",
+      "  for (int i = 0; i < 4; i = i + 1) {xs[i] = 10 * i}",
+      "  print(find(xs, 20))",
+      "  print(find(xs, 5))",
+      "}"
+    });
+  VM vm;
+  generate(src, vm);
+  EXPECT_EQ("2-1", run(vm));
+}
+
+//----------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,76 @@
+//----------------------------------------------------------------------
+// FILE: perf_counters_tests.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Hardware counter tests (the counts are only checked where the
+// system lets us open the counters)
+//----------------------------------------------------------------------
+
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "perf_counters.h"
+
+using namespace std;
+
+
+volatile int sink = 0;
+
+void busy_loop(int n)
+{
+  for (int i = 0; i < n; ++i)
+    sink = sink + i;
+}
+
+TEST(PerfCountersTest, NamesTheCounters) {
+  PerfCounters counters;
+  const auto &readings = counters.readings();
+  ASSERT_EQ(4, readings.size());
+  EXPECT_EQ("instructions", readings[0].name);
+  EXPECT_EQ("cycles", readings[1].name);
+  EXPECT_EQ("branch-misses", readings[2].name);
+  EXPECT_EQ("L1d-read-misses", readings[3].name);
+}
+
+TEST(PerfCountersTest, CountsAreUnavailableOrGrow) {
+  PerfCounters counters;
+  counters.start();
+  busy_loop(1000);
+  counters.stop();
+  uint64_t small = counters.readings()[0].value;
+  counters.start();
+  busy_loop(1000000);
+  counters.stop();
+  const PerfCounters::Reading &reading = counters.readings()[0];
+  if (!reading.available)
+  {
+    EXPECT_EQ(0, reading.value);
+    GTEST_SKIP() << "instruction counter unavailable";
+  }
+  EXPECT_GT(reading.value, 1000000);
+  EXPECT_GT(reading.value, small);
+}
+
+TEST(PerfCountersTest, ReportMarksUnavailableCounters) {
+  PerfCounters counters;
+  counters.start();
+  counters.stop();
+  stringstream out;
+  counters.report(out);
+  string report = out.str();
+  for (const auto &reading : counters.readings())
+  {
+    string expected = reading.name + " " + (reading.available ? to_string(reading.value) : "n/a") + "\n";
+    EXPECT_NE(string::npos, report.find(expected));
+  }
+}
+
+//----------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
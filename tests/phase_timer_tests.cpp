@@ -0,0 +1,163 @@
+//----------------------------------------------------------------------
+// FILE: phase_timer_tests.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: Phase timing, allocation hook, and AST node counting tests
+//----------------------------------------------------------------------
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "lexer.h"
+#include "ast_parser.h"
+#include "alloc_hook.h"
+#include "node_counter.h"
+#include "phase_timer.h"
+
+using namespace std;
+
+
+string build_string(initializer_list<string> strs)
+{
+  string result = "";
+  for (string s : strs)
+    result += s + "\n";
+  return result;
+}
+
+int count_nodes(const string &src)
+{
+  stringstream in(src);
+  Program p = ASTParser(Lexer(in)).parse();
+  NodeCounter counter;
+  p.accept(counter);
+  return counter.count();
+}
+
+//----------------------------------------------------------------------
+// AST node counts
+//----------------------------------------------------------------------
+
+TEST(NodeCounterTest, EmptyProgram) {
+  // the program and main
+  EXPECT_EQ(2, count_nodes("void main() {}"));
+}
+
+TEST(NodeCounterTest, ExpressionsAndStatements) {
+  string src = build_string({
+      "struct S {int x}",
+      "void main() {",
+      "  int y = 1 + 2",
+      "  print(y)",
+      "}"
+    });
+  // program, struct, main; var decl: expr 1 + 2 (expr, term, rvalue,
+  // rest expr, term, rvalue); call: arg (expr, term, var rvalue)
+  EXPECT_EQ(3 + 7 + 4, count_nodes(src));
+}
+
+TEST(NodeCounterTest, ControlFlowAndPaths) {
+  string src = build_string({
+      "void main() {",
+      "  array int xs = new int[2]",
+      "  for (int i = 0; i < 2; i = i + 1) {",
+      "    if (i == 0) {xs[i] = 1}",
+      "    else {xs[i] = 2}",
+      "  }",
+      "}"
+    });
+  // program, main (2)
+  // array decl: decl, expr, term, new, [expr, term, rvalue] (7)
+  // for (1): decl i = 0 (4), i < 2 (6), i = i + 1 (assign + 6 = 7)
+  // if (1): i == 0 (6), two assigns each with an index (4 + 3 each)
+  EXPECT_EQ(2 + 7 + 1 + 4 + 6 + 7 + 1 + 6 + 7 + 7, count_nodes(src));
+}
+
+//----------------------------------------------------------------------
+// Allocation hook
+//----------------------------------------------------------------------
+
+static int hook_calls = 0;
+
+void test_hook(size_t size)
+{
+  ++hook_calls;
+}
+
+TEST(AllocHookTest, HookSeesAllocations) {
+  hook_calls = 0;
+  AllocHook old = set_alloc_hook(test_hook);
+  auto p = make_unique<int>(3);
+  vector<int> xs(100);
+  set_alloc_hook(old);
+  EXPECT_EQ(2, hook_calls);
+  auto q = make_unique<int>(4);
+  EXPECT_EQ(2, hook_calls);
+}
+
+TEST(AllocHookTest, CountingHook) {
+  AllocHook old = set_alloc_hook(count_allocation);
+  AllocCounts before = alloc_counts();
+  auto p = make_unique<double[]>(10);
+  AllocCounts after = alloc_counts();
+  set_alloc_hook(old);
+  EXPECT_EQ(1, after.allocations - before.allocations);
+  EXPECT_EQ(10 * sizeof(double), after.bytes - before.bytes);
+}
+
+//----------------------------------------------------------------------
+// Phase timing
+//----------------------------------------------------------------------
+
+TEST(PhaseTimerTest, PhasesInOrder) {
+  PhaseTimer timer;
+  timer.begin("one");
+  timer.begin("two");
+  timer.end();
+  timer.end();
+  ASSERT_EQ(2, timer.phases().size());
+  EXPECT_EQ("one", timer.phases()[0].name);
+  EXPECT_EQ("two", timer.phases()[1].name);
+  EXPECT_GE(timer.phases()[0].ms, 0);
+}
+
+TEST(PhaseTimerTest, AllocationsPerPhase) {
+  AllocHook old = set_alloc_hook(count_allocation);
+  PhaseTimer timer;
+  timer.begin("none");
+  timer.begin("three");
+  auto a = make_unique<int>(1);
+  auto b = make_unique<int>(2);
+  auto c = make_unique<int>(3);
+  timer.end();
+  set_alloc_hook(old);
+  EXPECT_EQ(0, timer.phases()[0].allocations);
+  EXPECT_EQ(3, timer.phases()[1].allocations);
+  EXPECT_EQ(3 * sizeof(int), timer.phases()[1].bytes);
+}
+
+TEST(PhaseTimerTest, Report) {
+  PhaseTimer timer;
+  timer.begin("lex");
+  timer.begin("parse");
+  timer.end();
+  stringstream out;
+  timer.report(out);
+  string report = out.str();
+  EXPECT_EQ(0, report.find("phase"));
+  EXPECT_NE(string::npos, report.find("\nlex "));
+  EXPECT_NE(string::npos, report.find("\nparse "));
+  EXPECT_NE(string::npos, report.find("\ntotal "));
+}
+
+//----------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1438,6 +1438,238 @@ TEST(BasicSemanticCheckerTests, BadShadowingInElseStatment) {
   }
 }
 
+TEST(BasicSemanticCheckerTests, ReadBuiltinsExample) {
+  stringstream in(build_string({
+        "void main() {",
+        "  string all = read_all()",
+        "  string text = read_file(\"data.txt\")",
+        "  array string lines = read_lines(concat(\"data\", \".txt\"))",
+        "  int n = length_array(lines)",
+        "}"
+      }));
+  SemanticChecker checker;
+  ASTParser(Lexer(in)).parse().accept(checker);
+}
+
+TEST(BasicSemanticCheckerTests, ReadLinesReturnsArray) {
+  stringstream in(build_string({
+        "void main() {",
+        "  print(read_lines(\"data.txt\"))",
+        "}"
+      }));
+  SemanticChecker checker;
+  try {
+    ASTParser(Lexer(in)).parse().accept(checker);
+    FAIL();
+  } catch(MyPLException& ex) {
+    string msg = ex.what();
+    ASSERT_TRUE(msg.starts_with("Static Error:"));
+  }
+}
+
+TEST(BasicSemanticCheckerTests, ReadFileNeedsPath) {
+  stringstream in(build_string({
+        "void main() {",
+        "  string text = read_file(42)",
+        "}"
+      }));
+  SemanticChecker checker;
+  try {
+    ASTParser(Lexer(in)).parse().accept(checker);
+    FAIL();
+  } catch(MyPLException& ex) {
+    string msg = ex.what();
+    ASSERT_TRUE(msg.starts_with("Static Error:"));
+  }
+}
+
+TEST(BasicSemanticCheckerTests, MappedArraysExample) {
+  stringstream in(build_string({
+        "void main() {",
+        "  array int xs = mmap_ints(\"ints.bin\")",
+        "  array double ys = mmap_doubles(concat(\"doubles\", \".bin\"))",
+        "  double total = ys[0] + to_double(xs[length_array(xs) - 1])",
+        "}"
+      }));
+  SemanticChecker checker;
+  ASTParser(Lexer(in)).parse().accept(checker);
+}
+
+TEST(BasicSemanticCheckerTests, MappedArrayElementTypes) {
+  stringstream in(build_string({
+        "void main() {",
+        "  array double ys = mmap_doubles(\"doubles.bin\")",
+        "  int y = ys[0]",
+        "}"
+      }));
+  SemanticChecker checker;
+  try {
+    ASTParser(Lexer(in)).parse().accept(checker);
+    FAIL();
+  } catch(MyPLException& ex) {
+    string msg = ex.what();
+    ASSERT_TRUE(msg.starts_with("Static Error:"));
+  }
+}
+
+TEST(BasicSemanticCheckerTests, StringBuiltinsExample) {
+  stringstream in(build_string({
+        "void main() {",
+        "  string line = \"GET /index.html 200\"",
+        "  array string fields = split(line, ' ')",
+        "  int i = index_of(line, \"index\")",
+        "  string path = substr(line, i, index_of(fields[1], '.'))",
+        "  bool get = starts_with(line, \"GET\")",
+        "  bool slash = starts_with(path, '/')",
+        "}"
+      }));
+  SemanticChecker checker;
+  ASTParser(Lexer(in)).parse().accept(checker);
+}
+
+TEST(BasicSemanticCheckerTests, SubstrNeedsIntBounds) {
+  stringstream in(build_string({
+        "void main() {",
+        "  string s = substr(\"abc\", \"1\", 2)",
+        "}"
+      }));
+  SemanticChecker checker;
+  try {
+    ASTParser(Lexer(in)).parse().accept(checker);
+    FAIL();
+  } catch(MyPLException& ex) {
+    string msg = ex.what();
+    ASSERT_TRUE(msg.starts_with("Static Error:"));
+  }
+}
+
+TEST(BasicSemanticCheckerTests, DynamicArrayBuiltinsExample) {
+  stringstream in(build_string({
+        "void main() {",
+        "  array int xs = new int[0]",
+        "  append(xs, 3)",
+        "  append(xs, null)",
+        "  int x = pop(xs)",
+        "  resize(xs, 10)",
+        "  array int ys = new int[4]",
+        "  copy(ys, xs, 1, 3)",
+        "  array string zs = new string[0]",
+        "  append(zs, \"a\")",
+        "  string z = pop(zs)",
+        "}"
+      }));
+  SemanticChecker checker;
+  ASTParser(Lexer(in)).parse().accept(checker);
+}
+
+TEST(BasicSemanticCheckerTests, AppendNeedsElementType) {
+  stringstream in(build_string({
+        "void main() {",
+        "  array int xs = new int[0]",
+        "  append(xs, \"3\")",
+        "}"
+      }));
+  SemanticChecker checker;
+  try {
+    ASTParser(Lexer(in)).parse().accept(checker);
+    FAIL();
+  } catch(MyPLException& ex) {
+    string msg = ex.what();
+    ASSERT_TRUE(msg.starts_with("Static Error:"));
+  }
+}
+
+TEST(BasicSemanticCheckerTests, CopyNeedsSameArrayTypes) {
+  stringstream in(build_string({
+        "void main() {",
+        "  array int xs = new int[2]",
+        "  array double ys = new double[2]",
+        "  copy(xs, ys, 0, 2)",
+        "}"
+      }));
+  SemanticChecker checker;
+  try {
+    ASTParser(Lexer(in)).parse().accept(checker);
+    FAIL();
+  } catch(MyPLException& ex) {
+    string msg = ex.what();
+    ASSERT_TRUE(msg.starts_with("Static Error:"));
+  }
+}
+
+TEST(BasicSemanticCheckerTests, MapBuiltinsExample) {
+  stringstream in(build_string({
+        "struct Node {int val}",
+        "int count(map string int counts, string word) {",
+        "  if (map_has(counts, word)) {",
+        "    return map_get(counts, word)",
+        "  }",
+        "  return 0",
+        "}",
+        "void main() {",
+        "  map string int counts = new map string int",
+        "  map_put(counts, \"a\", count(counts, \"a\") + 1)",
+        "  map_put(counts, \"b\", null)",
+        "  map_remove(counts, \"a\")",
+        "  array string keys = map_keys(counts)",
+        "  map char Node nodes = new map char Node",
+        "  map_put(nodes, 'x', new Node)",
+        "  Node n = map_get(nodes, 'x')",
+        "}"
+      }));
+  SemanticChecker checker;
+  ASTParser(Lexer(in)).parse().accept(checker);
+}
+
+TEST(BasicSemanticCheckerTests, MapKeyTypeMismatch) {
+  stringstream in(build_string({
+        "void main() {",
+        "  map string int m = new map string int",
+        "  int x = map_get(m, 3)",
+        "}"
+      }));
+  SemanticChecker checker;
+  try {
+    ASTParser(Lexer(in)).parse().accept(checker);
+    FAIL();
+  } catch(MyPLException& ex) {
+    string msg = ex.what();
+    ASSERT_TRUE(msg.starts_with("Static Error:"));
+  }
+}
+
+TEST(BasicSemanticCheckerTests, MapTypesMustMatch) {
+  stringstream in(build_string({
+        "void main() {",
+        "  map string int m = new map string double",
+        "}"
+      }));
+  SemanticChecker checker;
+  try {
+    ASTParser(Lexer(in)).parse().accept(checker);
+    FAIL();
+  } catch(MyPLException& ex) {
+    string msg = ex.what();
+    ASSERT_TRUE(msg.starts_with("Static Error:"));
+  }
+}
+
+TEST(BasicSemanticCheckerTests, MapValueTypeMustExist) {
+  stringstream in(build_string({
+        "void main() {",
+        "  map int Node m = new map int Node",
+        "}"
+      }));
+  SemanticChecker checker;
+  try {
+    ASTParser(Lexer(in)).parse().accept(checker);
+    FAIL();
+  } catch(MyPLException& ex) {
+    string msg = ex.what();
+    ASSERT_TRUE(msg.starts_with("Static Error:"));
+  }
+}
+
 //----------------------------------------------------------------------
 // main
 //----------------------------------------------------------------------
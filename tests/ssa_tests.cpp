@@ -0,0 +1,476 @@
+//----------------------------------------------------------------------
+// FILE: ssa_tests.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: SSA construction, verification, printing, and lowering tests
+//----------------------------------------------------------------------
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "mypl_exception.h"
+#include "lexer.h"
+#include "ast_parser.h"
+#include "semantic_checker.h"
+#include "vm.h"
+#include "ssa_builder.h"
+#include "ssa_lowering.h"
+
+using namespace std;
+
+
+streambuf* stream_buffer;
+
+
+void change_cout(stringstream& out)
+{
+  stream_buffer = cout.rdbuf();
+  cout.rdbuf(out.rdbuf());
+}
+
+void restore_cout()
+{
+  cout.rdbuf(stream_buffer);
+}
+
+string build_string(initializer_list<string> strs)
+{
+  string result = "";
+  for (string s : strs)
+    result += s + "\n";
+  return result;
+}
+
+// check the program and build its ssa form (verifying each function)
+SSAProgram build(const string &src)
+{
+  stringstream in(src);
+  Program p = ASTParser(Lexer(in)).parse();
+  SemanticChecker checker;
+  p.accept(checker);
+  SSABuilder builder;
+  p.accept(builder);
+  for (const SSAFunction &f : builder.program().functions)
+    verify(f, builder.program());
+  return builder.program();
+}
+
+const SSAFunction &find_function(const SSAProgram &p, const string &name)
+{
+  for (const SSAFunction &f : p.functions)
+    if (f.name == name)
+      return f;
+  throw MyPLException("no function " + name);
+}
+
+int count_phis(const SSAFunction &f)
+{
+  int count = 0;
+  for (const SSABlock &block : f.blocks)
+    for (const SSAInstr &instr : block.instrs)
+      count += instr.kind == SSAKind::PHI;
+  return count;
+}
+
+// lower the program and run it, returning its output
+string run(const string &src)
+{
+  SSAProgram p = build(src);
+  VM vm;
+  SSALowering(p).lower(vm);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  return out.str();
+}
+
+//----------------------------------------------------------------------
+// Construction
+//----------------------------------------------------------------------
+
+TEST(SSABuilderTest, StraightLineCodeIsOneBlock) {
+  string src = build_string({
+      "int f(int x) {",
+      "  int y = x * 2",
+      "  y = y + 1",
+      "  return y",
+      "}",
+      "void main() {}"
+    });
+  SSAProgram p = build(src);
+  const SSAFunction &f = find_function(p, "f");
+  ASSERT_EQ(1, f.blocks.size());
+  EXPECT_EQ(0, count_phis(f));
+  EXPECT_EQ(SSATermKind::RETURN, f.blocks[0].term.kind);
+  EXPECT_EQ("int", f.param_types[0].type_name);
+  EXPECT_EQ("int", f.return_type.type_name);
+}
+
+TEST(SSABuilderTest, LoopVariablesGetHeaderPhis) {
+  string src = build_string({
+      "int sum(int n) {",
+      "  int s = 0",
+      "  int unchanged = 7",
+      "  for (int i = 0; i < n; i = i + 1) {",
+      "    s = s + i",
+      "  }",
+      "  return s + unchanged",
+      "}",
+      "void main() {}"
+    });
+  SSAProgram p = build(src);
+  const SSAFunction &f = find_function(p, "sum");
+  // s and i change in the loop, unchanged and n do not
+  EXPECT_EQ(2, count_phis(f));
+  // entry, header, body, exit
+  EXPECT_EQ(4, f.blocks.size());
+  EXPECT_EQ(SSAKind::PHI, f.blocks[1].instrs[0].kind);
+  EXPECT_EQ(2, f.blocks[1].preds.size());
+}
+
+TEST(SSABuilderTest, IfElseJoinsWithPhi) {
+  string src = build_string({
+      "int abs(int x) {",
+      "  int y = x",
+      "  if (x < 0) {y = 0 - x}",
+      "  elseif (x == 0) {y = 0}",
+      "  return y",
+      "}",
+      "void main() {}"
+    });
+  SSAProgram p = build(src);
+  const SSAFunction &f = find_function(p, "abs");
+  EXPECT_EQ(1, count_phis(f));
+  string ir = to_string(f);
+  EXPECT_NE(string::npos, ir.find("phi"));
+}
+
+TEST(SSABuilderTest, ShortCircuitJoinsWithPhi) {
+  string src = build_string({
+      "bool both(bool x, bool y) {",
+      "  return x and y",
+      "}",
+      "void main() {}"
+    });
+  SSAProgram p = build(src);
+  const SSAFunction &f = find_function(p, "both");
+  EXPECT_EQ(3, f.blocks.size());
+  EXPECT_EQ(1, count_phis(f));
+  EXPECT_EQ(SSATermKind::BRANCH, f.blocks[0].term.kind);
+}
+
+TEST(SSABuilderTest, UnreachableCodeIsRemoved) {
+  string src = build_string({
+      "int f(int x) {",
+      "  return x",
+      "  x = x + 1",
+      "  print(x)",
+      "}",
+      "void main() {}"
+    });
+  SSAProgram p = build(src);
+  const SSAFunction &f = find_function(p, "f");
+  ASSERT_EQ(1, f.blocks.size());
+  EXPECT_EQ(string::npos, to_string(f).find("WRITE"));
+}
+
+TEST(SSABuilderTest, FieldAndElementAccessesAreExplicit) {
+  string src = build_string({
+      "struct Node {int val, Node next}",
+      "void main() {",
+      "  Node n = new Node",
+      "  n.val = 3",
+      "  array int xs = new int[2]",
+      "  xs[1] = n.val",
+      "  print(xs[1])",
+      "}"
+    });
+  SSAProgram p = build(src);
+  string ir = to_string(p);
+  EXPECT_NE(string::npos, ir.find("struct Node {val: int, next: Node}"));
+  EXPECT_NE(string::npos, ir.find(": Node = new Node"));
+  EXPECT_NE(string::npos, ir.find("SETF(val)"));
+  EXPECT_NE(string::npos, ir.find(": int = GETF(val)"));
+  EXPECT_NE(string::npos, ir.find(": array int = ALLOCA"));
+  EXPECT_NE(string::npos, ir.find("SETI"));
+  EXPECT_NE(string::npos, ir.find(": int = GETI"));
+}
+
+TEST(SSABuilderTest, PrettyPrint) {
+  string src = build_string({
+      "int inc(int x) {",
+      "  return x + 1",
+      "}",
+      "void main() {}"
+    });
+  string expected = build_string({
+      "function inc(int) -> int",
+      "b0:",
+      "  %0: int = param 0",
+      "  %1: int = const 1",
+      "  %2: int = ADD %0 %1",
+      "  ret %2"
+    });
+  EXPECT_EQ(expected, to_string(find_function(build(src), "inc")));
+}
+
+//----------------------------------------------------------------------
+// Verifier
+//----------------------------------------------------------------------
+
+SSAFunction broken_function()
+{
+  // b0: %0 = param 0; br %0 b1 b2, b1: ret %0, b2: ret %0
+  SSAFunction f{"f"};
+  f.param_types = {DataType{false, "bool"}};
+  f.return_type = DataType{false, "bool"};
+  f.value_count = 1;
+  f.blocks = {SSABlock{0}, SSABlock{1}, SSABlock{2}};
+  f.blocks[0].instrs.push_back(SSAInstr{0, SSAKind::PARAM, OpCode::NOP, 0, {}, {}, DataType{false, "bool"}});
+  f.blocks[0].term = SSATerminator{SSATermKind::BRANCH, 0, {1, 2}};
+  f.blocks[1].term = SSATerminator{SSATermKind::RETURN, 0, {}};
+  f.blocks[1].preds = {0};
+  f.blocks[2].term = SSATerminator{SSATermKind::RETURN, 0, {}};
+  f.blocks[2].preds = {0};
+  return f;
+}
+
+TEST(SSAVerifierTest, WellFormedFunctionPasses) {
+  SSAProgram p;
+  EXPECT_NO_THROW(verify(broken_function(), p));
+}
+
+TEST(SSAVerifierTest, MissingTerminator) {
+  SSAProgram p;
+  SSAFunction f = broken_function();
+  f.blocks[2].term = SSATerminator{};
+  EXPECT_THROW(verify(f, p), MyPLException);
+}
+
+TEST(SSAVerifierTest, WrongPredecessors) {
+  SSAProgram p;
+  SSAFunction f = broken_function();
+  f.blocks[2].preds = {};
+  EXPECT_THROW(verify(f, p), MyPLException);
+}
+
+TEST(SSAVerifierTest, UseNotDominatedByDefinition) {
+  SSAProgram p;
+  SSAFunction f = broken_function();
+  f.value_count = 2;
+  f.blocks[1].instrs.push_back(SSAInstr{1, SSAKind::OP, OpCode::NOT, nullptr, {0}, {}, DataType{false, "bool"}});
+  f.blocks[2].term.value = 1;
+  EXPECT_THROW(verify(f, p), MyPLException);
+}
+
+TEST(SSAVerifierTest, PhiMustMatchPredecessors) {
+  SSAProgram p;
+  SSAFunction f = broken_function();
+  f.value_count = 2;
+  f.blocks[1].instrs.push_back(SSAInstr{1, SSAKind::PHI, OpCode::NOP, nullptr, {0, 0}, {0, 2}, DataType{false, "bool"}});
+  EXPECT_THROW(verify(f, p), MyPLException);
+}
+
+TEST(SSAVerifierTest, NonBoolBranchCondition) {
+  SSAProgram p;
+  SSAFunction f = broken_function();
+  f.blocks[0].instrs[0].type = DataType{false, "int"};
+  EXPECT_THROW(verify(f, p), MyPLException);
+}
+
+//----------------------------------------------------------------------
+// Lowering
+//----------------------------------------------------------------------
+
+TEST(SSALoweringTest, Recursion) {
+  string src = build_string({
+      "int fib(int n) {",
+      "  if (n < 2) {return n}",
+      "  return fib(n - 1) + fib(n - 2)",
+      "}",
+      "void main() {",
+      "  print(fib(15))",
+      "}"
+    });
+  EXPECT_EQ("610", run(src));
+}
+
+TEST(SSALoweringTest, LoopsOverArrays) {
+  string src = build_string({
+      "void main() {",
+      "  array int xs = new int[6]",
+      "  for (int i = 0; i < length_array(xs); i = i + 1) {xs[i] = i * i}",
+      "  int sum = 0",
+      "  int i = 0",
+      "  while (i < 6) {",
+      "    sum = sum + xs[i]",
+      "    i = i + 1",
+      "  }",
+      "  print(sum)",
+      "}"
+    });
+  EXPECT_EQ("55", run(src));
+}
+
+TEST(SSALoweringTest, SwappedVariablesUseParallelCopies) {
+  string src = build_string({
+      "void main() {",
+      "  int a = 0",
+      "  int b = 1",
+      "  for (int i = 0; i < 10; i = i + 1) {",
+      "    int t = a + b",
+      "    a = b",
+      "    b = t",
+      "  }",
+      "  print(a)",
+      "  print(\" \")",
+      "  print(b)",
+      "}"
+    });
+  EXPECT_EQ("55 89", run(src));
+}
+
+TEST(SSALoweringTest, ElseIfChains) {
+  string src = build_string({
+      "string sign(int x) {",
+      "  string s = \"\"",
+      "  if (x < 0) {s = \"neg\"}",
+      "  elseif (x == 0) {s = \"zero\"}",
+      "  elseif (x < 10) {s = \"small\"}",
+      "  else {s = \"big\"}",
+      "  return s",
+      "}",
+      "void main() {",
+      "  print(sign(0 - 3))",
+      "  print(sign(0))",
+      "  print(sign(4))",
+      "  print(sign(40))",
+      "}"
+    });
+  EXPECT_EQ("negzerosmallbig", run(src));
+}
+
+TEST(SSALoweringTest, LinkedStructs) {
+  string src = build_string({
+      "struct Node {int val, Node next}",
+      "void main() {",
+      "  Node head = null",
+      "  for (int i = 1; i <= 4; i = i + 1) {",
+      "    Node n = new Node",
+      "    n.val = i",
+      "    n.next = head",
+      "    head = n",
+      "  }",
+      "  int total = 0",
+      "  while (head != null) {",
+      "    total = (total * 10) + head.val",
+      "    head = head.next",
+      "  }",
+      "  print(total)",
+      "}"
+    });
+  EXPECT_EQ("4321", run(src));
+}
+
+TEST(SSALoweringTest, NestedLoopsAndStrings) {
+  string src = build_string({
+      "void main() {",
+      "  string s = \"\"",
+      "  for (int i = 0; i < 3; i = i + 1) {",
+      "    for (int j = 0; j <= i; j = j + 1) {",
+      "      s = concat(s, to_string(j))",
+      "    }",
+      "    s = concat(s, \"|\")",
+      "  }",
+      "  print(s)",
+      "  print(length(s))",
+      "}"
+    });
+  EXPECT_EQ("0|01|012|9", run(src));
+}
+
+TEST(SSALoweringTest, DiscardedCallResults) {
+  string src = build_string({
+      "int noisy(int x) {",
+      "  print(x)",
+      "  return x",
+      "}",
+      "void main() {",
+      "  noisy(1)",
+      "  noisy(2)",
+      "}"
+    });
+  EXPECT_EQ("12", run(src));
+}
+
+TEST(SSALoweringTest, ShortCircuitSkipsRest) {
+  string src = build_string({
+      "struct Node {int val, Node next}",
+      "bool noisy(bool x) {",
+      "  print(x)",
+      "  return x",
+      "}",
+      "void main() {",
+      "  bool x = noisy(false) and noisy(true)",
+      "  bool y = noisy(true) or noisy(false)",
+      "  Node n = null",
+      "  if ((n == null) or (n.val > 0)) {",
+      "    print(x or y)",
+      "  }",
+      "}"
+    });
+  EXPECT_EQ("falsetruetrue", run(src));
+}
+
+TEST(SSALoweringTest, DynamicArrays) {
+  string src = build_string({
+      "void main() {",
+      "  array double xs = new double[0]",
+      "  int i = 0",
+      "  while (i < 3) {",
+      "    append(xs, 0.5)",
+      "    i = i + 1",
+      "  }",
+      "  array double ys = new double[4]",
+      "  copy(ys, xs, 1, 3)",
+      "  print(pop(ys) + ys[1])",
+      "  resize(ys, 0)",
+      "  print(length_array(ys))",
+      "}"
+    });
+  EXPECT_EQ("1.0000000", run(src));
+}
+
+TEST(SSALoweringTest, Maps) {
+  string src = build_string({
+      "struct Node {int val}",
+      "void main() {",
+      "  map string Node nodes = new map string Node",
+      "  array string words = split(\"a b a\", ' ')",
+      "  for (int i = 0; i < length_array(words); i = i + 1) {",
+      "    if (not map_has(nodes, words[i])) {",
+      "      map_put(nodes, words[i], new Node)",
+      "    }",
+      "    Node n = map_get(nodes, words[i])",
+      "    n.val = i",
+      "  }",
+      "  Node a = map_get(nodes, \"a\")",
+      "  print(a.val)",
+      "  map_remove(nodes, \"a\")",
+      "  print(length_array(map_keys(nodes)))",
+      "}"
+    });
+  EXPECT_EQ("21", run(src));
+}
+
+//----------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,200 @@
+//----------------------------------------------------------------------
+// FILE: vm_profiler_tests.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: VM profiler tests
+//----------------------------------------------------------------------
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "mypl_exception.h"
+#include "vm.h"
+#include "vm_profiler.h"
+
+using namespace std;
+
+
+streambuf* stream_buffer;
+
+
+void change_cout(stringstream& out)
+{
+  stream_buffer = cout.rdbuf();
+  cout.rdbuf(out.rdbuf());
+}
+
+void restore_cout()
+{
+  cout.rdbuf(stream_buffer);
+}
+
+// main counts down from n, calling f(i) each time, and f(x) returns x
+// doubled
+VM count_down_vm(int n)
+{
+  VMFrameInfo f {"f", 1};
+  f.instructions.push_back(VMInstr::STORE(0));
+  f.instructions.push_back(VMInstr::LOAD(0));
+  f.instructions.push_back(VMInstr::PUSH(2));
+  f.instructions.push_back(VMInstr::MUL());
+  f.instructions.push_back(VMInstr::RET());
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(n));     // 0
+  main.instructions.push_back(VMInstr::STORE(0));    // 1
+  main.instructions.push_back(VMInstr::LOAD(0));     // 2
+  main.instructions.push_back(VMInstr::PUSH(0));     // 3
+  main.instructions.push_back(VMInstr::CMPGT());     // 4
+  main.instructions.push_back(VMInstr::JMPF(14));    // 5
+  main.instructions.push_back(VMInstr::LOAD(0));     // 6
+  main.instructions.push_back(VMInstr::CALL("f"));   // 7
+  main.instructions.push_back(VMInstr::POP());       // 8
+  main.instructions.push_back(VMInstr::LOAD(0));     // 9
+  main.instructions.push_back(VMInstr::PUSH(1));     // 10
+  main.instructions.push_back(VMInstr::SUB());       // 11
+  main.instructions.push_back(VMInstr::STORE(0));    // 12
+  main.instructions.push_back(VMInstr::JMP(2));      // 13
+  main.instructions.push_back(VMInstr::NOP());       // 14
+  VM vm;
+  vm.add(f);
+  vm.add(main);
+  return vm;
+}
+
+TEST(VMProfilerTest, CountsPerOpcode) {
+  VM vm = count_down_vm(10);
+  VMProfiler profiler;
+  vm.set_profiler(&profiler);
+  vm.run();
+  EXPECT_EQ(10, profiler.opcode(OpCode::CALL).count);
+  EXPECT_EQ(10, profiler.opcode(OpCode::MUL).count);
+  EXPECT_EQ(10, profiler.opcode(OpCode::RET).count);
+  EXPECT_EQ(11, profiler.opcode(OpCode::CMPGT).count);
+  EXPECT_EQ(0, profiler.opcode(OpCode::ADD).count);
+  // main: 3 + 11 * 4 + 10 * 8, f: 10 * 5
+  EXPECT_EQ(127 + 50, profiler.total().count);
+}
+
+TEST(VMProfilerTest, CountsPerFunctionAndPC) {
+  VM vm = count_down_vm(10);
+  VMProfiler profiler;
+  vm.set_profiler(&profiler);
+  vm.run();
+  const auto &functions = profiler.functions();
+  ASSERT_TRUE(functions.contains("main"));
+  ASSERT_TRUE(functions.contains("f"));
+  EXPECT_EQ(1, functions.at("main").calls);
+  EXPECT_EQ(10, functions.at("f").calls);
+  EXPECT_EQ(127, functions.at("main").total.count);
+  EXPECT_EQ(50, functions.at("f").total.count);
+  EXPECT_EQ(1, functions.at("main").pcs[0].count);
+  EXPECT_EQ(11, functions.at("main").pcs[2].count);
+  EXPECT_EQ(10, functions.at("main").pcs[13].count);
+  EXPECT_EQ(1, functions.at("main").pcs[14].count);
+  EXPECT_EQ(10, functions.at("f").pcs[3].count);
+}
+
+TEST(VMProfilerTest, TimesAddUp) {
+  VM vm = count_down_vm(100);
+  VMProfiler profiler;
+  vm.set_profiler(&profiler);
+  vm.run();
+  uint64_t by_function = 0;
+  for (const auto &[name, profile] : profiler.functions())
+  {
+    by_function += profile.total.ns;
+    uint64_t by_pc = 0;
+    for (const auto &counter : profile.pcs)
+      by_pc += counter.ns;
+    EXPECT_EQ(profile.total.ns, by_pc);
+  }
+  EXPECT_EQ(profiler.total().ns, by_function);
+  EXPECT_GT(profiler.total().ns, 0);
+}
+
+TEST(VMProfilerTest, ReportListsHottestFirst) {
+  VM vm = count_down_vm(10);
+  VMProfiler profiler;
+  vm.set_profiler(&profiler);
+  vm.run();
+  stringstream out;
+  profiler.report(out);
+  string report = out.str();
+  EXPECT_EQ(0, report.find("[Profile] 177 instructions"));
+  EXPECT_NE(string::npos, report.find("main"));
+  EXPECT_NE(string::npos, report.find("CALL"));
+  EXPECT_NE(string::npos, report.find("f@3 MUL()"));
+}
+
+TEST(VMProfilerTest, JsonOutput) {
+  VM vm = count_down_vm(3);
+  VMProfiler profiler;
+  vm.set_profiler(&profiler);
+  vm.run();
+  stringstream out;
+  profiler.write_json(out);
+  string json = out.str();
+  EXPECT_EQ(0, json.find("{\n  \"instructions\": "));
+  EXPECT_NE(string::npos, json.find("{\"opcode\": \"MUL\", \"count\": 3, "));
+  EXPECT_NE(string::npos, json.find("{\"name\": \"f\", \"calls\": 3, \"instructions\": 15, "));
+  EXPECT_NE(string::npos, json.find("{\"pc\": 7, \"instr\": \"CALL(f)\", \"count\": 3, "));
+  EXPECT_EQ("}\n", json.substr(json.size() - 2));
+}
+
+TEST(VMProfilerTest, TailCallsCountAsCalls) {
+  // f(n): if n == 0 return 0 else tail call f(n - 1)
+  VMFrameInfo f {"f", 1};
+  f.instructions.push_back(VMInstr::STORE(0));       // 0
+  f.instructions.push_back(VMInstr::LOAD(0));        // 1
+  f.instructions.push_back(VMInstr::PUSH(0));        // 2
+  f.instructions.push_back(VMInstr::CMPEQ());        // 3
+  f.instructions.push_back(VMInstr::JMPF(7));        // 4
+  f.instructions.push_back(VMInstr::PUSH(0));        // 5
+  f.instructions.push_back(VMInstr::RET());          // 6
+  f.instructions.push_back(VMInstr::LOAD(0));        // 7
+  f.instructions.push_back(VMInstr::PUSH(1));        // 8
+  f.instructions.push_back(VMInstr::SUB());          // 9
+  f.instructions.push_back(VMInstr::TAILCALL("f"));  // 10
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(5));
+  main.instructions.push_back(VMInstr::CALL("f"));
+  main.instructions.push_back(VMInstr::WRITE());
+  VM vm;
+  vm.add(f);
+  vm.add(main);
+  VMProfiler profiler;
+  vm.set_profiler(&profiler);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  EXPECT_EQ("0", out.str());
+  EXPECT_EQ(6, profiler.functions().at("f").calls);
+  EXPECT_EQ(5, profiler.opcode(OpCode::TAILCALL).count);
+  EXPECT_EQ(1, profiler.functions().at("main").pcs[2].count);
+}
+
+TEST(VMProfilerTest, StopsOnErrors) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(1));
+  main.instructions.push_back(VMInstr::PUSH(nullptr));
+  main.instructions.push_back(VMInstr::ADD());
+  VM vm;
+  vm.add(main);
+  VMProfiler profiler;
+  vm.set_profiler(&profiler);
+  EXPECT_THROW(vm.run(), MyPLException);
+  profiler.stop();
+  EXPECT_EQ(3, profiler.total().count);
+}
+
+//----------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
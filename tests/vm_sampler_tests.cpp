@@ -0,0 +1,116 @@
+//----------------------------------------------------------------------
+// FILE: vm_sampler_tests.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: VM sampling profiler tests
+//----------------------------------------------------------------------
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "mypl_exception.h"
+#include "vm.h"
+#include "vm_sampler.h"
+
+using namespace std;
+
+
+// main calls g(n), g calls f(n) and returns its result, and f counts
+// n down to zero
+VM nested_vm(int n)
+{
+  VMFrameInfo f {"f", 1};
+  f.instructions.push_back(VMInstr::STORE(0));       // 0
+  f.instructions.push_back(VMInstr::LOAD(0));        // 1
+  f.instructions.push_back(VMInstr::PUSH(0));        // 2
+  f.instructions.push_back(VMInstr::CMPGT());        // 3
+  f.instructions.push_back(VMInstr::JMPF(9));        // 4
+  f.instructions.push_back(VMInstr::LOAD(0));        // 5
+  f.instructions.push_back(VMInstr::PUSH(1));        // 6
+  f.instructions.push_back(VMInstr::SUB());          // 7
+  f.instructions.push_back(VMInstr::JMP(0));         // 8
+  f.instructions.push_back(VMInstr::LOAD(0));        // 9
+  f.instructions.push_back(VMInstr::RET());          // 10
+  VMFrameInfo g {"g", 1};
+  g.instructions.push_back(VMInstr::CALL("f"));
+  g.instructions.push_back(VMInstr::RET());
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(n));
+  main.instructions.push_back(VMInstr::CALL("g"));
+  main.instructions.push_back(VMInstr::POP());
+  VM vm;
+  vm.add(f);
+  vm.add(g);
+  vm.add(main);
+  return vm;
+}
+
+TEST(VMSamplerTest, SamplesEveryInstruction) {
+  VM vm = nested_vm(2);
+  VMSampler sampler;
+  sampler.set_instruction_interval(1);
+  vm.set_sampler(&sampler);
+  vm.run();
+  // f runs its loop 3 times (9, 9, then 7 instructions)
+  EXPECT_EQ(3, sampler.stacks().at("main"));
+  EXPECT_EQ(2, sampler.stacks().at("main;g"));
+  EXPECT_EQ(25, sampler.stacks().at("main;g;f"));
+  EXPECT_EQ(30, sampler.samples());
+}
+
+TEST(VMSamplerTest, SamplesEveryNthInstruction) {
+  VM vm = nested_vm(100);
+  VMSampler sampler;
+  sampler.set_instruction_interval(10);
+  vm.set_sampler(&sampler);
+  vm.run();
+  // 3 + 2 + 9 * 100 + 7 instructions, f from the 4th to the 910th
+  EXPECT_EQ(91, sampler.samples());
+  EXPECT_EQ(91, sampler.stacks().at("main;g;f"));
+}
+
+TEST(VMSamplerTest, FoldedOutput) {
+  VM vm = nested_vm(1);
+  VMSampler sampler;
+  sampler.set_instruction_interval(1);
+  vm.set_sampler(&sampler);
+  vm.run();
+  stringstream out;
+  sampler.write_folded(out);
+  EXPECT_EQ("main 3\nmain;g 2\nmain;g;f 16\n", out.str());
+}
+
+TEST(VMSamplerTest, TimerSamples) {
+  VM vm = nested_vm(200000);
+  VMSampler sampler(1000);
+  vm.set_sampler(&sampler);
+  vm.run();
+  EXPECT_GT(sampler.samples(), 0);
+  EXPECT_EQ(sampler.samples(), sampler.stacks().at("main;g;f"));
+}
+
+TEST(VMSamplerTest, SlowestRate) {
+  // a one second period does not fit in the timer's microseconds
+  VMSampler sampler(1);
+  EXPECT_NO_THROW(sampler.start());
+  sampler.stop();
+  VM vm = nested_vm(1000);
+  vm.set_sampler(&sampler);
+  EXPECT_NO_THROW(vm.run());
+}
+
+TEST(VMSamplerTest, BadRate) {
+  EXPECT_THROW(VMSampler(0), MyPLException);
+  EXPECT_THROW(VMSampler(-5), MyPLException);
+}
+
+//----------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
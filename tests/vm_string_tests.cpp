@@ -0,0 +1,134 @@
+//----------------------------------------------------------------------
+// FILE: vm_string_tests.cpp
+// DATE: CPSC 326, Spring 2023
+// AUTH: Parker Bixby
+// DESC: VM string value tests
+//----------------------------------------------------------------------
+
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "vm_string.h"
+
+using namespace std;
+
+
+TEST(VMStringTest, ShortStringsAreInline) {
+  VMString empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_TRUE(empty.is_inline());
+  VMString s = "hello world";
+  EXPECT_TRUE(s.is_inline());
+  EXPECT_EQ(11, s.size());
+  EXPECT_EQ("hello world", s.str());
+  EXPECT_EQ('w', s[6]);
+  EXPECT_EQ('\0', s.data()[11]);
+  EXPECT_TRUE(VMString(string(22, 'x')).is_inline());
+  EXPECT_FALSE(VMString(string(23, 'x')).is_inline());
+}
+
+TEST(VMStringTest, CopiesShareLongStrings) {
+  string text(100, 'a');
+  VMString s(text);
+  EXPECT_EQ(1, s.use_count());
+  {
+    VMString t = s;
+    VMString u;
+    u = t;
+    EXPECT_EQ(3, s.use_count());
+    EXPECT_EQ(s.data(), u.data());
+    VMString v = std::move(u);
+    EXPECT_EQ(3, s.use_count());
+    EXPECT_TRUE(u.empty());
+  }
+  EXPECT_EQ(1, s.use_count());
+  s = s;
+  EXPECT_EQ(text, s.str());
+}
+
+TEST(VMStringTest, InternSharesBuffers) {
+  string text = "a literal that is long enough to be shared";
+  VMString x = VMString::intern(text);
+  VMString y = VMString::intern(text);
+  EXPECT_EQ(x.data(), y.data());
+  EXPECT_NE(VMString(text).data(), x.data());
+  EXPECT_EQ(VMString(text), x);
+}
+
+TEST(VMStringTest, CompareAndConcat) {
+  VMString a = "abc";
+  VMString b = "abd";
+  EXPECT_TRUE(a < b);
+  EXPECT_TRUE(a != b);
+  EXPECT_TRUE(a == VMString("abc"));
+  VMString c = VMString::concat(a, string(30, 'z'));
+  EXPECT_EQ(33, c.size());
+  EXPECT_FALSE(c.is_inline());
+  EXPECT_EQ("abczz", c.str().substr(0, 5));
+  EXPECT_EQ("abcabd", VMString::concat(a, b).str());
+  stringstream out;
+  out << a << b;
+  EXPECT_EQ("abcabd", out.str());
+}
+
+TEST(VMStringTest, ConcatAppendsInPlace) {
+  VMString s = string(30, 'a');
+  VMString t = VMString::concat(s, "b");
+  // the first concat copies, leaving room to grow
+  EXPECT_NE(s.data(), t.data());
+  VMString u = VMString::concat(t, "c");
+  EXPECT_EQ(t.data(), u.data());
+  EXPECT_EQ(string(30, 'a') + "b", t.str());
+  EXPECT_EQ(string(30, 'a') + "bc", u.str());
+  // t no longer ends its buffer, so appending to it copies
+  VMString v = VMString::concat(t, "d");
+  EXPECT_NE(t.data(), v.data());
+  EXPECT_EQ(string(30, 'a') + "bd", v.str());
+  EXPECT_EQ(string(30, 'a') + "bc", u.str());
+  EXPECT_FALSE(t == u);
+  EXPECT_TRUE(t == VMString(string(30, 'a') + "b"));
+}
+
+TEST(VMStringTest, AccumulatingSharesOneBuffer) {
+  VMString s;
+  int buffers = 0;
+  const char *last = nullptr;
+  for (int i = 0; i < 100000; ++i) {
+    s = VMString::concat(s, "0123456789");
+    if (s.data() != last)
+      ++buffers;
+    last = s.data();
+  }
+  EXPECT_EQ(1000000, s.size());
+  EXPECT_EQ(1, s.use_count());
+  // the buffer grows geometrically
+  EXPECT_GT(40, buffers);
+}
+
+TEST(VMStringTest, SubstringsShareTheBuffer) {
+  VMString s = string(40, 'a') + string(40, 'b');
+  VMString t = s.substr(30, 30);
+  EXPECT_EQ(s.data() + 30, t.data());
+  EXPECT_EQ(string(10, 'a') + string(20, 'b'), t.str());
+  EXPECT_EQ(2, s.use_count());
+  // short substrings are copied inline
+  VMString u = s.substr(38, 4);
+  EXPECT_TRUE(u.is_inline());
+  EXPECT_EQ("aabb", u.str());
+  // a substring ending at the buffer's end can be appended to
+  VMString v = VMString::concat(s, "c").substr(50, 31);
+  VMString w = VMString::concat(v, "d");
+  EXPECT_EQ(v.data(), w.data());
+  EXPECT_EQ(string(30, 'b') + "cd", w.str());
+  EXPECT_TRUE(s.substr(0, 40) == VMString(string(40, 'a')));
+}
+
+//----------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -5,6 +5,9 @@
 // DESC: Basic vm tests
 //----------------------------------------------------------------------
 
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -1230,6 +1233,27 @@ TEST(BasicVMTest, JumpForward) {
   restore_cout();
 }
 
+TEST(BasicVMTest, SlotsStoredOutOfOrder) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH("blue"));
+  main.instructions.push_back(VMInstr::STORE(2));
+  main.instructions.push_back(VMInstr::PUSH("green"));
+  main.instructions.push_back(VMInstr::STORE(0));
+  main.instructions.push_back(VMInstr::LOAD(2));
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::WRITE());
+  VM vm;
+  vm.add(main);
+  // hand-built frames get a slot for every variable used
+  EXPECT_EQ(3, vm.frame("main").local_count);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  EXPECT_EQ("bluegreen", out.str());
+  restore_cout();
+}
+
 TEST(BasicVMTest, JumpFalseForward) {
   VMFrameInfo main {"main", 0};
   main.instructions.push_back(VMInstr::PUSH(false));
@@ -1264,6 +1288,25 @@ TEST(BasicVMTest, JumpFalseNoJump) {
   restore_cout();
 }
 
+TEST(BasicVMTest, JumpTrueForward) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(true));
+  main.instructions.push_back(VMInstr::JMPT(4));
+  main.instructions.push_back(VMInstr::PUSH("blue"));
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::PUSH(false));
+  main.instructions.push_back(VMInstr::JMPT(8));
+  main.instructions.push_back(VMInstr::PUSH("green"));
+  main.instructions.push_back(VMInstr::WRITE());
+  VM vm;
+  vm.add(main);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  EXPECT_EQ("green", out.str());
+  restore_cout();
+}
+
 TEST(BasicVMTest, JumpBackwards) {
   VMFrameInfo main {"main", 0};
   main.instructions.push_back(VMInstr::PUSH(0));       // 0
@@ -1415,6 +1458,38 @@ TEST(BasicVMTest, RecursiveSumFunction) {
   restore_cout();
 }
 
+TEST(BasicVMTest, TailRecursiveSumFunction) {
+  VMFrameInfo f {"sum", 2};
+  f.instructions.push_back(VMInstr::STORE(0));        // x -> var[0]
+  f.instructions.push_back(VMInstr::STORE(1));        // acc -> var[1]
+  f.instructions.push_back(VMInstr::LOAD(0));         // push x
+  f.instructions.push_back(VMInstr::PUSH(0));
+  f.instructions.push_back(VMInstr::CMPLE());         // x <= 0
+  f.instructions.push_back(VMInstr::JMPF(8));
+  f.instructions.push_back(VMInstr::LOAD(1));
+  f.instructions.push_back(VMInstr::RET());           // return acc
+  f.instructions.push_back(VMInstr::LOAD(0));
+  f.instructions.push_back(VMInstr::PUSH(1));
+  f.instructions.push_back(VMInstr::SUB());           // x - 1
+  f.instructions.push_back(VMInstr::LOAD(1));
+  f.instructions.push_back(VMInstr::LOAD(0));
+  f.instructions.push_back(VMInstr::ADD());           // acc + x
+  f.instructions.push_back(VMInstr::TAILCALL("sum")); // return sum(x-1, acc+x)
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(20000));
+  main.instructions.push_back(VMInstr::PUSH(0));
+  main.instructions.push_back(VMInstr::CALL("sum"));
+  main.instructions.push_back(VMInstr::WRITE());
+  VM vm;
+  vm.add(f);
+  vm.add(main);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  EXPECT_EQ("200010000", out.str());
+  restore_cout();
+}
+
 //----------------------------------------------------------------------
 // Heap-Related
 //----------------------------------------------------------------------
@@ -2062,6 +2137,40 @@ TEST(BasicVMTest, BadToIntFromString) {
   restore_cout();
 }
 
+TEST(BasicVMTest, ToIntFromPaddedString) {
+  VMFrameInfo main {"main", 0};                      
+  main.instructions.push_back(VMInstr::PUSH("  +42 apples"));
+  main.instructions.push_back(VMInstr::TOINT());
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::PUSH(" -7"));
+  main.instructions.push_back(VMInstr::TOINT());
+  main.instructions.push_back(VMInstr::WRITE());
+  VM vm;
+  vm.add(main);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  EXPECT_EQ("42-7", out.str());
+  restore_cout();
+}
+
+TEST(BasicVMTest, OutOfRangeToIntFromString) {
+  VMFrameInfo main {"main", 0};                      
+  main.instructions.push_back(VMInstr::PUSH("2147483648"));
+  main.instructions.push_back(VMInstr::TOINT());
+  VM vm;
+  vm.add(main);
+  try {
+    vm.run();
+    FAIL();
+  } catch(MyPLException& ex) {
+    string msg = string(ex.what());
+    string err = "VM Error: cannot convert string to int ";
+    err += "(in main at 1: TOINT())";
+    EXPECT_EQ(err, msg);
+  }
+}
+
 TEST(BasicVMTest, ToDoubleFromInt) {
   VMFrameInfo main {"main", 0};                      
   main.instructions.push_back(VMInstr::PUSH(3));
@@ -2090,6 +2199,23 @@ TEST(BasicVMTest, ToDoubleFromString) {
   restore_cout();
 }
 
+TEST(BasicVMTest, ToDoubleFromPaddedString) {
+  VMFrameInfo main {"main", 0};                      
+  main.instructions.push_back(VMInstr::PUSH("\t+2.5e1x"));
+  main.instructions.push_back(VMInstr::TODBL());
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::PUSH(" -0x10"));
+  main.instructions.push_back(VMInstr::TODBL());
+  main.instructions.push_back(VMInstr::WRITE());
+  VM vm;
+  vm.add(main);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  EXPECT_EQ("25.000000-16.000000", out.str());
+  restore_cout();
+}
+
 TEST(BasicVMTest, BadToDoubleFromString) {
   VMFrameInfo main {"main", 0};                      
   main.instructions.push_back(VMInstr::PUSH("bad double"));
@@ -2227,6 +2353,492 @@ TEST(BasicVMTest, NullConcatSecondOperand) {
   restore_cout();
 }
 
+TEST(BasicVMTest, CountsExecutedInstructions) {
+  VMFrameInfo f {"f", 1};
+  f.instructions.push_back(VMInstr::PUSH(1));
+  f.instructions.push_back(VMInstr::ADD());
+  f.instructions.push_back(VMInstr::RET());
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(1));
+  main.instructions.push_back(VMInstr::CALL("f"));
+  main.instructions.push_back(VMInstr::CALL("f"));
+  main.instructions.push_back(VMInstr::POP());
+  VM vm;
+  vm.add(f);
+  vm.add(main);
+  EXPECT_EQ(0, vm.instructions_executed());
+  vm.run();
+  EXPECT_EQ(10, vm.instructions_executed());
+}
+
+TEST(BasicVMTest, StatsCountHeapObjects) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::ALLOCS());
+  main.instructions.push_back(VMInstr::DUP());
+  main.instructions.push_back(VMInstr::ADDF("name"));
+  main.instructions.push_back(VMInstr::DUP());
+  main.instructions.push_back(VMInstr::PUSH("abcdefghij"));
+  main.instructions.push_back(VMInstr::SETF("name"));
+  main.instructions.push_back(VMInstr::POP());
+  main.instructions.push_back(VMInstr::PUSH(4));
+  main.instructions.push_back(VMInstr::PUSH("xy"));
+  main.instructions.push_back(VMInstr::ALLOCA());
+  main.instructions.push_back(VMInstr::POP());
+  VM vm;
+  vm.add(main);
+  EXPECT_EQ(0, vm.stats().struct_objects);
+  vm.run();
+  VMStats stats = vm.stats();
+  EXPECT_EQ(1, stats.struct_objects);
+  EXPECT_EQ(1, stats.array_objects);
+  EXPECT_LT(10 + 4, stats.struct_bytes);
+  EXPECT_LT(4 * (sizeof(VMValue) + 2), stats.array_bytes);
+  EXPECT_EQ(stats.struct_bytes + stats.array_bytes, stats.peak_heap_bytes);
+}
+
+TEST(BasicVMTest, StatsKeepHighWaterMark) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(1));
+  main.instructions.push_back(VMInstr::PUSH(""));
+  main.instructions.push_back(VMInstr::ALLOCA());
+  main.instructions.push_back(VMInstr::DUP());
+  main.instructions.push_back(VMInstr::PUSH(0));
+  main.instructions.push_back(VMInstr::PUSH(string(1000, 'a')));
+  main.instructions.push_back(VMInstr::SETI());
+  main.instructions.push_back(VMInstr::PUSH(0));
+  main.instructions.push_back(VMInstr::PUSH("a"));
+  main.instructions.push_back(VMInstr::SETI());
+  VM vm;
+  vm.add(main);
+  vm.run();
+  VMStats stats = vm.stats();
+  EXPECT_EQ(999, stats.peak_heap_bytes - stats.array_bytes);
+}
+
+TEST(BasicVMTest, StatsCountFramesAndStrings) {
+  VMFrameInfo f {"f", 1};
+  f.instructions.push_back(VMInstr::STORE(0));
+  f.instructions.push_back(VMInstr::PUSH("done"));
+  f.instructions.push_back(VMInstr::RET());
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH("hello"));
+  main.instructions.push_back(VMInstr::STORE(0));
+  main.instructions.push_back(VMInstr::PUSH(1));
+  main.instructions.push_back(VMInstr::CALL("f"));
+  main.instructions.push_back(VMInstr::PUSH(2));
+  main.instructions.push_back(VMInstr::CALL("f"));
+  VM vm;
+  vm.add(f);
+  vm.add(main);
+  vm.run();
+  VMStats stats = vm.stats();
+  EXPECT_EQ(3, stats.frames_allocated);
+  EXPECT_EQ(2, stats.max_call_depth);
+  EXPECT_LT(3 * sizeof(VMFrame), stats.frame_bytes);
+  // main is left holding the strings it did not consume
+  EXPECT_EQ(8, stats.operand_string_bytes);
+  EXPECT_EQ(5, stats.variable_string_bytes);
+}
+
+TEST(BasicVMTest, BufferedOutputMatchesToString) {
+  vector<VMValue> values = {0, -42, 2147483647, 3.5, -0.125, 1e20, 2.0 / 3,
+                            true, false, "text", nullptr};
+  stringstream out;
+  string expected = "";
+  {
+    VMOutput output(out, 8);
+    for (const VMValue &x : values)
+    {
+      output.write(x);
+      expected += to_string(x);
+    }
+  }
+  EXPECT_EQ(expected, out.str());
+}
+
+TEST(BasicVMTest, OutputIsFlushedOnErrors) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH("before"));
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::PUSH(nullptr));
+  main.instructions.push_back(VMInstr::PUSH(1));
+  main.instructions.push_back(VMInstr::ADD());
+  VM vm;
+  vm.add(main);
+  stringstream out;
+  change_cout(out);
+  EXPECT_THROW(vm.run(), MyPLException);
+  restore_cout();
+  EXPECT_EQ("before", out.str());
+}
+
+TEST(BasicVMTest, ReadMissingFile) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH("/no/such/mypl/file"));
+  main.instructions.push_back(VMInstr::READLNS());
+  VM vm;
+  vm.add(main);
+  try {
+    vm.run();
+    FAIL();
+  } catch(MyPLException& ex) {
+    string err = ex.what();
+    string msg = "VM Error: could not read file '/no/such/mypl/file' ";
+    msg += "(in main at 1: READLNS())";
+    EXPECT_EQ(msg, err);
+  }
+}
+
+TEST(BasicVMTest, MappedArrayIsReadOnly) {
+  string path = testing::TempDir() + "mypl_vm_mapped.bin";
+  int32_t values[] = {3, 4, 5};
+  ofstream file(path, ios::binary);
+  file.write(reinterpret_cast<const char *>(values), sizeof(values));
+  file.close();
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(path));
+  main.instructions.push_back(VMInstr::MAPI());
+  main.instructions.push_back(VMInstr::STORE(0));
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::ALEN());
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH(2));
+  main.instructions.push_back(VMInstr::GETI());
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH(0));
+  main.instructions.push_back(VMInstr::PUSH(9));
+  main.instructions.push_back(VMInstr::SETI());
+  VM vm;
+  vm.add(main);
+  stringstream out;
+  change_cout(out);
+  try {
+    vm.run();
+    FAIL();
+  } catch(MyPLException& ex) {
+    string err = ex.what();
+    string msg = "VM Error: cannot modify a read-only (mapped) array ";
+    msg += "(in main at 13: SETI())";
+    EXPECT_EQ(msg, err);
+  }
+  restore_cout();
+  EXPECT_EQ("35", out.str());
+  EXPECT_EQ(sizeof(values), vm.stats().mapped_bytes);
+  remove(path.c_str());
+}
+
+TEST(BasicVMTest, AppendAndPop) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(0));
+  main.instructions.push_back(VMInstr::PUSH(0));
+  main.instructions.push_back(VMInstr::ALLOCA());
+  main.instructions.push_back(VMInstr::STORE(0));
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH(7));
+  main.instructions.push_back(VMInstr::APPEND());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::APOP());
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::APOP());
+  VM vm;
+  vm.add(main);
+  stringstream out;
+  change_cout(out);
+  try {
+    vm.run();
+    FAIL();
+  } catch(MyPLException& ex) {
+    string err = ex.what();
+    string msg = "VM Error: cannot pop from an empty array ";
+    msg += "(in main at 11: APOP())";
+    EXPECT_EQ(msg, err);
+  }
+  restore_cout();
+  EXPECT_EQ("7", out.str());
+}
+
+TEST(BasicVMTest, CopyOutOfBounds) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(3));
+  main.instructions.push_back(VMInstr::PUSH(1));
+  main.instructions.push_back(VMInstr::ALLOCA());
+  main.instructions.push_back(VMInstr::STORE(0));
+  main.instructions.push_back(VMInstr::LOAD(0));     // dst
+  main.instructions.push_back(VMInstr::LOAD(0));     // src
+  main.instructions.push_back(VMInstr::PUSH(1));     // offset
+  main.instructions.push_back(VMInstr::PUSH(3));     // count
+  main.instructions.push_back(VMInstr::ACOPY());
+  VM vm;
+  vm.add(main);
+  try {
+    vm.run();
+    FAIL();
+  } catch(MyPLException& ex) {
+    string err = ex.what();
+    string msg = "VM Error: out-of-bounds array copy ";
+    msg += "(in main at 8: ACOPY())";
+    EXPECT_EQ(msg, err);
+  }
+}
+
+TEST(BasicVMTest, MapInstructions) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::ALLOCM("string"));
+  main.instructions.push_back(VMInstr::STORE(0));
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH("a"));
+  main.instructions.push_back(VMInstr::PUSH(1));
+  main.instructions.push_back(VMInstr::MPUT());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH("b"));
+  main.instructions.push_back(VMInstr::PUSH(2));
+  main.instructions.push_back(VMInstr::MPUT());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH("a"));
+  main.instructions.push_back(VMInstr::MDEL());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH("a"));
+  main.instructions.push_back(VMInstr::MHAS());
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH("a"));
+  main.instructions.push_back(VMInstr::MGET());
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH("b"));
+  main.instructions.push_back(VMInstr::MGET());
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::MKEYS());
+  main.instructions.push_back(VMInstr::DUP());
+  main.instructions.push_back(VMInstr::ALEN());
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::PUSH(0));
+  main.instructions.push_back(VMInstr::GETI());
+  main.instructions.push_back(VMInstr::WRITE());
+  VM vm;
+  vm.add(main);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  EXPECT_EQ("falsenull21b", out.str());
+  VMStats stats = vm.stats();
+  EXPECT_EQ(1, stats.map_objects);
+  EXPECT_LT(sizeof(VMMap), stats.map_bytes);
+  EXPECT_EQ(1, stats.array_objects);
+}
+
+TEST(BasicVMTest, MapNullKey) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::ALLOCM("int"));
+  main.instructions.push_back(VMInstr::PUSH(nullptr));
+  main.instructions.push_back(VMInstr::MGET());
+  VM vm;
+  vm.add(main);
+  try {
+    vm.run();
+    FAIL();
+  } catch(MyPLException& ex) {
+    string err = ex.what();
+    string msg = "VM Error: null reference (in main at 2: MGET())";
+    EXPECT_EQ(msg, err);
+  }
+}
+
+TEST(BasicVMTest, MapRemovalKeepsOtherKeys) {
+  // removals shift colliding keys back instead of leaving tombstones
+  VMMap map("int");
+  for (int i = 0; i < 1000; ++i)
+    map.put(i * 8) = i;
+  for (int i = 0; i < 1000; i += 3)
+    EXPECT_TRUE(map.remove(i * 8));
+  EXPECT_FALSE(map.remove(0));
+  EXPECT_EQ(666, map.size());
+  for (int i = 0; i < 1000; ++i)
+  {
+    const VMValue *value = map.find(i * 8);
+    if (i % 3 == 0)
+      EXPECT_EQ(nullptr, value);
+    else
+    {
+      ASSERT_NE(nullptr, value);
+      EXPECT_EQ(i, get<int>(*value));
+    }
+  }
+  EXPECT_EQ(nullptr, map.find(1));
+  EXPECT_EQ(666, map.keys().size());
+  map.put(0) = 5;
+  EXPECT_EQ(5, get<int>(*map.find(0)));
+  EXPECT_EQ(0, get<int>(map.keys().back()));
+}
+
+TEST(BasicVMTest, MapPartialElement) {
+  string path = testing::TempDir() + "mypl_vm_partial.bin";
+  ofstream file(path, ios::binary);
+  file << "abcdef";
+  file.close();
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(path));
+  main.instructions.push_back(VMInstr::MAPD());
+  VM vm;
+  vm.add(main);
+  try {
+    vm.run();
+    FAIL();
+  } catch(MyPLException& ex) {
+    string err = ex.what();
+    string msg = "VM Error: could not map file '" + path + "' as doubles ";
+    msg += "(in main at 1: MAPD())";
+    EXPECT_EQ(msg, err);
+  }
+  remove(path.c_str());
+}
+
+TEST(BasicVMTest, TypedArrayKeepsNullsAndValues) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(3));
+  main.instructions.push_back(VMInstr::PUSH(nullptr));
+  main.instructions.push_back(VMInstr::ALLOCA("int"));
+  main.instructions.push_back(VMInstr::STORE(0));
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH(1));
+  main.instructions.push_back(VMInstr::PUSH(-42));
+  main.instructions.push_back(VMInstr::SETI());
+  for (int i = 0; i < 3; ++i) {
+    main.instructions.push_back(VMInstr::LOAD(0));
+    main.instructions.push_back(VMInstr::PUSH(i));
+    main.instructions.push_back(VMInstr::GETI());
+    main.instructions.push_back(VMInstr::WRITE());
+  }
+  main.instructions.push_back(VMInstr::PUSH(2));
+  main.instructions.push_back(VMInstr::PUSH(nullptr));
+  main.instructions.push_back(VMInstr::ALLOCA("bool"));
+  main.instructions.push_back(VMInstr::DUP());
+  main.instructions.push_back(VMInstr::PUSH(0));
+  main.instructions.push_back(VMInstr::PUSH(true));
+  main.instructions.push_back(VMInstr::SETI());
+  main.instructions.push_back(VMInstr::PUSH(0));
+  main.instructions.push_back(VMInstr::GETI());
+  main.instructions.push_back(VMInstr::WRITE());
+  VM vm;
+  vm.add(main);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  EXPECT_EQ("null-42nulltrue", out.str());
+  // both arrays take less space than three boxed values
+  EXPECT_GT(2 * sizeof(VMArray) + 3 * sizeof(VMValue), vm.stats().array_bytes);
+}
+
+TEST(BasicVMTest, TypedArrayBoxesOtherValues) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(1000));
+  main.instructions.push_back(VMInstr::PUSH(nullptr));
+  main.instructions.push_back(VMInstr::ALLOCA("double"));
+  main.instructions.push_back(VMInstr::STORE(0));
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH(0));
+  main.instructions.push_back(VMInstr::PUSH(2.5));
+  main.instructions.push_back(VMInstr::SETI());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH(1));
+  main.instructions.push_back(VMInstr::PUSH("text"));
+  main.instructions.push_back(VMInstr::SETI());
+  for (int i = 0; i < 3; ++i) {
+    main.instructions.push_back(VMInstr::LOAD(0));
+    main.instructions.push_back(VMInstr::PUSH(i));
+    main.instructions.push_back(VMInstr::GETI());
+    main.instructions.push_back(VMInstr::WRITE());
+  }
+  VM vm;
+  vm.add(main);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  EXPECT_EQ("2.500000textnull", out.str());
+  VMStats stats = vm.stats();
+  EXPECT_LT(1000 * sizeof(VMValue), stats.array_bytes);
+  EXPECT_EQ(stats.peak_heap_bytes, stats.array_bytes);
+}
+
+TEST(BasicVMTest, CharValues) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH(1));
+  main.instructions.push_back(VMInstr::PUSH("a7c"));
+  main.instructions.push_back(VMInstr::GETC());
+  main.instructions.push_back(VMInstr::STORE(0));
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH('7'));
+  main.instructions.push_back(VMInstr::CMPEQ());
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::PUSH('8'));
+  main.instructions.push_back(VMInstr::CMPLT());
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::TOINT());
+  main.instructions.push_back(VMInstr::PUSH(1));
+  main.instructions.push_back(VMInstr::ADD());
+  main.instructions.push_back(VMInstr::WRITE());
+  main.instructions.push_back(VMInstr::LOAD(0));
+  main.instructions.push_back(VMInstr::TOSTR());
+  main.instructions.push_back(VMInstr::PUSH("!"));
+  main.instructions.push_back(VMInstr::CONCAT());
+  main.instructions.push_back(VMInstr::WRITE());
+  VM vm;
+  vm.add(main);
+  stringstream out;
+  change_cout(out);
+  vm.run();
+  restore_cout();
+  EXPECT_EQ("truetrue787!", out.str());
+}
+
+TEST(BasicVMTest, SubstringOutOfBounds) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH("blue"));
+  main.instructions.push_back(VMInstr::PUSH(2));
+  main.instructions.push_back(VMInstr::PUSH(3));
+  main.instructions.push_back(VMInstr::SUBSTR());
+  VM vm;
+  vm.add(main);
+  try {
+    vm.run();
+    FAIL();
+  } catch(MyPLException& ex) {
+    string err = ex.what();
+    string msg = "VM Error: out-of-bounds substring ";
+    msg += "(in main at 3: SUBSTR())";
+    EXPECT_EQ(msg, err);
+  }
+}
+
+TEST(BasicVMTest, SplitOnEmptySeparator) {
+  VMFrameInfo main {"main", 0};
+  main.instructions.push_back(VMInstr::PUSH("a,b"));
+  main.instructions.push_back(VMInstr::PUSH(""));
+  main.instructions.push_back(VMInstr::SPLIT());
+  VM vm;
+  vm.add(main);
+  try {
+    vm.run();
+    FAIL();
+  } catch(MyPLException& ex) {
+    string err = ex.what();
+    string msg = "VM Error: cannot split on an empty separator ";
+    msg += "(in main at 2: SPLIT())";
+    EXPECT_EQ(msg, err);
+  }
+}
+
 //----------------------------------------------------------------------
 // main
 //----------------------------------------------------------------------